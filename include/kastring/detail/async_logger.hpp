@@ -0,0 +1,591 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+#include "./format.hpp"
+#include "./format_template.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+namespace detail {
+// 记录在环形缓冲区中按 8 字节对齐
+inline std::size_t log_align8(std::size_t n) {
+    return (n + 7) & ~std::size_t(7);
+}
+
+// 负载读取游标, 与写入时的布局一一对应
+struct LogReader {
+    const char* p;
+};
+
+/**
+ * @brief 异步日志参数的二进制编码
+ *
+ * 可平凡复制的类型按值拷贝; 字符串拷贝内容, 读出时是指向记录内部的 KAStr
+ * 其他类型(需要深拷贝或有析构逻辑)不能延迟格式化, 编译期拒绝;
+ * 除 const char* / char* 外的指针也拒绝: 只拷贝指针本身, 后台格式化时所指内容可能已失效
+ */
+template <typename T, typename Enable = void>
+struct LogArgCodec {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "KAAsyncLogger: arguments must be trivially copyable or string-like");
+    static_assert(! std::is_pointer<T>::value,
+                  "KAAsyncLogger: pointer arguments are not captured by value; pass a KAStr or copy the pointee");
+
+    typedef T value_type;
+
+    static std::size_t size(const T& /*val*/) {
+        return log_align8(sizeof(T));
+    }
+
+    static char* encode(char* p, const T& val) {
+        std::memcpy(p, &val, sizeof(T));
+        return p + log_align8(sizeof(T));
+    }
+
+    static T decode(LogReader& r) {
+        T val;
+        std::memcpy(&val, r.p, sizeof(T));
+        r.p += log_align8(sizeof(T));
+        return val;
+    }
+};
+
+// 字符串: 8 字节长度 + 内容
+struct LogStrCodec {
+    typedef KAStr value_type;
+
+    static std::size_t size_of(std::size_t len) {
+        return 8 + log_align8(len);
+    }
+
+    static char* encode_bytes(char* p, const void* data, std::size_t len) {
+        const std::uint64_t n = len;
+        std::memcpy(p, &n, sizeof(n));
+        if (len > 0) std::memcpy(p + 8, data, len);
+        return p + size_of(len);
+    }
+
+    static KAStr decode(LogReader& r) {
+        std::uint64_t n;
+        std::memcpy(&n, r.p, sizeof(n));
+        const KAStr s(r.p + 8, static_cast<std::size_t>(n));
+        r.p += size_of(static_cast<std::size_t>(n));
+        return s;
+    }
+};
+
+template <typename T>
+struct LogArgCodec<T, typename std::enable_if<std::is_same<T, KAStr>::value || std::is_same<T, KAString>::value>::type>
+    : LogStrCodec {
+    static std::size_t size(const T& val) {
+        return size_of(val.byte_size());
+    }
+
+    static char* encode(char* p, const T& val) {
+        return encode_bytes(p, val.data(), val.byte_size());
+    }
+};
+
+template <>
+struct LogArgCodec<std::string> : LogStrCodec {
+    static std::size_t size(const std::string& val) {
+        return size_of(val.size());
+    }
+
+    static char* encode(char* p, const std::string& val) {
+        return encode_bytes(p, val.data(), val.size());
+    }
+};
+
+template <typename T>
+struct LogArgCodec<T, typename std::enable_if<std::is_same<T, const char*>::value || std::is_same<T, char*>::value
+                                              || (std::is_array<T>::value
+                                                  && std::is_same<typename std::remove_extent<T>::type, char>::value)>::type>
+    : LogStrCodec {
+    static std::size_t size(const char* val) {
+        return size_of(val == nullptr ? 0 : std::strlen(val));
+    }
+
+    static char* encode(char* p, const char* val) {
+        return encode_bytes(p, val, val == nullptr ? 0 : std::strlen(val));
+    }
+};
+
+// 具名参数: 名字连同结尾的 '\0' 一起拷贝, 值按其自身的编码
+template <typename V>
+struct LogNamedValue {
+    const char* name;
+    V value;
+};
+
+template <typename T>
+struct LogArgCodec<NamedArg<T> > {
+    typedef LogNamedValue<typename LogArgCodec<T>::value_type> value_type;
+
+    static std::size_t size(const NamedArg<T>& val) {
+        return LogStrCodec::size_of(std::strlen(val.name) + 1) + LogArgCodec<T>::size(val.value);
+    }
+
+    static char* encode(char* p, const NamedArg<T>& val) {
+        p = LogStrCodec::encode_bytes(p, val.name, std::strlen(val.name) + 1);
+        return LogArgCodec<T>::encode(p, val.value);
+    }
+
+    static value_type decode(LogReader& r) {
+        const KAStr name = LogStrCodec::decode(r);
+        const value_type v = {reinterpret_cast<const char*>(name.data()), LogArgCodec<T>::decode(r)};
+        return v;
+    }
+};
+
+// 解码后的值交给 fmt 之前, 具名参数还原成 NamedArg
+template <typename T>
+const T& log_arg_view(const T& val) {
+    return val;
+}
+
+template <typename V>
+NamedArg<V> log_arg_view(const LogNamedValue<V>& val) {
+    return NamedArg<V>{val.name, val.value};
+}
+
+inline std::size_t log_args_size() {
+    return 0;
+}
+
+template <typename T, typename... Rest>
+std::size_t log_args_size(const T& val, const Rest&... rest) {
+    return LogArgCodec<T>::size(val) + log_args_size(rest...);
+}
+
+inline char* log_args_encode(char* p) {
+    return p;
+}
+
+template <typename T, typename... Rest>
+char* log_args_encode(char* p, const T& val, const Rest&... rest) {
+    return log_args_encode(LogArgCodec<T>::encode(p, val), rest...);
+}
+
+// 按编码顺序解出全部参数; 花括号初始化保证从左到右求值
+template <typename... Args>
+struct LogArgTuple {
+    typedef std::tuple<typename LogArgCodec<Args>::value_type...> type;
+
+    static type decode(const char* payload) {
+        LogReader r = {payload};
+        (void)r;
+        return type{LogArgCodec<Args>::decode(r)...};
+    }
+};
+
+template <typename S, typename Tuple, std::size_t... Is>
+void log_format_static(KAString& out, const Tuple& vals, index_seq<Is...>) {
+    KAFormatString<S>().fmt_to(out, log_arg_view(std::get<Is>(vals))...);
+}
+
+template <typename Tuple, std::size_t... Is>
+void log_format_template(KAString& out, const KAFormatTemplate& t, const Tuple& vals, index_seq<Is...>) {
+    t.fmt_to(out, log_arg_view(std::get<Is>(vals))...);
+}
+} // namespace detail
+
+/**
+ * @brief 延迟格式化的异步日志
+ *
+ * 调用线程只把格式串(KA_FMT 或 KAFormatTemplate)和参数的二进制副本写入本线程独占的无锁环形缓冲区,
+ * 不格式化也不分配内存; 后台线程取出记录, 用 fmt 格式化并按批交给 writer
+ *
+ * - 每个记录输出为一行, 行尾自动加 '\n'
+ * - 参数必须可平凡复制或是字符串, 字符串内容会被拷贝进记录; 其他指针类型编译期拒绝
+ * - KAFormatTemplate 只保存指针, 在 flush() 之前必须保持存活
+ * - 缓冲区满时按 OverflowPolicy 丢弃或等待; 单条记录超过缓冲区一半时总是丢弃
+ * - 每个线程第一次写日志时分配自己的缓冲区; 线程退出且缓冲区输出完毕后由后台线程释放
+ */
+class KAAsyncLogger {
+  public:
+    typedef std::function<void(const KAStr&)> Writer;
+
+    enum OverflowPolicy {
+        DropWhenFull,
+        BlockWhenFull
+    };
+
+    enum : std::size_t {
+        DEFAULT_RING_BYTES = 1 << 20,
+        MIN_RING_BYTES = 4096,
+        BATCH_BYTES = 64 * 1024
+    };
+
+    explicit KAAsyncLogger(Writer writer, std::size_t ring_bytes = DEFAULT_RING_BYTES,
+                           OverflowPolicy policy = DropWhenFull)
+        : writer_(std::move(writer)), ring_bytes_(round_ring_bytes(ring_bytes)), policy_(policy), id_(next_id()),
+          rings_mtx_(), rings_(), mtx_(), wake_cv_(), done_cv_(), passes_(0), flush_until_(0), stop_(false),
+          dropped_(0), worker_() {
+        if (! writer_) throw std::invalid_argument("KAAsyncLogger: writer must not be empty");
+        worker_ = std::thread(&KAAsyncLogger::run, this);
+    }
+
+    // 写入 FILE*, 每批调用一次 fwrite + fflush
+    explicit KAAsyncLogger(std::FILE* file, std::size_t ring_bytes = DEFAULT_RING_BYTES,
+                           OverflowPolicy policy = DropWhenFull)
+        : KAAsyncLogger(file_writer(file), ring_bytes, policy) {}
+
+    KAAsyncLogger(const KAAsyncLogger&) = delete;
+    KAAsyncLogger& operator=(const KAAsyncLogger&) = delete;
+
+    // 输出所有已提交的记录后停止后台线程
+    ~KAAsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_.store(true, std::memory_order_release);
+        }
+        wake_cv_.notify_one();
+        worker_.join();
+        // 仍存活的线程还持有这些缓冲区的表项, 先释放内存, 表项由它们下次查找时清理
+        for (const std::shared_ptr<Ring>& r : rings_) {
+            r->buf.reset();
+            r->closed.store(true, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief 提交一条记录, 用法: logger.log(KA_FMT("{} took {}"), name, ms)
+     * @return 缓冲区已满而丢弃时返回 false
+     */
+    template <typename S, typename... Args>
+    bool log(const KAFormatString<S>& /*fmt*/, const Args&... args) {
+        static_assert(sizeof...(Args) == KAFormatString<S>::ARGS, "KAAsyncLogger::log(): argument count mismatch");
+        Ring& ring = local_ring();
+        char* p = reserve(ring, detail::log_args_size(args...));
+        if (p == nullptr) return false;
+        detail::log_args_encode(write_header(p, &format_static<S, Args...>), args...);
+        commit(ring);
+        return true;
+    }
+
+    // 运行期模板; t 必须活到记录被输出之后
+    template <typename... Args>
+    bool log(const KAFormatTemplate& t, const Args&... args) {
+        Ring& ring = local_ring();
+        char* p = reserve(ring, 8 + detail::log_args_size(args...));
+        if (p == nullptr) return false;
+        char* q = write_header(p, &format_template<Args...>);
+        const KAFormatTemplate* tp = &t;
+        std::memcpy(q, &tp, sizeof(tp));
+        detail::log_args_encode(q + 8, args...);
+        commit(ring);
+        return true;
+    }
+
+    // 阻塞到调用前提交的所有记录都已交给 writer
+    void flush() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        // passes_ 对应的一轮可能在调用前就已开始, 所以要等下一轮完整结束
+        const std::uint64_t target = passes_ + 2;
+        flush_until_ = std::max(flush_until_, target);
+        wake_cv_.notify_one();
+        done_cv_.wait(lock, [this, target]() { return passes_ >= target; });
+    }
+
+    // 因缓冲区满或记录过大而丢弃的记录数
+    std::size_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t ring_bytes() const {
+        return ring_bytes_;
+    }
+
+    // 持有缓冲区的线程数; 已退出且记录已输出的线程不计
+    std::size_t thread_count() const {
+        std::lock_guard<std::mutex> lock(rings_mtx_);
+        return rings_.size();
+    }
+
+  private:
+    typedef void (*RecordFn)(KAString& out, const char* payload);
+
+    // 记录头; fn 为空表示回绕标记, 跳到缓冲区起点继续读
+    struct Header {
+        std::uint64_t size; // 整条记录的字节数, 含记录头
+        RecordFn fn;
+    };
+
+    // 单生产者单消费者环形缓冲区; head / tail 单调递增, 分处不同缓存行
+    struct Ring {
+        explicit Ring(std::size_t cap_)
+            : buf(new char[cap_]), cap(cap_), head(0), pad0(), tail(0), pad1(), pending(0), orphaned(false),
+              closed(false) {}
+
+        std::unique_ptr<char[]> buf;
+        std::size_t cap;
+        std::atomic<std::size_t> head; // 生产者写
+        char pad0[64];
+        std::atomic<std::size_t> tail; // 消费者写
+        char pad1[64];
+        std::size_t pending; // reserve 与 commit 之间新的 head
+        std::atomic<bool> orphaned; // 所属线程已退出, head 不再变化
+        std::atomic<bool> closed; // logger 已析构
+    };
+
+    // 本线程在各 logger 中的缓冲区, 按 logger 的 id 查找; 线程退出时把它们全部标记为无主
+    struct LocalRings {
+        struct Entry {
+            std::uint64_t id;
+            std::shared_ptr<Ring> ring;
+        };
+
+        LocalRings() : entries() {}
+
+        ~LocalRings() {
+            for (const Entry& e : entries) e.ring->orphaned.store(true, std::memory_order_release);
+        }
+
+        std::vector<Entry> entries;
+    };
+
+    static std::size_t round_ring_bytes(std::size_t n) {
+        std::size_t cap = MIN_RING_BYTES;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id(0);
+        return ++id;
+    }
+
+    static Writer file_writer(std::FILE* file) {
+        if (file == nullptr) throw std::invalid_argument("KAAsyncLogger: file must not be null");
+        return [file](const KAStr& batch) {
+            std::fwrite(batch.data(), 1, batch.byte_size(), file);
+            std::fflush(file);
+        };
+    }
+
+    template <typename S, typename... Args>
+    static void format_static(KAString& out, const char* payload) {
+        typedef detail::LogArgTuple<Args...> Codec;
+        const typename Codec::type vals = Codec::decode(payload);
+        detail::log_format_static<S>(out, vals, typename make_index_seq<sizeof...(Args)>::type());
+    }
+
+    template <typename... Args>
+    static void format_template(KAString& out, const char* payload) {
+        const KAFormatTemplate* t;
+        std::memcpy(&t, payload, sizeof(t));
+        typedef detail::LogArgTuple<Args...> Codec;
+        const typename Codec::type vals = Codec::decode(payload + 8);
+        detail::log_format_template(out, *t, vals, typename make_index_seq<sizeof...(Args)>::type());
+    }
+
+    static char* write_header(char* p, RecordFn fn) {
+        std::memcpy(p + sizeof(std::uint64_t), &fn, sizeof(fn));
+        return p + sizeof(Header);
+    }
+
+    // 本线程的缓冲区; 在 thread_local 表中按 id 查找, 已有缓冲区时无锁
+    Ring& local_ring() {
+        static thread_local LocalRings local;
+        for (const LocalRings::Entry& e : local.entries) {
+            if (e.id == id_) return *e.ring;
+        }
+        return add_local_ring(local);
+    }
+
+    // 本线程第一次写这个 logger: 分配缓冲区并登记, 顺带清掉已析构 logger 的表项
+    Ring& add_local_ring(LocalRings& local) {
+        std::vector<LocalRings::Entry>& entries = local.entries;
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const LocalRings::Entry& e) {
+                                         return e.ring->closed.load(std::memory_order_acquire);
+                                     }),
+                      entries.end());
+
+        std::shared_ptr<Ring> ring = std::make_shared<Ring>(ring_bytes_);
+        {
+            std::lock_guard<std::mutex> lock(rings_mtx_);
+            rings_.push_back(ring);
+        }
+        const LocalRings::Entry e = {id_, ring};
+        entries.push_back(e);
+        return *ring;
+    }
+
+    // 预留一条负载为 payload 字节的记录, 写入长度后返回记录起点; 空间不足返回 nullptr
+    char* reserve(Ring& ring, std::size_t payload) {
+        const std::size_t size = sizeof(Header) + detail::log_align8(payload);
+        if (size > ring.cap / 2) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        const std::size_t head = ring.head.load(std::memory_order_relaxed);
+        const std::size_t off = head & (ring.cap - 1);
+        const std::size_t contiguous = ring.cap - off;
+        const std::size_t need = contiguous < size ? contiguous + size : size;
+        while (head + need - ring.tail.load(std::memory_order_acquire) > ring.cap) {
+            if (policy_ == DropWhenFull) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+
+        char* base = ring.buf.get();
+        char* p = base + off;
+        if (contiguous < size) {
+            // 尾部放不下, 写回绕标记后从头开始; 剩余不足一个记录头时读端会自行回绕
+            if (contiguous >= sizeof(Header)) {
+                const Header wrap = {contiguous, nullptr};
+                std::memcpy(p, &wrap, sizeof(wrap));
+            }
+            p = base;
+        }
+        const std::uint64_t n = size;
+        std::memcpy(p, &n, sizeof(n));
+        ring.pending = head + need;
+        return p;
+    }
+
+    void commit(Ring& ring) {
+        ring.head.store(ring.pending, std::memory_order_release);
+    }
+
+    // 取出 ring 中已提交的全部记录并格式化到 batch; 有记录时返回 true
+    bool drain(Ring& ring, KAString& batch) {
+        const std::size_t head = ring.head.load(std::memory_order_acquire);
+        std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (tail == head) return false;
+
+        const char* base = ring.buf.get();
+        while (tail != head) {
+            const std::size_t off = tail & (ring.cap - 1);
+            const std::size_t contiguous = ring.cap - off;
+            if (contiguous < sizeof(Header)) {
+                tail += contiguous;
+                continue;
+            }
+            Header h;
+            std::memcpy(&h, base + off, sizeof(h));
+            if (h.fn == nullptr) {
+                tail += contiguous;
+                continue;
+            }
+            const std::size_t mark = batch.byte_size();
+            try {
+                h.fn(batch, base + off + sizeof(Header));
+            } catch (const std::exception& e) {
+                batch.resize(mark); // 丢掉已输出的半条记录
+                batch.append("[log format error: ");
+                batch.append(e.what());
+                batch.append("]");
+            }
+            batch.append('\n');
+            tail += static_cast<std::size_t>(h.size);
+            ring.tail.store(tail, std::memory_order_release);
+            if (batch.byte_size() >= BATCH_BYTES) write_batch(batch);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+        return true;
+    }
+
+    void write_batch(KAString& batch) {
+        if (batch.empty()) return;
+        try {
+            writer_(batch.as_kastr());
+        } catch (...) {
+            // writer 的异常不能终止后台线程, 该批记录丢弃
+        }
+        batch.clear();
+    }
+
+    // 释放已无主且输出完毕的缓冲区; rings_ 只有后台线程会删除元素, 因此 rings 与它按下标对应
+    void reclaim(std::vector<Ring*>& rings) {
+        std::lock_guard<std::mutex> lock(rings_mtx_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<Ring>& r) {
+                                        return r->orphaned.load(std::memory_order_acquire)
+                                               && r->tail.load(std::memory_order_relaxed)
+                                                      == r->head.load(std::memory_order_relaxed);
+                                    }),
+                     rings_.end());
+        rings.clear();
+        for (const std::shared_ptr<Ring>& r : rings_) rings.push_back(r.get());
+    }
+
+    void run() {
+        std::vector<Ring*> rings;
+        KAString batch;
+        batch.reserve(BATCH_BYTES + 4096);
+        while (true) {
+            const bool stopping = stop_.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(rings_mtx_);
+                for (std::size_t i = rings.size(); i < rings_.size(); ++i) rings.push_back(rings_[i].get());
+            }
+
+            bool busy = false;
+            bool orphans = false;
+            for (Ring* ring : rings) {
+                // 先看到无主标记再取出, 这一轮就能取完它的全部记录
+                orphans = ring->orphaned.load(std::memory_order_acquire) || orphans;
+                busy = drain(*ring, batch) || busy;
+            }
+            write_batch(batch);
+            if (orphans) reclaim(rings);
+
+            std::unique_lock<std::mutex> lock(mtx_);
+            ++passes_;
+            done_cv_.notify_all();
+            if (stopping) break;
+            if (! busy) {
+                wake_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+                    return stop_.load(std::memory_order_acquire) || passes_ < flush_until_;
+                });
+            }
+        }
+    }
+
+    Writer writer_;
+    std::size_t ring_bytes_;
+    OverflowPolicy policy_;
+    std::uint64_t id_;
+
+    mutable std::mutex rings_mtx_;
+    std::vector<std::shared_ptr<Ring>> rings_; // 所属线程的 thread_local 表也持有一份
+
+    std::mutex mtx_; // 保护 passes_ / flush_until_
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t passes_; // 后台线程完成的轮数
+    std::uint64_t flush_until_;
+    std::atomic<bool> stop_;
+    std::atomic<std::size_t> dropped_;
+    std::thread worker_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
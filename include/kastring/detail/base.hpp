@@ -2,15 +2,30 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <array>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KASTRING_SSE2 1
+#endif
+
 #ifdef DBG_MACRO
 #define DBG_MACRO_NO_WARNING
 #include "../../../dbg.hpp" // IWYU pragma: export
 #endif
 
+// KASTRING_SSO_STATS 会改变 SSOBytes 及所有包含它的类型的布局, 因此用它选择内联命名空间:
+// 开关不一致的翻译单元之间传递这些类型时链接失败, 而不是在运行时用错分配器
+#ifdef KASTRING_SSO_STATS
+#define KASTRING_ABI_NAMESPACE abi_sso_stats
+#else
+#define KASTRING_ABI_NAMESPACE abi_v1
+#endif
+
 namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
 template <typename T>
 class span {
   public:
@@ -136,6 +151,43 @@ enum : std::size_t {
     knpos = static_cast<std::size_t>(-1)
 };
 
+// 256 位的字节集合, 用于分隔符等"属于某组字节之一"的判断, 每次查询是一次位测试
+class ByteSet {
+  public:
+    ByteSet() : bits_() {}
+
+    // 字符串中的每个字节都加入集合, 例如 ByteSet(",;\t")
+    ByteSet(const char* bytes) : bits_() {
+        for (; *bytes != '\0'; ++bytes) add(static_cast<Byte>(*bytes));
+    }
+
+    ByteSet(char c) : bits_() {
+        add(static_cast<Byte>(c));
+    }
+
+    ByteSet& add(Byte b) {
+        bits_[b >> 6] |= std::uint64_t(1) << (b & 63);
+        return *this;
+    }
+
+    bool contains(Byte b) const {
+        return (bits_[b >> 6] >> (b & 63)) & 1;
+    }
+
+    bool empty() const {
+        return (bits_[0] | bits_[1] | bits_[2] | bits_[3]) == 0;
+    }
+
+    ByteSet operator|(const ByteSet& other) const {
+        ByteSet r(*this);
+        for (std::size_t i = 0; i < 4; ++i) r.bits_[i] |= other.bits_[i];
+        return r;
+    }
+
+  private:
+    std::uint64_t bits_[4];
+};
+
 template <typename ByteRange>
 inline std::size_t fnv1a_hash(const ByteRange& r) {
     // 推荐方式：使用 FNV-1a 哈希
@@ -147,7 +199,119 @@ inline std::size_t fnv1a_hash(const ByteRange& r) {
     return h;
 }
 
+namespace detail {
+inline std::uint64_t load_u64(const Byte* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 读取不足 8 字节的尾部, 高位补 0
+inline std::uint64_t load_u64_tail(const Byte* p, std::size_t n) {
+    std::uint64_t v = 0;
+    if (n != 0) std::memcpy(&v, p, n);
+    return v;
+}
+
+// v 不能为 0
+inline std::size_t clz64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_clzll(v));
+#else
+    std::size_t n = 0;
+    while (! (v & 0x8000000000000000ull)) {
+        v <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// v 不能为 0
+inline std::size_t ctz64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(v));
+#else
+    std::size_t n = 0;
+    while (! (v & 1)) {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline std::size_t popcount64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcountll(v));
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<std::size_t>((v * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// 64 位的前缀异或: 结果第 i 位是 x 第 0..i 位的异或, 可以把引号位置展开成引号内的区间
+inline std::uint64_t prefix_xor64(std::uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// 64x64 -> 128 乘法, 返回低 64 位, 高 64 位写入 hi
+inline std::uint64_t umul128(std::uint64_t a, std::uint64_t b, std::uint64_t& hi) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 u128;
+    u128 r = static_cast<u128>(a) * b;
+    hi = static_cast<std::uint64_t>(r >> 64);
+    return static_cast<std::uint64_t>(r);
+#else
+    std::uint64_t ha = a >> 32, la = a & 0xffffffffull;
+    std::uint64_t hb = b >> 32, lb = b & 0xffffffffull;
+    std::uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    std::uint64_t mid = (ll >> 32) + (hl & 0xffffffffull) + (lh & 0xffffffffull);
+    hi = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+    return (ll & 0xffffffffull) | (mid << 32);
+#endif
+}
+
+// 64x64 -> 128 乘法后高低位异或折叠
+inline std::uint64_t hash_mum(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t hi;
+    const std::uint64_t lo = umul128(a, b, hi);
+    return lo ^ hi;
+}
+} // namespace detail
+
+// 一次处理 16 字节的快速哈希(wyhash 风格), 比 fnv1a 逐字节处理快得多
+// 结果只保证进程内稳定, 不要持久化
+inline std::uint64_t hash_bytes(const Byte* p, std::size_t n, std::uint64_t seed = 0) {
+    const std::uint64_t k0 = 0xa0761d6478bd642full, k1 = 0xe7037ed1a0b428dbull;
+    const std::uint64_t k2 = 0x8ebc6af09c88c6e3ull, k3 = 0x589965cc75374cc3ull;
+    std::uint64_t h = seed ^ detail::hash_mum(seed ^ k0, static_cast<std::uint64_t>(n) ^ k1);
+    while (n > 16) {
+        h = detail::hash_mum(detail::load_u64(p) ^ k1, detail::load_u64(p + 8) ^ h);
+        p += 16;
+        n -= 16;
+    }
+    std::uint64_t a, b;
+    if (n > 8) {
+        a = detail::load_u64(p);
+        b = detail::load_u64_tail(p + 8, n - 8);
+    } else {
+        a = detail::load_u64_tail(p, n);
+        b = 0;
+    }
+    return detail::hash_mum(k1 ^ n, detail::hash_mum(a ^ k2, b ^ h ^ k3));
+}
+
 class KAStr;
 class KAString;
 class StyledKAStr;
-} // namespace kstring
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
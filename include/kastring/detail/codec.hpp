@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+#include "./parse_int.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// base64 字母表: Standard 是 RFC 4648 第 4 节的 "+/", Url 是第 5 节的 "-_"
+enum class Base64Alphabet : unsigned char {
+    Standard,
+    Url
+};
+
+namespace detail {
+inline ParseResult<std::size_t> codec_result(ParseError err, std::size_t value, std::size_t consumed) {
+    ParseResult<std::size_t> r = {value, err, consumed};
+    return r;
+}
+
+inline const char* base64_chars(Base64Alphabet alphabet) {
+    return alphabet == Base64Alphabet::Url ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                           : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+}
+
+// base64 字符对应的 6 位值, 非法返回 255
+inline unsigned base64_value(Byte c, Base64Alphabet alphabet) {
+    if (c >= 'A' && c <= 'Z') return static_cast<unsigned>(c - 'A');
+    if (c >= 'a' && c <= 'z') return static_cast<unsigned>(c - 'a' + 26);
+    if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0' + 52);
+    const bool url = alphabet == Base64Alphabet::Url;
+    if (c == (url ? '-' : '+')) return 62;
+    if (c == (url ? '_' : '/')) return 63;
+    return 255;
+}
+
+#ifdef KASTRING_SSE2
+// 16 个十六进制字符转成 0..15, valid 的第 k 位表示第 k 个字符合法
+// 有符号比较 0 <= c - '0' < 10 在模 256 下恰好只接受 '0'..'9', 字母同理
+inline __m128i hex_decode16(__m128i c, unsigned& valid) {
+    const __m128i neg1 = _mm_set1_epi8(-1);
+    const __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(d, neg1), _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+    const __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(l, neg1), _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+    valid = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)));
+    return _mm_or_si128(_mm_and_si128(is_digit, d), _mm_and_si128(is_letter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+// 0..15 转成十六进制字符: 加 '0', 大于 9 的再加上到字母的距离
+inline __m128i hex_encode16(__m128i nibbles, __m128i letter_gap) {
+    const __m128i over9 = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), _mm_and_si128(over9, letter_gap));
+}
+
+// 0..63 转成 base64 字符: 按所在区间累加偏移, 不需要查表
+inline __m128i base64_encode16(__m128i idx, Base64Alphabet alphabet) {
+    const bool url = alphabet == Base64Alphabet::Url;
+    __m128i off = _mm_set1_epi8('A');
+    off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(25)), _mm_set1_epi8('a' - 26 - 'A')));
+    off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(51)), _mm_set1_epi8('0' - 52 - 'a' + 26)));
+    off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpeq_epi8(idx, _mm_set1_epi8(62)),
+                                          _mm_set1_epi8(static_cast<char>((url ? '-' : '+') - 62 - '0' + 52))));
+    off = _mm_add_epi8(off, _mm_and_si128(_mm_cmpeq_epi8(idx, _mm_set1_epi8(63)),
+                                          _mm_set1_epi8(static_cast<char>((url ? '_' : '/') - 63 - '0' + 52))));
+    return _mm_add_epi8(idx, off);
+}
+
+inline __m128i base64_in_range(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(c, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+// 16 个 base64 字符转成 6 位值; 0x80 以上的字节按有符号比较是负数, 不会落进任何区间
+inline __m128i base64_decode16(__m128i c, Base64Alphabet alphabet, unsigned& valid) {
+    const bool url = alphabet == Base64Alphabet::Url;
+    const __m128i upper = base64_in_range(c, 'A', 'Z');
+    const __m128i lower = base64_in_range(c, 'a', 'z');
+    const __m128i digit = base64_in_range(c, '0', '9');
+    const __m128i c62 = _mm_cmpeq_epi8(c, _mm_set1_epi8(url ? '-' : '+'));
+    const __m128i c63 = _mm_cmpeq_epi8(c, _mm_set1_epi8(url ? '_' : '/'));
+    valid = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, c62)), c63)));
+    const __m128i v = _mm_or_si128(_mm_and_si128(upper, _mm_sub_epi8(c, _mm_set1_epi8('A'))),
+                                   _mm_and_si128(lower, _mm_sub_epi8(c, _mm_set1_epi8('a' - 26))));
+    return _mm_or_si128(_mm_or_si128(v, _mm_and_si128(digit, _mm_add_epi8(c, _mm_set1_epi8(52 - '0')))),
+                        _mm_or_si128(_mm_and_si128(c62, _mm_set1_epi8(62)), _mm_and_si128(c63, _mm_set1_epi8(63))));
+}
+#endif
+} // namespace detail
+
+/**
+ * @brief 把 in 的每个字节写成两位十六进制, 追加到 out
+ *
+ * SSE2 下每次处理 16 字节: 拆出高低半字节, 比较加偏移得到字符, 再交错写出 32 个字符
+ */
+inline void hex_encode(KAString& out, const KAStr& in, bool upper = false) {
+    const Byte* p = in.data();
+    const std::size_t n = in.byte_size();
+    const std::size_t base = out.byte_size();
+    out.resize(base + 2 * n);
+    Byte* dst = out.data() + base;
+    std::size_t i = 0;
+#ifdef KASTRING_SSE2
+    const __m128i low4 = _mm_set1_epi8(0x0F);
+    const __m128i letter_gap = _mm_set1_epi8(static_cast<char>((upper ? 'A' : 'a') - '0' - 10));
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i hi = detail::hex_encode16(_mm_and_si128(_mm_srli_epi16(v, 4), low4), letter_gap);
+        const __m128i lo = detail::hex_encode16(_mm_and_si128(v, low4), letter_gap);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    for (; i < n; ++i) {
+        dst[2 * i] = static_cast<Byte>(digits[p[i] >> 4]);
+        dst[2 * i + 1] = static_cast<Byte>(digits[p[i] & 0x0F]);
+    }
+}
+
+/**
+ * @brief 把十六进制文本解码后追加到 out, 大小写都接受
+ *
+ * value 是追加的字节数; 出错时 consumed 是第一个不合法字符的位置(长度为奇数时是最后一个字符), out 保持原样
+ */
+inline ParseResult<std::size_t> hex_decode(KAString& out, const KAStr& in) {
+    const Byte* p = in.data();
+    const std::size_t n = in.byte_size();
+    const std::size_t base = out.byte_size();
+    out.resize(base + n / 2);
+    Byte* dst = out.data() + base;
+    std::size_t i = 0;
+#ifdef KASTRING_SSE2
+    const __m128i low8 = _mm_set1_epi16(0x00FF);
+    for (; i + 32 <= n; i += 32) {
+        unsigned valid_a, valid_b;
+        const __m128i a = detail::hex_decode16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), valid_a);
+        const __m128i b = detail::hex_decode16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 16)), valid_b);
+        if ((valid_a & valid_b) != 0xFFFF) break; // 交给下面的逐字节循环定位
+        // 每个 16 位里低字节是高半字节, 高字节是低半字节
+        const __m128i wa = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, low8), 4), _mm_srli_epi16(a, 8));
+        const __m128i wb = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, low8), 4), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i / 2), _mm_packus_epi16(wa, wb));
+    }
+#endif
+    for (; i + 2 <= n; i += 2) {
+        const unsigned hi = detail::parse_digit(p[i]);
+        const unsigned lo = detail::parse_digit(p[i + 1]);
+        if (hi >= 16 || lo >= 16) {
+            out.resize(base);
+            return detail::codec_result(ParseError::InvalidChar, 0, hi >= 16 ? i : i + 1);
+        }
+        dst[i / 2] = static_cast<Byte>(hi << 4 | lo);
+    }
+    if (i < n) {
+        out.resize(base);
+        return detail::codec_result(ParseError::InvalidChar, 0, i);
+    }
+    return detail::codec_result(ParseError::Ok, n / 2, n);
+}
+
+// n 字节编码后的 base64 长度
+inline std::size_t base64_encoded_size(std::size_t n, bool pad = true) {
+    return pad ? (n + 2) / 3 * 4 : n / 3 * 4 + (n % 3 == 0 ? 0 : n % 3 + 1);
+}
+
+/**
+ * @brief base64 编码后追加到 out; pad 为 false 时省略结尾的 '='
+ *
+ * SSE2 下每次读 12 字节: 用 32 位移位拆出 16 个 6 位值, 再按区间比较加偏移转成字符
+ */
+inline void base64_encode(KAString& out, const KAStr& in, Base64Alphabet alphabet = Base64Alphabet::Standard,
+                          bool pad = true) {
+    const Byte* p = in.data();
+    const std::size_t n = in.byte_size();
+    const std::size_t base = out.byte_size();
+    out.resize(base + base64_encoded_size(n, pad));
+    Byte* dst = out.data() + base;
+    std::size_t i = 0;
+#ifdef KASTRING_SSE2
+    // 第 k 个 32 位取第 3k 字节起的 3 个字节 b0 b1 b2 (左移 k 字节后挑出对应的 32 位), 再拆成四个 6 位值
+    // 每次读 16 字节只用前 12 个, 所以要求至少剩 16 字节
+    const __m128i lane0 = _mm_setr_epi32(-1, 0, 0, 0);
+    const __m128i lane1 = _mm_setr_epi32(0, -1, 0, 0);
+    const __m128i lane2 = _mm_setr_epi32(0, 0, -1, 0);
+    const __m128i lane3 = _mm_setr_epi32(0, 0, 0, -1);
+    for (; i + 16 <= n; i += 12) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i x01 = _mm_or_si128(_mm_and_si128(v, lane0), _mm_and_si128(_mm_slli_si128(v, 1), lane1));
+        const __m128i x23 =
+            _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 2), lane2), _mm_and_si128(_mm_slli_si128(v, 3), lane3));
+        const __m128i x = _mm_or_si128(x01, x23);
+        const __m128i s0 = _mm_and_si128(_mm_srli_epi32(x, 2), _mm_set1_epi32(0x3F));
+        const __m128i s1 = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(x, 12), _mm_set1_epi32(0x3000)),
+                                        _mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi32(0x0F00)));
+        const __m128i s2 = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(x, 10), _mm_set1_epi32(0x3C0000)),
+                                        _mm_and_si128(_mm_srli_epi32(x, 6), _mm_set1_epi32(0x030000)));
+        const __m128i s3 = _mm_and_si128(_mm_slli_epi32(x, 8), _mm_set1_epi32(0x3F000000));
+        const __m128i idx = _mm_or_si128(_mm_or_si128(s0, s1), _mm_or_si128(s2, s3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i / 3 * 4), detail::base64_encode16(idx, alphabet));
+    }
+#endif
+    const char* chars = detail::base64_chars(alphabet);
+    Byte* o = dst + i / 3 * 4;
+    for (; i + 3 <= n; i += 3) {
+        const std::uint32_t v = std::uint32_t(p[i]) << 16 | std::uint32_t(p[i + 1]) << 8 | p[i + 2];
+        o[0] = static_cast<Byte>(chars[v >> 18]);
+        o[1] = static_cast<Byte>(chars[v >> 12 & 0x3F]);
+        o[2] = static_cast<Byte>(chars[v >> 6 & 0x3F]);
+        o[3] = static_cast<Byte>(chars[v & 0x3F]);
+        o += 4;
+    }
+    if (i < n) {
+        const std::uint32_t v = std::uint32_t(p[i]) << 16 | (i + 1 < n ? std::uint32_t(p[i + 1]) << 8 : 0);
+        *o++ = static_cast<Byte>(chars[v >> 18]);
+        *o++ = static_cast<Byte>(chars[v >> 12 & 0x3F]);
+        if (i + 1 < n) {
+            *o++ = static_cast<Byte>(chars[v >> 6 & 0x3F]);
+        } else if (pad) {
+            *o++ = '=';
+        }
+        if (pad) *o++ = '=';
+    }
+}
+
+/**
+ * @brief base64 解码后追加到 out; 结尾的 '=' 可有可无, 有的话必须补齐到 4 的倍数
+ *
+ * 最后一组中没用到的低位必须为 0, 保证每个字节序列只有一种编码
+ * value 是追加的字节数; 出错时 consumed 是第一个不合法字符的位置, out 保持原样
+ */
+inline ParseResult<std::size_t> base64_decode(KAString& out, const KAStr& in,
+                                              Base64Alphabet alphabet = Base64Alphabet::Standard) {
+    const Byte* p = in.data();
+    const std::size_t n = in.byte_size();
+    std::size_t end = n;
+    if (n % 4 == 0 && n > 0 && p[n - 1] == '=') end = p[n - 2] == '=' ? n - 2 : n - 1;
+
+    const std::size_t base = out.byte_size();
+    // 多留 4 字节: SIMD 路径每组写 4 字节, 最后一个字节由下一组覆盖或在结尾截掉
+    out.resize(base + end / 4 * 3 + 4);
+    Byte* dst = out.data() + base;
+    std::size_t i = 0;
+#ifdef KASTRING_SSE2
+    const __m128i low8 = _mm_set1_epi16(0x00FF);
+    const __m128i low16 = _mm_set1_epi32(0xFFFF);
+    for (; i + 16 <= end; i += 16) {
+        unsigned valid;
+        const __m128i x =
+            detail::base64_decode16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), alphabet, valid);
+        if (valid != 0xFFFF) break;
+        // 两两合并成 12 位, 再合并成 24 位, 最后把大端的 3 字节换成内存顺序
+        const __m128i t = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(x, low8), 6), _mm_srli_epi16(x, 8));
+        const __m128i u = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(t, low16), 12), _mm_srli_epi32(t, 16));
+        const __m128i r = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(u, 16), _mm_set1_epi32(0xFF)),
+                                                    _mm_and_si128(u, _mm_set1_epi32(0xFF00))),
+                                       _mm_and_si128(_mm_slli_epi32(u, 16), _mm_set1_epi32(0xFF0000)));
+        std::uint32_t w[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(w), r);
+        Byte* o = dst + i / 4 * 3;
+        for (std::size_t k = 0; k < 4; ++k) std::memcpy(o + 3 * k, &w[k], 4);
+    }
+#endif
+    for (; i + 4 <= end; i += 4) {
+        const unsigned v[4] = {detail::base64_value(p[i], alphabet), detail::base64_value(p[i + 1], alphabet),
+                               detail::base64_value(p[i + 2], alphabet), detail::base64_value(p[i + 3], alphabet)};
+        for (std::size_t k = 0; k < 4; ++k) {
+            if (v[k] >= 64) {
+                out.resize(base);
+                return detail::codec_result(ParseError::InvalidChar, 0, i + k);
+            }
+        }
+        const std::uint32_t w = v[0] << 18 | v[1] << 12 | v[2] << 6 | v[3];
+        Byte* o = dst + i / 4 * 3;
+        o[0] = static_cast<Byte>(w >> 16);
+        o[1] = static_cast<Byte>(w >> 8);
+        o[2] = static_cast<Byte>(w);
+    }
+
+    // 最后不满 4 个的字符: 2 个解出 1 字节, 3 个解出 2 字节, 剩 1 个不能构成字节
+    std::size_t written = i / 4 * 3;
+    const std::size_t rest = end - i;
+    if (rest > 0) {
+        unsigned v[3] = {0, 0, 0};
+        for (std::size_t k = 0; k < rest; ++k) {
+            v[k] = detail::base64_value(p[i + k], alphabet);
+            if (v[k] >= 64) {
+                out.resize(base);
+                return detail::codec_result(ParseError::InvalidChar, 0, i + k);
+            }
+        }
+        const bool unused_bits = rest == 1 || (rest == 2 && (v[1] & 0x0F) != 0) || (rest == 3 && (v[2] & 0x03) != 0);
+        if (unused_bits) {
+            out.resize(base);
+            return detail::codec_result(ParseError::InvalidChar, 0, end - 1);
+        }
+        dst[written++] = static_cast<Byte>(v[0] << 2 | v[1] >> 4);
+        if (rest == 3) dst[written++] = static_cast<Byte>((v[1] & 0x0F) << 4 | v[2] >> 2);
+    }
+    out.resize(base + written);
+    return detail::codec_result(ParseError::Ok, written, n);
+}
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
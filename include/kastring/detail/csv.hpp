@@ -0,0 +1,378 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+class KACsvReader;
+class KACsvStreamReader;
+
+namespace detail {
+// 一行在缓冲区中的位置: [begin, end) 去掉了换行, seps 是行内 count - 1 个分隔符的索引项
+struct CsvRowSpan {
+    const std::size_t* seps;
+    std::size_t count;
+    std::size_t begin;
+    std::size_t end;
+};
+
+/**
+ * @brief RFC 4180 CSV 的字段边界索引与切行 (simdcsv 的做法)
+ *
+ * 每 64 字节一块, 用 SSE2 比较得到引号、分隔符、换行的位掩码, 引号掩码做前缀异或得到引号内区间,
+ * 去掉区间内的分隔符和换行后, 剩下的置位就是字段边界, 写入索引项 (offset << 1) | 是否换行
+ * 切行只需要在索引里找下一个换行, 行内的字段按需从相邻的索引项算出
+ * 结尾的 '\r' 会从行中去掉; 空行被跳过
+ */
+class CsvScanner {
+  public:
+    enum Status {
+        Row,
+        NeedMore, // 缓冲区里没有完整的一行, position() 是这一行的起点
+        End
+    };
+
+    enum : std::size_t {
+        BLOCK_BYTES = 64,
+        INDEX_BYTES = 64 * BLOCK_BYTES // 一次建立索引的字节数
+    };
+
+    CsvScanner(char delimiter, char quote)
+        : data_(nullptr), size_(0), pos_(0), scanned_(0), in_quote_(0), seps_(INDEX_BYTES), count_(0), head_(0),
+          delimiter_(static_cast<Byte>(delimiter)), quote_(static_cast<Byte>(quote)) {
+        if (delimiter == '\n' || delimiter == '\r' || delimiter == '\0' || delimiter == quote) {
+            throw std::invalid_argument("KACsvReader: invalid delimiter");
+        }
+    }
+
+    // data_ 只是借用的视图, 复制后指向同一缓冲区
+    CsvScanner(const CsvScanner&) = default;
+    CsvScanner& operator=(const CsvScanner&) = default;
+
+    void reset(const Byte* data, std::size_t size) {
+        data_ = data;
+        size_ = size;
+        pos_ = 0;
+        scanned_ = 0;
+        in_quote_ = 0;
+        count_ = 0;
+        head_ = 0;
+    }
+
+    std::size_t position() const {
+        return pos_;
+    }
+
+    // final 为 false 时缓冲区之后还有数据, 末尾没有换行的部分不算完整的一行
+    // 返回 Row 时 row 引用内部索引, 下一次调用后失效
+    Status next(CsvRowSpan& row, bool final) {
+        for (;;) {
+            std::size_t h = head_;
+            while (h < count_ && ! (seps_[h] & 1)) ++h;
+            if (h < count_) {
+                const std::size_t nl = seps_[h] >> 1;
+                const std::size_t begin = pos_;
+                const std::size_t end = nl > begin && data_[nl - 1] == '\r' ? nl - 1 : nl;
+                const std::size_t first = head_;
+                head_ = h + 1;
+                pos_ = nl + 1;
+                if (h == first && end == begin) continue;
+                row.seps = seps_.data() + first;
+                row.count = h - first + 1;
+                row.begin = begin;
+                row.end = end;
+                return Row;
+            }
+            if (scanned_ < size_) {
+                index();
+                continue;
+            }
+            if (! final) return NeedMore;
+            if (pos_ >= size_) return End;
+            // 没有换行结尾的最后一行, 与上面一样去掉结尾的 '\r' 并跳过空行
+            const std::size_t begin = pos_;
+            const std::size_t end = data_[size_ - 1] == '\r' ? size_ - 1 : size_;
+            const std::size_t first = head_;
+            head_ = count_;
+            pos_ = size_;
+            if (first == count_ && end == begin) return End;
+            row.seps = seps_.data() + first;
+            row.count = count_ - first + 1;
+            row.begin = begin;
+            row.end = end;
+            return Row;
+        }
+    }
+
+  private:
+    void classify(const Byte* p, std::uint64_t& quotes, std::uint64_t& seps, std::uint64_t& newlines) const {
+#ifdef KASTRING_SSE2
+        const __m128i q = _mm_set1_epi8(static_cast<char>(quote_));
+        const __m128i d = _mm_set1_epi8(static_cast<char>(delimiter_));
+        const __m128i nl = _mm_set1_epi8('\n');
+        quotes = 0;
+        seps = 0;
+        newlines = 0;
+        for (unsigned k = 0; k < BLOCK_BYTES / 16; ++k) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+            const __m128i is_nl = _mm_cmpeq_epi8(v, nl);
+            const std::uint64_t qm = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)));
+            const std::uint64_t nm = static_cast<unsigned>(_mm_movemask_epi8(is_nl));
+            const std::uint64_t sm =
+                static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, d), is_nl)));
+            quotes |= qm << (16 * k);
+            newlines |= nm << (16 * k);
+            seps |= sm << (16 * k);
+        }
+#else
+        quotes = 0;
+        seps = 0;
+        newlines = 0;
+        for (unsigned k = 0; k < BLOCK_BYTES; ++k) {
+            quotes |= static_cast<std::uint64_t>(p[k] == quote_) << k;
+            newlines |= static_cast<std::uint64_t>(p[k] == '\n') << k;
+            seps |= static_cast<std::uint64_t>(p[k] == delimiter_ || p[k] == '\n') << k;
+        }
+#endif
+        if (quote_ == '\0') quotes = 0;
+    }
+
+    // 为接下来至多 INDEX_BYTES 字节建立索引; 当前行已有的索引项移到开头, 保证一行的索引项总是连续的
+    void index() {
+        const std::size_t keep = count_ - head_;
+        if (keep != 0 && head_ != 0) std::memmove(seps_.data(), seps_.data() + head_, keep * sizeof(std::size_t));
+        count_ = keep;
+        head_ = 0;
+        if (seps_.size() < keep + INDEX_BYTES) seps_.resize(keep + INDEX_BYTES);
+
+        const std::size_t stop = scanned_ + INDEX_BYTES < size_ ? scanned_ + INDEX_BYTES : size_;
+        std::size_t* out = seps_.data() + count_;
+        while (scanned_ < stop) {
+            const std::size_t n = size_ - scanned_ < BLOCK_BYTES ? size_ - scanned_ : BLOCK_BYTES;
+            std::uint64_t quotes, seps, newlines;
+            if (n == BLOCK_BYTES) {
+                classify(data_ + scanned_, quotes, seps, newlines);
+            } else {
+                Byte tail[BLOCK_BYTES] = {};
+                std::memcpy(tail, data_ + scanned_, n);
+                classify(tail, quotes, seps, newlines);
+                const std::uint64_t valid = (std::uint64_t(1) << n) - 1;
+                quotes &= valid;
+                seps &= valid;
+            }
+            const std::uint64_t inside = prefix_xor64(quotes) ^ in_quote_;
+            in_quote_ = (inside >> 63) ? ~std::uint64_t(0) : 0;
+            seps &= ~inside;
+            while (seps) {
+                const std::size_t bit = ctz64(seps);
+                *out++ = ((scanned_ + bit) << 1) | ((newlines >> bit) & 1);
+                seps &= seps - 1;
+            }
+            scanned_ += n;
+        }
+        count_ = static_cast<std::size_t>(out - seps_.data());
+    }
+
+    const Byte* data_;
+    std::size_t size_;
+    std::size_t pos_;     // 当前行的起点
+    std::size_t scanned_; // 已建立索引的字节数
+    std::uint64_t in_quote_;
+    std::vector<std::size_t> seps_; // 索引项, 前 count_ 个有效, [head_, count_) 属于当前行及之后
+    std::size_t count_;
+    std::size_t head_;
+    Byte delimiter_;
+    Byte quote_;
+};
+} // namespace detail
+
+/**
+ * @brief CSV 的一行, 字段是指向输入缓冲区的 KAStr 视图, 不复制字节
+ *
+ * 行本身只引用读取器内部的字段边界索引, 取字段时才构造 KAStr; 下一次调用 next() 后失效
+ * operator[] 只去掉外层引号, 转义的 "" 保持原样; 需要真实内容时再调用 unescaped(), 只有这时才会复制
+ */
+class KACsvRow {
+  public:
+    KACsvRow() : data_(nullptr), span_(), quote_('"') {}
+
+    KACsvRow(const KACsvRow&) = default;
+    KACsvRow& operator=(const KACsvRow&) = default;
+
+    std::size_t size() const {
+        return span_.count;
+    }
+
+    bool empty() const {
+        return span_.count == 0;
+    }
+
+    // 原始字段, 带引号时包含外层引号
+    KAStr raw(std::size_t i) const {
+        if (i >= span_.count) throw std::out_of_range("KACsvRow::raw: index out of range");
+        const std::size_t begin = i == 0 ? span_.begin : (span_.seps[i - 1] >> 1) + 1;
+        const std::size_t end = i + 1 == span_.count ? span_.end : span_.seps[i] >> 1;
+        return KAStr(data_ + begin, end - begin);
+    }
+
+    KAStr operator[](std::size_t i) const {
+        const KAStr f = raw(i);
+        return is_quoted(f) ? f.subrange(1, f.byte_size() - 1) : f;
+    }
+
+    // 带引号且内部有转义的 "" 时为 true, 此时 operator[] 的结果与真实内容不同
+    bool needs_unescape(std::size_t i) const {
+        const KAStr f = raw(i);
+        return is_quoted(f) && std::memchr(f.data() + 1, quote_, f.byte_size() - 2) != nullptr;
+    }
+
+    KAString unescaped(std::size_t i) const {
+        KAString out;
+        unescape_to(i, out);
+        return out;
+    }
+
+    // 把去掉转义后的内容追加到 out
+    void unescape_to(std::size_t i, KAString& out) const {
+        const KAStr f = raw(i);
+        if (! is_quoted(f)) {
+            out.append(f);
+            return;
+        }
+        const char* p = reinterpret_cast<const char*>(f.data()) + 1;
+        const std::size_t n = f.byte_size() - 2;
+        std::size_t start = 0;
+        for (std::size_t k = 0; k < n; ++k) {
+            if (p[k] != quote_) continue;
+            out.append(p + start, k + 1 - start);
+            if (k + 1 < n && p[k + 1] == quote_) ++k;
+            start = k + 1;
+        }
+        out.append(p + start, n - start);
+    }
+
+  private:
+    friend class KACsvReader;
+    friend class KACsvStreamReader;
+
+    bool is_quoted(const KAStr& f) const {
+        const std::size_t n = f.byte_size();
+        return quote_ != '\0' && n >= 2 && f.data()[0] == static_cast<Byte>(quote_)
+               && f.data()[n - 1] == static_cast<Byte>(quote_);
+    }
+
+    const Byte* data_;
+    detail::CsvRowSpan span_;
+    char quote_;
+};
+
+/**
+ * @brief 内存中整块 CSV / TSV 的读取器, 产出的字段都指向 text, 不复制
+ *
+ * KACsvReader reader(text);
+ * KACsvRow row;
+ * while (reader.next(row)) use(row[0], row[1]);
+ *
+ * quote 为 '\0' 时不处理引号(例如纯 TSV); text 必须比 reader 和产出的 row 活得更久
+ */
+class KACsvReader {
+  public:
+    explicit KACsvReader(const KAStr& text, char delimiter = ',', char quote = '"')
+        : text_(text), scanner_(delimiter, quote), quote_(quote) {
+        scanner_.reset(text_.data(), text_.byte_size());
+    }
+
+    bool next(KACsvRow& row) {
+        row.quote_ = quote_;
+        row.data_ = text_.data();
+        return scanner_.next(row.span_, true) == detail::CsvScanner::Row;
+    }
+
+    // 下一行在 text 中的起始字节
+    std::size_t offset() const {
+        return scanner_.position();
+    }
+
+  private:
+    KAStr text_;
+    detail::CsvScanner scanner_;
+    char quote_;
+};
+
+/**
+ * @brief 分块读取的 CSV 读取器, 适用于文件或网络流
+ *
+ * 每次从 read 读入一块到内部缓冲区, 缓冲区末尾不完整的行会移到开头与下一块拼接; 一行比块大时缓冲区自动增长
+ * 产出的字段指向内部缓冲区, 只在下一次调用 next() 之前有效
+ */
+class KACsvStreamReader {
+  public:
+    // 最多读取 cap 字节到 buf, 返回实际读取的字节数, 返回 0 表示结束
+    typedef std::function<std::size_t(char*, std::size_t)> ReadFn;
+
+    enum : std::size_t {
+        DEFAULT_CHUNK_BYTES = 256 * 1024
+    };
+
+    explicit KACsvStreamReader(ReadFn read, char delimiter = ',', char quote = '"',
+                               std::size_t chunk_bytes = DEFAULT_CHUNK_BYTES)
+        : read_(std::move(read)), buf_(), size_(0), eof_(false), scanner_(delimiter, quote), quote_(quote),
+          chunk_bytes_(chunk_bytes) {
+        if (chunk_bytes_ == 0) throw std::invalid_argument("KACsvStreamReader: chunk_bytes must not be zero");
+    }
+
+    explicit KACsvStreamReader(std::FILE* fp, char delimiter = ',', char quote = '"',
+                               std::size_t chunk_bytes = DEFAULT_CHUNK_BYTES)
+        : KACsvStreamReader([fp](char* buf, std::size_t cap) { return std::fread(buf, 1, cap, fp); }, delimiter,
+                            quote, chunk_bytes) {}
+
+    // scanner_ 指向自己的缓冲区, 不能复制
+    KACsvStreamReader(const KACsvStreamReader&) = delete;
+    KACsvStreamReader& operator=(const KACsvStreamReader&) = delete;
+
+    bool next(KACsvRow& row) {
+        row.quote_ = quote_;
+        for (;;) {
+            const detail::CsvScanner::Status st = scanner_.next(row.span_, eof_);
+            if (st == detail::CsvScanner::Row) {
+                row.data_ = buf_.data();
+                return true;
+            }
+            if (st == detail::CsvScanner::End) return false;
+            refill(scanner_.position());
+        }
+    }
+
+  private:
+    // 保留 [keep, size_) 这段不完整的行, 再读入一块
+    void refill(std::size_t keep) {
+        if (keep < size_ && keep > 0) std::memmove(buf_.data(), buf_.data() + keep, size_ - keep);
+        size_ -= keep;
+        if (buf_.size() - size_ < chunk_bytes_) buf_.resize(size_ + chunk_bytes_);
+        const std::size_t got = read_(reinterpret_cast<char*>(buf_.data() + size_), buf_.size() - size_);
+        if (got == 0) eof_ = true;
+        size_ += got;
+        scanner_.reset(buf_.data(), size_);
+    }
+
+    ReadFn read_;
+    std::vector<Byte> buf_;
+    std::size_t size_;
+    bool eof_;
+    detail::CsvScanner scanner_;
+    char quote_;
+    std::size_t chunk_bytes_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./parse.hpp"
+#include "./timestamp.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// 定长字段的类型, 决定写入哪种列
+enum class FixedWidthType : unsigned char {
+    String,  // KAStr, 指向原缓冲区, 不复制
+    Int,     // std::int64_t
+    Decimal, // double, 结果正确舍入
+    Date     // std::int32_t, 1970-01-01 起的天数; 接受 "YYYYMMDD" 与 "YYYY-MM-DD"
+};
+
+// 切出字段后去掉哪一侧的空白
+enum class FixedWidthTrim : unsigned char {
+    None,
+    Left,
+    Right,
+    Both
+};
+
+namespace detail {
+inline ParseError fixed_width_parse_date(const Byte* p, std::size_t n, std::int32_t& days) {
+    if (n == 0) return ParseError::Empty;
+    Byte digits[8];
+    if (n == 8) {
+        std::memcpy(digits, p, 8);
+    } else if (n == 10 && p[4] == '-' && p[7] == '-') {
+        std::memcpy(digits, p, 4);
+        std::memcpy(digits + 4, p + 5, 2);
+        std::memcpy(digits + 6, p + 8, 2);
+    } else {
+        return ParseError::InvalidChar;
+    }
+    const std::uint64_t v = load_u64_le(digits);
+    if (! swar_is_eight_digits(v)) return ParseError::InvalidChar;
+    const std::uint32_t ymd = swar_parse_eight_digits(v);
+    const std::int64_t year = ymd / 10000;
+    const unsigned month = ymd / 100 % 100;
+    const unsigned day = ymd % 100;
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) return ParseError::InvalidChar;
+    days = static_cast<std::int32_t>(days_from_civil(year, month, day));
+    return ParseError::Ok;
+}
+} // namespace detail
+
+class KAFixedWidthSchema;
+
+// KAFixedWidthSchema::parse 的输出: 每个字段一列, 按字段类型取用, 各列长度都是 rows()
+class KAFixedWidthColumns {
+  public:
+    KAFixedWidthColumns() : rows_(0), types_(), slots_(), strings_(), ints_(), decimals_(), dates_() {}
+
+    std::size_t rows() const {
+        return rows_;
+    }
+
+    std::size_t field_count() const {
+        return types_.size();
+    }
+
+    FixedWidthType type(std::size_t field) const {
+        return types_.at(field);
+    }
+
+    // 字段类型不符时抛出 std::invalid_argument
+    const std::vector<KAStr>& strings(std::size_t field) const {
+        return strings_[slot(field, FixedWidthType::String)];
+    }
+
+    const std::vector<std::int64_t>& ints(std::size_t field) const {
+        return ints_[slot(field, FixedWidthType::Int)];
+    }
+
+    const std::vector<double>& decimals(std::size_t field) const {
+        return decimals_[slot(field, FixedWidthType::Decimal)];
+    }
+
+    const std::vector<std::int32_t>& dates(std::size_t field) const {
+        return dates_[slot(field, FixedWidthType::Date)];
+    }
+
+  private:
+    friend class KAFixedWidthSchema;
+
+    std::size_t slot(std::size_t field, FixedWidthType type) const {
+        if (field >= types_.size() || types_[field] != type) {
+            throw std::invalid_argument("KAFixedWidthColumns: field " + std::to_string(field)
+                                        + " is missing or has a different type");
+        }
+        return slots_[field];
+    }
+
+    std::size_t rows_;
+    std::vector<FixedWidthType> types_;
+    std::vector<std::size_t> slots_; // 字段在对应类型的列数组中的下标
+    std::vector<std::vector<KAStr> > strings_;
+    std::vector<std::vector<std::int64_t> > ints_;
+    std::vector<std::vector<double> > decimals_;
+    std::vector<std::vector<std::int32_t> > dates_;
+};
+
+/**
+ * @brief 定长记录的字段布局: 每个字段是记录内的 [offset, offset + width), 带有类型和去空白方式
+ *
+ * 例如 schema.add_field(0, 8, FixedWidthType::Int); schema.add_field(8, 20, FixedWidthType::String);
+ * 之后 schema.parse(text, cols) 一遍把所有记录解析成列; 字段切片只做边界检查, 数值在原缓冲区上就地转换
+ * record_size 为 0 时每行是一条记录("\r\n" 也可以, 行可以比字段短); 否则每条记录固定 record_size 字节(含换行符)
+ */
+class KAFixedWidthSchema {
+  public:
+    explicit KAFixedWidthSchema(std::size_t record_size = 0) : record_size_(record_size), fields_() {}
+
+    // 返回字段序号, 即它在输出中的列号
+    std::size_t add_field(std::size_t offset, std::size_t width, FixedWidthType type,
+                          FixedWidthTrim trim = FixedWidthTrim::Both) {
+        if (width == 0) throw std::invalid_argument("KAFixedWidthSchema::add_field(): width must be positive");
+        if (record_size_ != 0 && (offset >= record_size_ || width > record_size_ - offset)) {
+            throw std::invalid_argument("KAFixedWidthSchema::add_field(): field exceeds record size");
+        }
+        const Field f = {offset, width, type, trim};
+        fields_.push_back(f);
+        return fields_.size() - 1;
+    }
+
+    std::size_t field_count() const {
+        return fields_.size();
+    }
+
+    std::size_t record_size() const {
+        return record_size_;
+    }
+
+    /**
+     * @brief 解析 text 中的全部记录, 第 i 个字段写入 out 的第 i 列; out 原有的内容被替换
+     *
+     * 先数出记录数并一次性分配好各列, threads > 1 且记录足够多时按记录切段, 各线程直接写入自己那一段
+     * 字段超出记录末尾的部分视为空; 出错的数值字段写入 0 并记录在返回值中
+     * (row 是记录序号, column 是字段序号, offset 是去掉空白后字段在 text 中的起始字节)
+     * String 列中的 KAStr 指向 text, text 必须比 out 活得久
+     */
+    ColumnParseResult parse(const KAStr& text, KAFixedWidthColumns& out, std::size_t threads = 1) const {
+        const Byte* p = text.data();
+        const std::size_t n = text.byte_size();
+        const std::vector<Part> parts = record_size_ != 0 ? split_fixed(n, threads) : split_lines(p, n, threads);
+        const std::size_t rows = parts.back().first_row + parts.back().rows;
+
+        out = KAFixedWidthColumns();
+        out.rows_ = rows;
+        std::vector<Target> targets;
+        targets.reserve(fields_.size());
+        for (const Field& f : fields_) targets.push_back(add_column(out, f, rows));
+
+        std::vector<std::vector<ColumnError> > errors(parts.size());
+        std::vector<std::exception_ptr> failures(parts.size());
+        std::vector<std::thread> workers;
+        workers.reserve(parts.size() - 1);
+        auto work = [&](std::size_t i) {
+            try {
+                parse_part(p, parts[i], targets, errors[i]);
+            } catch (...) {
+                failures[i] = std::current_exception();
+            }
+        };
+        // 第 0 段由当前线程完成, 其余段各开一个线程
+        for (std::size_t i = 1; i < parts.size(); ++i) workers.emplace_back(work, i);
+        work(0);
+        for (std::thread& t : workers) t.join();
+        for (const std::exception_ptr& e : failures) {
+            if (e) std::rethrow_exception(e);
+        }
+
+        ColumnParseResult result = {rows, std::vector<ColumnError>()};
+        for (const std::vector<ColumnError>& e : errors) result.errors.insert(result.errors.end(), e.begin(), e.end());
+        return result;
+    }
+
+  private:
+    enum : std::size_t {
+        MIN_RECORDS_PER_THREAD = 4096, // 每个线程至少分到的记录数
+        MIN_BYTES_PER_THREAD = 1 << 18 // 按行切分时每个线程至少分到的字节数
+    };
+
+    struct Field {
+        std::size_t offset;
+        std::size_t width;
+        FixedWidthType type;
+        FixedWidthTrim trim;
+    };
+
+    // text 中 [begin, end) 的记录, 共 rows 条, 第一条的序号是 first_row
+    struct Part {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t first_row;
+        std::size_t rows;
+    };
+
+    // 字段与它的输出列; 列已按总记录数分配好, 按记录序号直接写入
+    struct Target {
+        Field field;
+        void* data;
+    };
+
+    static Target add_column(KAFixedWidthColumns& out, const Field& f, std::size_t rows) {
+        out.types_.push_back(f.type);
+        Target t = {f, nullptr};
+        switch (f.type) {
+        case FixedWidthType::String:
+            out.slots_.push_back(out.strings_.size());
+            out.strings_.push_back(std::vector<KAStr>(rows));
+            t.data = out.strings_.back().data();
+            break;
+        case FixedWidthType::Int:
+            out.slots_.push_back(out.ints_.size());
+            out.ints_.push_back(std::vector<std::int64_t>(rows));
+            t.data = out.ints_.back().data();
+            break;
+        case FixedWidthType::Decimal:
+            out.slots_.push_back(out.decimals_.size());
+            out.decimals_.push_back(std::vector<double>(rows));
+            t.data = out.decimals_.back().data();
+            break;
+        case FixedWidthType::Date:
+            out.slots_.push_back(out.dates_.size());
+            out.dates_.push_back(std::vector<std::int32_t>(rows));
+            t.data = out.dates_.back().data();
+            break;
+        }
+        return t;
+    }
+
+    std::vector<Part> split_fixed(std::size_t n, std::size_t threads) const {
+        const std::size_t rows = (n + record_size_ - 1) / record_size_;
+        const std::size_t count = std::max<std::size_t>(1, std::min(threads, rows / MIN_RECORDS_PER_THREAD));
+        const std::size_t chunk = (rows + count - 1) / count;
+        std::vector<Part> parts;
+        for (std::size_t first = 0; first < rows || parts.empty(); first += chunk) {
+            const std::size_t last = std::min(rows, first + chunk);
+            const Part part = {first * record_size_, std::min(n, last * record_size_), first, last - first};
+            parts.push_back(part);
+        }
+        return parts;
+    }
+
+    // 按字节均分后把分界点挪到下一行的开头, 再数出每段的行数
+    static std::vector<Part> split_lines(const Byte* p, std::size_t n, std::size_t threads) {
+        const std::size_t count = std::max<std::size_t>(1, std::min(threads, n / MIN_BYTES_PER_THREAD));
+        std::vector<Part> parts;
+        std::size_t begin = 0, first_row = 0;
+        for (std::size_t i = 1; i <= count; ++i) {
+            std::size_t end = i == count ? n : std::max(begin, n / count * i);
+            if (end < n) {
+                const void* nl = std::memchr(p + end, '\n', n - end);
+                end = nl == nullptr ? n : static_cast<std::size_t>(static_cast<const Byte*>(nl) - p) + 1;
+            }
+            std::size_t rows = 0;
+            for (std::size_t k = begin; k < end; ++rows) {
+                const void* nl = std::memchr(p + k, '\n', end - k);
+                k = nl == nullptr ? end : static_cast<std::size_t>(static_cast<const Byte*>(nl) - p) + 1;
+            }
+            const Part part = {begin, end, first_row, rows};
+            parts.push_back(part);
+            first_row += rows;
+            begin = end;
+        }
+        return parts;
+    }
+
+    void parse_part(const Byte* p, const Part& part, const std::vector<Target>& targets,
+                    std::vector<ColumnError>& errors) const {
+        std::size_t row = part.first_row;
+        if (record_size_ != 0) {
+            for (std::size_t rb = part.begin; rb < part.end; rb += record_size_, ++row) {
+                parse_record(p, rb, std::min(part.end, rb + record_size_), row, targets, errors);
+            }
+            return;
+        }
+        for (std::size_t rb = part.begin; rb < part.end; ++row) {
+            const void* nl = std::memchr(p + rb, '\n', part.end - rb);
+            const std::size_t le =
+                nl == nullptr ? part.end : static_cast<std::size_t>(static_cast<const Byte*>(nl) - p);
+            const std::size_t re = le > rb && p[le - 1] == '\r' ? le - 1 : le;
+            parse_record(p, rb, re, row, targets, errors);
+            rb = le + 1;
+        }
+    }
+
+    // 一条记录 p[rb, re) 的全部字段
+    static void parse_record(const Byte* p, std::size_t rb, std::size_t re, std::size_t row,
+                             const std::vector<Target>& targets, std::vector<ColumnError>& errors) {
+        const std::size_t len = re - rb;
+        for (std::size_t c = 0; c < targets.size(); ++c) {
+            const Field& f = targets[c].field;
+            std::size_t b = std::min(f.offset, len);
+            std::size_t e = f.width < len - b ? b + f.width : len;
+            if (f.trim == FixedWidthTrim::Left || f.trim == FixedWidthTrim::Both) {
+                while (b < e && detail::parse_is_space(p[rb + b])) ++b;
+            }
+            if (f.trim == FixedWidthTrim::Right || f.trim == FixedWidthTrim::Both) {
+                while (e > b && detail::parse_is_space(p[rb + e - 1])) --e;
+            }
+            const Byte* s = p + rb + b;
+            const std::size_t m = e - b;
+
+            ParseError error = ParseError::Ok;
+            switch (f.type) {
+            case FixedWidthType::String:
+                static_cast<KAStr*>(targets[c].data)[row] = KAStr(s, m);
+                break;
+            case FixedWidthType::Int: {
+                const ParseResult<std::int64_t> r = detail::parse_integer<std::int64_t>(s, m, 10, ParseMode::Strict);
+                error = r.error;
+                static_cast<std::int64_t*>(targets[c].data)[row] = r.ok() ? r.value : 0;
+                break;
+            }
+            case FixedWidthType::Decimal: {
+                const ParseResult<double> r = detail::parse_float<double>(s, m, ParseMode::Strict);
+                error = r.error;
+                static_cast<double*>(targets[c].data)[row] = r.ok() ? r.value : 0;
+                break;
+            }
+            case FixedWidthType::Date: {
+                std::int32_t days = 0;
+                error = detail::fixed_width_parse_date(s, m, days);
+                static_cast<std::int32_t*>(targets[c].data)[row] = days;
+                break;
+            }
+            }
+            if (error != ParseError::Ok) {
+                const ColumnError err = {row, c, rb + b, error};
+                errors.push_back(err);
+            }
+        }
+    }
+
+    std::size_t record_size_;
+    std::vector<Field> fields_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
@@ -0,0 +1,1562 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <ratio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <vector>
+
+#include "base.hpp"
+#include "kastr.hpp"
+#include "kastring.hpp"
+#include "float_to_chars.hpp"
+#include "timestamp.hpp"
+#include "to_chars.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+/**
+ * @brief 格式化的输出目标
+ *
+ * - FormatSink(out): 追加到 KAString
+ * - FormatSink(buf, cap): 写入定长缓冲区, 超出容量的部分被丢弃
+ * - FormatSink(): 只统计字节数
+ *
+ * size() 始终是完整输出的字节数, 与是否截断无关
+ */
+class FormatSink {
+  public:
+    FormatSink() : str_(nullptr), buf_(nullptr), cap_(0), size_(0) {}
+
+    explicit FormatSink(KAString& out) : str_(&out), buf_(nullptr), cap_(0), size_(0) {}
+
+    FormatSink(char* buf, std::size_t cap) : str_(nullptr), buf_(buf), cap_(buf == nullptr ? 0 : cap), size_(0) {}
+
+    FormatSink(const FormatSink&) = delete;
+    FormatSink& operator=(const FormatSink&) = delete;
+
+    void append(const char* ptr, std::size_t len) {
+        if (len == 0) return;
+        if (str_ != nullptr) {
+            str_->append(ptr, len);
+        } else if (size_ < cap_) {
+            std::memcpy(buf_ + size_, ptr, std::min(len, cap_ - size_));
+        }
+        size_ += len;
+    }
+
+    void append(const KAStr& str) {
+        append(reinterpret_cast<const char*>(str.data()), str.byte_size());
+    }
+
+    void push_back(char ch) {
+        if (str_ != nullptr) {
+            str_->append(ch);
+        } else if (size_ < cap_) {
+            buf_[size_] = ch;
+        }
+        ++size_;
+    }
+
+    // 写入 n 个 ch
+    void fill(char ch, std::size_t n) {
+        char chunk[64];
+        std::memset(chunk, ch, std::min(n, sizeof(chunk)));
+        while (n > 0) {
+            const std::size_t k = std::min(n, sizeof(chunk));
+            append(chunk, k);
+            n -= k;
+        }
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    // 实际落到输出里的字节数
+    std::size_t written() const {
+        if (str_ != nullptr) return size_;
+        return std::min(size_, cap_);
+    }
+
+    FormatResult result() const {
+        FormatResult r;
+        r.size = size_;
+        r.written = written();
+        return r;
+    }
+
+  private:
+    KAString* str_;
+    char* buf_;
+    std::size_t cap_;
+    std::size_t size_;
+};
+
+// 动态宽度/精度的来源
+enum : int {
+    SPEC_NO_ARG = -1,  // 没有动态值
+    SPEC_NEXT_ARG = -2 // "{}": 取下一个自动编号的参数; "{N}" 则直接记录序号 N
+};
+
+/**
+ * @brief 解析后的格式说明: [[fill]align][sign][#][0][width][.precision][type]
+ *
+ * width / precision 可以写成 "{}" 或 "{N}", 值取自对应的整数参数
+ */
+struct FormatSpec {
+    char fill;
+    char align; // '<' '>' '^', '\0' 表示按类型默认: 数字右对齐, 其余左对齐
+    char sign;  // '-' '+' ' '
+    bool alt;   // '#': 进制前缀, 浮点数保留小数点
+    bool zero;  // '0': 在符号和前缀之后补 0
+    int width;
+    int width_arg;
+    int precision; // -1 表示未指定
+    int precision_arg;
+    char type; // '\0' 表示默认
+
+    constexpr FormatSpec()
+        : fill(' '), align('\0'), sign('-'), alt(false), zero(false), width(0), width_arg(SPEC_NO_ARG), precision(-1),
+          precision_arg(SPEC_NO_ARG), type('\0') {}
+
+    constexpr FormatSpec(char fill_, char align_, char sign_, bool alt_, bool zero_, int width_, int width_arg_,
+                         int precision_, int precision_arg_, char type_)
+        : fill(fill_), align(align_), sign(sign_), alt(alt_), zero(zero_), width(width_), width_arg(width_arg_),
+          precision(precision_), precision_arg(precision_arg_), type(type_) {}
+};
+
+/**
+ * @brief 类型擦除后的格式化参数
+ *
+ * 常见类型直接保存值(整数记录原始字节数, 以便按补码输出十六进制), 其余类型保存指针和格式化函数;
+ * fmt 把全部参数放进一个 FormatArg 数组, 按序号 O(1) 取用
+ * 只引用原参数, 不能比原参数活得久
+ */
+class FormatArg {
+  public:
+    enum Kind : unsigned char {
+        None,
+        Bool,
+        SChar, // 有符号的字符类型, 默认按字符输出
+        UChar,
+        Int,
+        UInt,
+        Float,
+        Double,
+        Str,
+        Custom
+    };
+
+    typedef void (*CustomFn)(FormatSink&, const void*, const FormatSpec&);
+
+    struct StrValue {
+        const char* ptr;
+        std::size_t len;
+    };
+
+    struct CustomValue {
+        const void* ptr;
+        CustomFn fn;
+    };
+
+    union Value {
+        bool b;
+        std::int64_t i;
+        std::uint64_t u;
+        float f;
+        double d;
+        StrValue str;
+        CustomValue custom;
+    };
+
+    FormatArg() : kind(None), bytes(0), name(nullptr), name_len(0), value() {}
+
+    Kind kind;
+    unsigned char bytes; // 整数类型的 sizeof
+    const char* name;    // 具名参数的名字, 否则为 nullptr
+    std::size_t name_len;
+    Value value;
+};
+
+// 一次 fmt 调用的全部参数
+struct FormatArgs {
+    const FormatArg* args;
+    std::size_t count;
+};
+
+// 解析后的字段: 参数序号在解析时就已确定, width_arg / precision_arg 是参数序号或 SPEC_NO_ARG
+struct FormatField {
+    std::size_t name_begin; // 具名参数名在格式串中的位置
+    std::size_t name_len;   // 0 表示按 index 取参数
+    std::size_t index;
+    FormatSpec spec;
+};
+
+// 具名参数, 由 kastring::arg("name", value) 生成, 在格式串中用 "{name}" 引用; 同时也占一个位置序号
+template <typename T>
+struct NamedArg {
+    const char* name;
+    const T& value;
+};
+
+template <typename T>
+NamedArg<T> arg(const char* name, const T& value) {
+    return NamedArg<T>{name, value};
+}
+
+/**
+ * @brief 自定义类型的格式化入口, 在 kastring 命名空间内特化即可:
+ *
+ *     template <>
+ *     struct formatter<Point> : FormatterBase {
+ *         void format(const Point& p, FormatSink& sink) const { ... }
+ *     };
+ *
+ * parse(spec) 先收到字段解析后的 FormatSpec(动态宽度/精度已经取值), format(value, sink) 直接写入输出;
+ * 字符串、容器、pair、chrono 已有内置特化, 没有特化的类型才退回 operator<<
+ */
+template <typename T, typename Enable = void>
+struct formatter;
+
+// 保存 spec 的公共基类
+struct FormatterBase {
+    FormatterBase() : spec() {}
+
+    FormatSpec spec;
+
+    void parse(const FormatSpec& s) {
+        spec = s;
+    }
+};
+
+namespace {
+// 上报错误并返回错误字符串
+inline void format_error(const std::string& msg) {
+    throw std::invalid_argument(msg);
+}
+
+// spec 指 "{...}" 花括号内的部分, 如 "" 或 ":>8.3f"
+// 以下 constexpr 函数同时用于运行期 fmt 和编译期 KA_FMT, 两条路径接受同一套语法
+// spec_*_end 返回对应语法段结束的位置, 出错时返回 n + 1
+constexpr bool spec_is_align(char c) {
+    return c == '<' || c == '>' || c == '^';
+}
+
+constexpr bool spec_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool spec_is_type(char c) {
+    return c == 'd' || c == 'x' || c == 'X' || c == 'b' || c == 'B' || c == 'o' || c == 'c' || c == 's' || c == 'e'
+           || c == 'E' || c == 'f' || c == 'F' || c == 'g' || c == 'G';
+}
+
+constexpr std::size_t spec_digits_end(const char* p, std::size_t n, std::size_t i) {
+    return (i < n && spec_is_digit(p[i])) ? spec_digits_end(p, n, i + 1) : i;
+}
+
+// "{}" 或 "{N}" 的结束位置, 不是动态值时返回 i
+constexpr std::size_t spec_dynamic_end(const char* p, std::size_t n, std::size_t i) {
+    return (i < n && p[i] == '{' && spec_digits_end(p, n, i + 1) < n && p[spec_digits_end(p, n, i + 1)] == '}')
+               ? spec_digits_end(p, n, i + 1) + 1
+               : i;
+}
+
+constexpr bool spec_is_dynamic(const char* p, std::size_t n, std::size_t i) {
+    return spec_dynamic_end(p, n, i) != i;
+}
+
+constexpr std::size_t spec_align_end(const char* p, std::size_t n, std::size_t i) {
+    return (i + 1 < n && spec_is_align(p[i + 1]) && p[i] != '{' && p[i] != '}') ? i + 2
+           : (i < n && spec_is_align(p[i]))                                      ? i + 1
+                                                                                 : i;
+}
+
+constexpr std::size_t spec_sign_end(const char* p, std::size_t n, std::size_t i) {
+    return (i < n && (p[i] == '+' || p[i] == '-' || p[i] == ' ')) ? i + 1 : i;
+}
+
+constexpr std::size_t spec_char_end(const char* p, std::size_t n, std::size_t i, char c) {
+    return (i < n && p[i] == c) ? i + 1 : i;
+}
+
+// 宽度或精度: 数字, 或动态的 "{}"
+constexpr std::size_t spec_count_end(const char* p, std::size_t n, std::size_t i) {
+    return spec_is_dynamic(p, n, i) ? spec_dynamic_end(p, n, i) : spec_digits_end(p, n, i);
+}
+
+// '.' 之后必须有数字或 "{}"
+constexpr std::size_t spec_precision_end(const char* p, std::size_t n, std::size_t i) {
+    return (i < n && p[i] == '.') ? (spec_count_end(p, n, i + 1) == i + 1 ? n + 1 : spec_count_end(p, n, i + 1)) : i;
+}
+
+constexpr std::size_t spec_type_end(const char* p, std::size_t n, std::size_t i) {
+    return (i < n && spec_is_type(p[i])) ? i + 1 : i;
+}
+
+// 各语法段依次结束的位置, p[0] 是 ':'
+constexpr std::size_t spec_pos_align(const char* p, std::size_t n) {
+    return spec_align_end(p, n, 1);
+}
+
+constexpr std::size_t spec_pos_sign(const char* p, std::size_t n) {
+    return spec_sign_end(p, n, spec_pos_align(p, n));
+}
+
+constexpr std::size_t spec_pos_alt(const char* p, std::size_t n) {
+    return spec_char_end(p, n, spec_pos_sign(p, n), '#');
+}
+
+constexpr std::size_t spec_pos_zero(const char* p, std::size_t n) {
+    return spec_char_end(p, n, spec_pos_alt(p, n), '0');
+}
+
+constexpr std::size_t spec_pos_width(const char* p, std::size_t n) {
+    return spec_count_end(p, n, spec_pos_zero(p, n));
+}
+
+constexpr std::size_t spec_pos_precision(const char* p, std::size_t n) {
+    return spec_precision_end(p, n, spec_pos_width(p, n));
+}
+
+constexpr std::size_t spec_pos_type(const char* p, std::size_t n) {
+    return spec_type_end(p, n, spec_pos_precision(p, n));
+}
+
+// 过大的数值饱和在 10 亿左右, 不会溢出
+constexpr int spec_number(const char* p, std::size_t i, std::size_t end, int acc) {
+    return i >= end ? acc : spec_number(p, i + 1, end, acc >= 100000000 ? acc : acc * 10 + (p[i] - '0'));
+}
+
+// 从 i 开始的宽度或精度: 动态时返回 SPEC_NEXT_ARG 或参数序号, 否则返回 SPEC_NO_ARG
+constexpr int spec_count_arg(const char* p, std::size_t n, std::size_t i) {
+    return ! spec_is_dynamic(p, n, i)             ? int(SPEC_NO_ARG)
+           : spec_dynamic_end(p, n, i) == i + 2 ? int(SPEC_NEXT_ARG)
+                                                : spec_number(p, i + 1, spec_dynamic_end(p, n, i) - 1, 0);
+}
+
+constexpr bool spec_valid(const char* p, std::size_t n) {
+    return n == 0 || (p[0] == ':' && spec_pos_type(p, n) == n);
+}
+
+constexpr FormatSpec spec_parse(const char* p, std::size_t n) {
+    return n == 0 ? FormatSpec()
+                  : FormatSpec(spec_pos_align(p, n) == 3 ? p[1] : ' ',
+                               spec_pos_align(p, n) > 1 ? p[spec_pos_align(p, n) - 1] : '\0',
+                               spec_pos_sign(p, n) > spec_pos_align(p, n) ? p[spec_pos_align(p, n)] : '-',
+                               spec_pos_alt(p, n) > spec_pos_sign(p, n), spec_pos_zero(p, n) > spec_pos_alt(p, n),
+                               spec_is_dynamic(p, n, spec_pos_zero(p, n))
+                                   ? 0
+                                   : spec_number(p, spec_pos_zero(p, n), spec_pos_width(p, n), 0),
+                               spec_count_arg(p, n, spec_pos_zero(p, n)),
+                               spec_pos_precision(p, n) == spec_pos_width(p, n)        ? -1
+                               : spec_is_dynamic(p, n, spec_pos_width(p, n) + 1) ? 0
+                                   : spec_number(p, spec_pos_width(p, n) + 1, spec_pos_precision(p, n), 0),
+                               spec_pos_precision(p, n) == spec_pos_width(p, n)
+                                   ? int(SPEC_NO_ARG)
+                                   : spec_count_arg(p, n, spec_pos_width(p, n) + 1),
+                               spec_pos_type(p, n) > spec_pos_precision(p, n) ? p[spec_pos_precision(p, n)] : '\0');
+}
+
+// 字段需要额外消耗的参数个数(动态宽度/精度)
+constexpr std::size_t spec_dynamic_args(const char* p, std::size_t n) {
+    return ! spec_valid(p, n) ? 0
+                              : std::size_t(spec_parse(p, n).width_arg == SPEC_NEXT_ARG)
+                                    + std::size_t(spec_parse(p, n).precision_arg == SPEC_NEXT_ARG);
+}
+
+// 解析 "{:x}" 里的 ":x" 部分
+inline FormatSpec parse_spec(const KAStr& spec) {
+    const char* p = reinterpret_cast<const char*>(spec.data());
+    if (! spec_valid(p, spec.byte_size())) format_error("unsupport spec: " + std::string(spec));
+    return spec_parse(p, spec.byte_size());
+}
+
+// 从 "{" 之后开始找与之配对的 "}", spec 里可以嵌套一层 "{}"; 找不到返回 len
+inline std::size_t find_field_close(const char* s, std::size_t len, std::size_t pos) {
+    std::size_t depth = 0;
+    for (; pos < len; ++pos) {
+        if (s[pos] == '{') {
+            ++depth;
+        } else if (s[pos] == '}') {
+            if (depth == 0) return pos;
+            --depth;
+        }
+    }
+    return len;
+}
+
+// 拆分 format 字符串为若干文本或 "{...}" 片段
+inline std::vector<KAStr> parse_format(const KAStr& fmt) {
+    std::vector<KAStr> parts;
+    std::size_t pos = 0;
+    std::size_t last = 0;
+    const std::size_t len = fmt.byte_size();
+
+    while (pos < len) {
+        char c = static_cast<char>(fmt[pos]);
+
+        // Handle {{
+        if (pos + 1 < len && c == '{' && fmt[pos + 1] == '{') {
+            if (pos > last) parts.push_back(fmt.subrange(last, pos));
+            parts.push_back(fmt.subrange(pos, pos + 1)); // just one '{'
+            pos += 2;
+            last = pos;
+            continue;
+        }
+
+        // Handle }}
+        if (pos + 1 < len && c == '}' && fmt[pos + 1] == '}') {
+            if (pos > last) parts.push_back(fmt.subrange(last, pos));
+            parts.push_back(fmt.subrange(pos, pos + 1)); // just one '}'
+            pos += 2;
+            last = pos;
+            continue;
+        }
+
+        // Handle normal field {foo}
+        if (c == '{') {
+            if (pos > last) parts.push_back(fmt.subrange(last, pos));
+            ++pos;
+            std::size_t start = pos;
+            pos = find_field_close(reinterpret_cast<const char*>(fmt.data()), len, pos);
+            if (pos == len) format_error("unmatched '{'");
+            parts.push_back(fmt.subrange(start - 1, pos + 1)); // include {}
+            ++pos;
+            last = pos;
+            continue;
+        }
+
+        // Handle lone unmatched }
+        if (c == '}') {
+            format_error("unmatched '}'");
+        }
+
+        ++pos;
+    }
+
+    // Final remaining text
+    if (last < len) {
+        parts.push_back(fmt.subrange(last, len));
+    }
+
+    return parts;
+}
+
+// 按宽度/对齐/填充输出, prefix 是符号和进制前缀; 数字补 0 时 0 填在 prefix 与正文之间
+// render(FormatSink&) 输出正文, 正文先渲染到栈上缓冲区以得到长度, 放不下时才渲染第二次
+template <typename Render>
+void write_aligned(FormatSink& sink, const FormatSpec& fs, char default_align, const char* prefix,
+                   std::size_t prefix_len, bool numeric, const Render& render) {
+    const std::size_t width = fs.width > 0 ? static_cast<std::size_t>(fs.width) : 0;
+    if (width <= prefix_len) {
+        sink.append(prefix, prefix_len);
+        render(sink);
+        return;
+    }
+
+    char tmp[256];
+    FormatSink probe(tmp, sizeof(tmp));
+    render(probe);
+    const std::size_t body = probe.size();
+    const std::size_t pad = width > prefix_len + body ? width - prefix_len - body : 0;
+    const bool zero_fill = numeric && fs.zero && fs.align == '\0';
+    const char align = fs.align != '\0' ? fs.align : default_align;
+    const std::size_t left = zero_fill ? 0 : align == '>' ? pad : align == '^' ? pad / 2 : 0;
+    const std::size_t right = zero_fill ? 0 : pad - left;
+
+    sink.fill(fs.fill, left);
+    sink.append(prefix, prefix_len);
+    if (zero_fill) sink.fill('0', pad);
+    if (probe.written() == body) {
+        sink.append(tmp, body);
+    } else {
+        render(sink);
+    }
+    sink.fill(fs.fill, right);
+}
+
+// 文本: precision 截断长度, 默认左对齐
+inline void format_text(FormatSink& sink, const char* ptr, std::size_t len, const FormatSpec& fs) {
+    if (fs.precision >= 0 && static_cast<std::size_t>(fs.precision) < len) len = static_cast<std::size_t>(fs.precision);
+    const std::size_t width = fs.width > 0 ? static_cast<std::size_t>(fs.width) : 0;
+    if (width <= len) {
+        sink.append(ptr, len);
+        return;
+    }
+    const std::size_t pad = width - len;
+    const std::size_t left = fs.align == '>' ? pad : fs.align == '^' ? pad / 2 : 0;
+    sink.fill(fs.fill, left);
+    sink.append(ptr, len);
+    sink.fill(fs.fill, pad - left);
+}
+
+// 写入一段已知的正文, 供 write_aligned 使用
+struct FormatChars {
+    const char* ptr;
+    std::size_t len;
+
+    void operator()(FormatSink& sink) const {
+        sink.append(ptr, len);
+    }
+};
+
+// 按 printf 规则以指定精度输出非负浮点数
+struct FormatFloatPrecision {
+    double val;
+    char type;
+    int precision;
+    bool alt;
+
+    void operator()(FormatSink& sink) const {
+        detail::format_float_precision(sink, val, type, precision, alt);
+    }
+};
+
+inline bool spec_is_float_type(char type) {
+    return type == 'e' || type == 'E' || type == 'f' || type == 'F' || type == 'g' || type == 'G';
+}
+
+inline std::size_t shortest_chars(char* buf, float val) {
+    return detail::float_to_shortest(buf, val);
+}
+
+template <typename T>
+std::size_t shortest_chars(char* buf, T val) {
+    return detail::double_to_shortest(buf, static_cast<double>(val));
+}
+
+// 符号位单独处理, 以便 '+' / ' ' 和补 0 生效
+template <typename T>
+void format_float(FormatSink& sink, T val, const FormatSpec& fs) {
+    const bool negative = std::signbit(val);
+    const T mag = negative ? -val : val;
+    char prefix[1];
+    std::size_t prefix_len = 0;
+    if (negative) {
+        prefix[prefix_len++] = '-';
+    } else if (fs.sign == '+' || fs.sign == ' ') {
+        prefix[prefix_len++] = fs.sign;
+    }
+    const bool finite = std::isfinite(val);
+
+    if (spec_is_float_type(fs.type) || fs.precision >= 0) {
+        FormatFloatPrecision render = {static_cast<double>(mag), fs.type == '\0' ? 'g' : fs.type, fs.precision, fs.alt};
+        write_aligned(sink, fs, '>', prefix, prefix_len, finite, render);
+    } else {
+        // 默认输出最短往返表示: 读回后与原值逐位相等, float 按 float 精度取最短
+        char buf[detail::FLOAT_SHORTEST_MAX];
+        FormatChars render = {buf, shortest_chars(buf, mag)};
+        write_aligned(sink, fs, '>', prefix, prefix_len, finite, render);
+    }
+}
+
+// 十进制带符号, 其他进制按补码输出(与 std::hex 一致); '#' 加 0x / 0b / 0 前缀
+template <typename T>
+void format_integer(FormatSink& sink, T val, const FormatSpec& fs) {
+    if (spec_is_float_type(fs.type)) {
+        format_float(sink, static_cast<double>(val), fs);
+        return;
+    }
+    if (fs.type == 'c') {
+        const char c = static_cast<char>(val);
+        format_text(sink, &c, 1, fs);
+        return;
+    }
+
+    typedef typename std::make_unsigned<T>::type U;
+    const std::uint64_t u = static_cast<U>(val);
+    char buf[detail::INT_CHARS_MAX];
+    char prefix[3];
+    std::size_t prefix_len = 0;
+    bool negative = false;
+    std::size_t n;
+    switch (fs.type) {
+    case 'x':
+    case 'X':
+        n = detail::u64_to_hex(buf, u, fs.type == 'X');
+        break;
+    case 'b':
+    case 'B':
+        n = detail::u64_to_bin(buf, u);
+        break;
+    case 'o':
+        n = detail::u64_to_oct(buf, u);
+        break;
+    default:
+        negative = detail::int_is_negative(val, std::is_signed<T>());
+        n = detail::u64_to_dec(buf, detail::int_magnitude(val));
+        break;
+    }
+
+    if (negative) {
+        prefix[prefix_len++] = '-';
+    } else if (fs.sign == '+' || fs.sign == ' ') {
+        prefix[prefix_len++] = fs.sign;
+    }
+    if (fs.alt && fs.type != '\0' && fs.type != 'd') {
+        if (fs.type == 'o') {
+            if (u != 0) prefix[prefix_len++] = '0';
+        } else {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = fs.type;
+        }
+    }
+    FormatChars render = {buf, n};
+    write_aligned(sink, fs, '>', prefix, prefix_len, true, render);
+}
+
+template <typename T>
+struct is_char_like
+    : std::integral_constant<bool, std::is_same<T, char>::value || std::is_same<T, signed char>::value
+                                       || std::is_same<T, unsigned char>::value> {};
+
+// 以下 format_value 重载按 spec 格式化单个参数并写入 sink, 常见类型不经过临时 std::string
+inline void format_value(FormatSink& sink, const KAStr& val, const FormatSpec& fs) {
+    format_text(sink, reinterpret_cast<const char*>(val.data()), val.byte_size(), fs);
+}
+
+inline void format_value(FormatSink& sink, const KAString& val, const FormatSpec& fs) {
+    format_text(sink, reinterpret_cast<const char*>(val.data()), val.byte_size(), fs);
+}
+
+inline void format_value(FormatSink& sink, const std::string& val, const FormatSpec& fs) {
+    format_text(sink, val.data(), val.size(), fs);
+}
+
+inline void format_value(FormatSink& sink, const char* val, const FormatSpec& fs) {
+    if (val != nullptr) format_text(sink, val, std::strlen(val), fs);
+}
+
+inline void format_value(FormatSink& sink, bool val, const FormatSpec& fs) {
+    if (val) {
+        format_text(sink, "true", 4, fs);
+    } else {
+        format_text(sink, "false", 5, fs);
+    }
+}
+
+// 字符类型默认输出字符本身, 指定整数类型时输出数值
+template <typename T>
+typename std::enable_if<is_char_like<T>::value>::type format_value(FormatSink& sink, T val, const FormatSpec& fs) {
+    if (fs.type == '\0' || fs.type == 'c' || fs.type == 's') {
+        const char c = static_cast<char>(val);
+        format_text(sink, &c, 1, fs);
+    } else {
+        format_integer(sink, val, fs);
+    }
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value && ! is_char_like<T>::value>::type
+format_value(FormatSink& sink, T val, const FormatSpec& fs) {
+    format_integer(sink, val, fs);
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+format_value(FormatSink& sink, T val, const FormatSpec& fs) {
+    format_float(sink, val, fs);
+}
+
+// 其余类型交给 formatter<T>
+template <typename T>
+typename std::enable_if<! std::is_arithmetic<T>::value>::type
+format_value(FormatSink& sink, const T& val, const FormatSpec& fs) {
+    formatter<T> f;
+    f.parse(fs);
+    f.format(val, sink);
+}
+
+// 容器元素和 duration 的数值沿用字段的 sign / # / precision / type, 宽度和填充作用于整体
+inline FormatSpec element_spec(const FormatSpec& fs) {
+    return FormatSpec(' ', '\0', fs.sign, fs.alt, false, 0, SPEC_NO_ARG, fs.precision, SPEC_NO_ARG, fs.type);
+}
+
+// 没有特化的类型才经过 ostringstream
+template <typename T>
+struct FormatStreamed {
+    const T* val;
+
+    void operator()(FormatSink& sink) const {
+        std::ostringstream oss;
+        oss << *val;
+        const std::string s = oss.str();
+        sink.append(s.data(), s.size());
+    }
+};
+
+template <typename T>
+struct has_const_iterator {
+    template <typename U>
+    static char test(typename U::const_iterator*);
+    template <typename U>
+    static long test(...);
+    enum : bool { value = sizeof(test<T>(nullptr)) == 1 };
+};
+
+template <typename T>
+struct has_mapped_type {
+    template <typename U>
+    static char test(typename U::mapped_type*);
+    template <typename U>
+    static long test(...);
+    enum : bool { value = sizeof(test<T>(nullptr)) == 1 };
+};
+
+template <typename T>
+struct has_key_type {
+    template <typename U>
+    static char test(typename U::key_type*);
+    template <typename U>
+    static long test(...);
+    enum : bool { value = sizeof(test<T>(nullptr)) == 1 };
+};
+
+template <typename T>
+struct is_format_string_like
+    : std::integral_constant<bool, std::is_same<T, std::string>::value || std::is_same<T, KAStr>::value
+                                       || std::is_same<T, KAString>::value> {};
+
+// 有 const_iterator 的非字符串类型按区间输出
+template <typename T>
+struct is_format_range
+    : std::integral_constant<bool, has_const_iterator<T>::value && ! is_format_string_like<T>::value> {};
+
+// map 的元素输出为 "k: v", 其他区间的元素按自身的 formatter 输出
+template <typename T>
+void format_range_item(FormatSink& sink, const T& item, const FormatSpec& fs, std::false_type /*is_map*/) {
+    format_value(sink, item, fs);
+}
+
+template <typename T>
+void format_range_item(FormatSink& sink, const T& item, const FormatSpec& fs, std::true_type /*is_map*/) {
+    format_value(sink, item.first, fs);
+    sink.append(": ", 2);
+    format_value(sink, item.second, fs);
+}
+
+// 序列输出为 [a, b], set 和 map 输出为 {a, b} / {k: v}
+template <typename Range>
+struct FormatRange {
+    const Range* range;
+    FormatSpec spec;
+
+    void operator()(FormatSink& sink) const {
+        const bool braces = has_key_type<Range>::value;
+        sink.push_back(braces ? '{' : '[');
+        bool first = true;
+        for (typename Range::const_iterator it = range->begin(); it != range->end(); ++it) {
+            if (! first) sink.append(", ", 2);
+            first = false;
+            format_range_item(sink, *it, spec, std::integral_constant<bool, has_mapped_type<Range>::value>());
+        }
+        sink.push_back(braces ? '}' : ']');
+    }
+};
+
+template <typename A, typename B>
+struct FormatPair {
+    const std::pair<A, B>* val;
+    FormatSpec spec;
+
+    void operator()(FormatSink& sink) const {
+        sink.push_back('(');
+        format_value(sink, val->first, spec);
+        sink.append(", ", 2);
+        format_value(sink, val->second, spec);
+        sink.push_back(')');
+    }
+};
+
+// duration 的单位后缀; 非常用单位写成 [num/den]s
+template <typename Period>
+void format_duration_unit(FormatSink& sink) {
+    if (std::ratio_equal<Period, std::nano>::value) {
+        sink.append("ns", 2);
+    } else if (std::ratio_equal<Period, std::micro>::value) {
+        sink.append("us", 2);
+    } else if (std::ratio_equal<Period, std::milli>::value) {
+        sink.append("ms", 2);
+    } else if (std::ratio_equal<Period, std::ratio<1> >::value) {
+        sink.push_back('s');
+    } else if (std::ratio_equal<Period, std::ratio<60> >::value) {
+        sink.append("min", 3);
+    } else if (std::ratio_equal<Period, std::ratio<3600> >::value) {
+        sink.push_back('h');
+    } else {
+        sink.push_back('[');
+        format_integer(sink, static_cast<std::intmax_t>(Period::num), FormatSpec());
+        if (Period::den != 1) {
+            sink.push_back('/');
+            format_integer(sink, static_cast<std::intmax_t>(Period::den), FormatSpec());
+        }
+        sink.append("]s", 2);
+    }
+}
+
+template <typename Rep, typename Period>
+struct FormatDuration {
+    const std::chrono::duration<Rep, Period>* val;
+    FormatSpec spec;
+
+    void operator()(FormatSink& sink) const {
+        format_value(sink, val->count(), spec);
+        format_duration_unit<Period>(sink);
+    }
+};
+} // namespace
+
+// 默认: 经 operator<< 输出
+template <typename T, typename Enable>
+struct formatter : FormatterBase {
+    void format(const T& val, FormatSink& sink) const {
+        FormatStreamed<T> render = {&val};
+        write_aligned(sink, spec, '<', nullptr, 0, false, render);
+    }
+};
+
+// 内置类型和字符串: 与 fmt 直接传参的输出一致
+template <typename T>
+struct formatter<T, typename std::enable_if<std::is_arithmetic<T>::value || is_format_string_like<T>::value>::type>
+    : FormatterBase {
+    void format(const T& val, FormatSink& sink) const {
+        format_value(sink, val, spec);
+    }
+};
+
+template <>
+struct formatter<const char*> : FormatterBase {
+    void format(const char* val, FormatSink& sink) const {
+        format_value(sink, val, spec);
+    }
+};
+
+template <>
+struct formatter<char*> : formatter<const char*> {};
+
+template <std::size_t N>
+struct formatter<char[N]> : formatter<const char*> {};
+
+template <typename T>
+struct formatter<T, typename std::enable_if<is_format_range<T>::value>::type> : FormatterBase {
+    void format(const T& val, FormatSink& sink) const {
+        FormatRange<T> render = {&val, element_spec(spec)};
+        write_aligned(sink, spec, '<', nullptr, 0, false, render);
+    }
+};
+
+template <typename A, typename B>
+struct formatter<std::pair<A, B> > : FormatterBase {
+    void format(const std::pair<A, B>& val, FormatSink& sink) const {
+        FormatPair<A, B> render = {&val, element_spec(spec)};
+        write_aligned(sink, spec, '<', nullptr, 0, false, render);
+    }
+};
+
+template <typename Rep, typename Period>
+struct formatter<std::chrono::duration<Rep, Period> > : FormatterBase {
+    void format(const std::chrono::duration<Rep, Period>& val, FormatSink& sink) const {
+        FormatDuration<Rep, Period> render = {&val, element_spec(spec)};
+        write_aligned(sink, spec, '<', nullptr, 0, false, render);
+    }
+};
+
+// RFC 3339 本地时间加偏移 "YYYY-MM-DDTHH:MM:SS+08:00"; precision 是秒的小数位数(最多 9 位)
+// 需要 UTC 时直接用 format_timestamp
+template <>
+struct formatter<std::chrono::system_clock::time_point> : FormatterBase {
+    void format(const std::chrono::system_clock::time_point& val, FormatSink& sink) const {
+        char buf[TIMESTAMP_MAX_CHARS];
+        const int frac_digits = spec.precision < 0 ? 0 : spec.precision;
+        const std::size_t n = format_timestamp(buf, val, TimestampZone::Local, frac_digits);
+        FormatChars render = {buf, n};
+        write_aligned(sink, spec, '<', nullptr, 0, false, render);
+    }
+};
+
+namespace {
+
+// 动态宽度/精度必须是非负整数
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value, int>::type
+spec_dynamic_value(const T& val) {
+    if (detail::int_is_negative(val, std::is_signed<T>()) || detail::int_magnitude(val) > 1000000000u) {
+        format_error("dynamic width or precision out of range");
+    }
+    return static_cast<int>(val);
+}
+
+template <typename T>
+typename std::enable_if<! std::is_integral<T>::value || std::is_same<T, bool>::value, int>::type
+spec_dynamic_value(const T& /*val*/) {
+    format_error("dynamic width or precision must be an integer");
+    return 0;
+}
+
+// 具名参数在 KA_FMT 中按位置使用
+template <typename T>
+void format_value(FormatSink& sink, const NamedArg<T>& val, const FormatSpec& fs) {
+    format_value(sink, val.value, fs);
+}
+
+// ---- 构造 FormatArg ----
+template <typename T>
+void format_custom(FormatSink& sink, const void* ptr, const FormatSpec& fs) {
+    format_value(sink, *static_cast<const T*>(ptr), fs);
+}
+
+inline FormatArg make_str_arg(const char* ptr, std::size_t len) {
+    FormatArg a;
+    a.kind = FormatArg::Str;
+    a.value.str.ptr = ptr;
+    a.value.str.len = len;
+    return a;
+}
+
+inline FormatArg make_format_arg(const KAStr& val) {
+    return make_str_arg(reinterpret_cast<const char*>(val.data()), val.byte_size());
+}
+
+inline FormatArg make_format_arg(const KAString& val) {
+    return make_str_arg(reinterpret_cast<const char*>(val.data()), val.byte_size());
+}
+
+inline FormatArg make_format_arg(const std::string& val) {
+    return make_str_arg(val.data(), val.size());
+}
+
+inline FormatArg make_format_arg(const char* val) {
+    return make_str_arg(val, val == nullptr ? 0 : std::strlen(val));
+}
+
+inline FormatArg make_format_arg(char* val) {
+    return make_format_arg(static_cast<const char*>(val));
+}
+
+inline FormatArg make_format_arg(bool val) {
+    FormatArg a;
+    a.kind = FormatArg::Bool;
+    a.value.b = val;
+    return a;
+}
+
+inline FormatArg make_format_arg(float val) {
+    FormatArg a;
+    a.kind = FormatArg::Float;
+    a.value.f = val;
+    return a;
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, FormatArg>::type make_format_arg(T val) {
+    FormatArg a;
+    a.kind = FormatArg::Double;
+    a.value.d = static_cast<double>(val);
+    return a;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value && std::is_signed<T>::value,
+                        FormatArg>::type
+make_format_arg(T val) {
+    FormatArg a;
+    a.kind = is_char_like<T>::value ? FormatArg::SChar : FormatArg::Int;
+    a.bytes = static_cast<unsigned char>(sizeof(T));
+    a.value.i = val;
+    return a;
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value && ! std::is_signed<T>::value,
+                        FormatArg>::type
+make_format_arg(T val) {
+    FormatArg a;
+    a.kind = is_char_like<T>::value ? FormatArg::UChar : FormatArg::UInt;
+    a.bytes = static_cast<unsigned char>(sizeof(T));
+    a.value.u = val;
+    return a;
+}
+
+template <typename T>
+typename std::enable_if<! std::is_arithmetic<T>::value, FormatArg>::type make_format_arg(const T& val) {
+    FormatArg a;
+    a.kind = FormatArg::Custom;
+    a.value.custom.ptr = &val;
+    a.value.custom.fn = &format_custom<T>;
+    return a;
+}
+
+template <typename T>
+FormatArg make_format_arg(const NamedArg<T>& val) {
+    FormatArg a = make_format_arg(val.value);
+    a.name = val.name;
+    a.name_len = val.name == nullptr ? 0 : std::strlen(val.name);
+    return a;
+}
+
+// ---- 按 FormatArg 输出 ----
+// 按原始位宽还原整数类型, 十六进制/二进制才能得到正确的补码
+inline void format_int_arg(FormatSink& sink, const FormatArg& a, const FormatSpec& fs) {
+    switch (a.bytes) {
+    case 1:
+        format_integer(sink, static_cast<std::int8_t>(a.value.i), fs);
+        break;
+    case 2:
+        format_integer(sink, static_cast<std::int16_t>(a.value.i), fs);
+        break;
+    case 4:
+        format_integer(sink, static_cast<std::int32_t>(a.value.i), fs);
+        break;
+    default:
+        format_integer(sink, a.value.i, fs);
+        break;
+    }
+}
+
+inline void format_uint_arg(FormatSink& sink, const FormatArg& a, const FormatSpec& fs) {
+    switch (a.bytes) {
+    case 1:
+        format_integer(sink, static_cast<std::uint8_t>(a.value.u), fs);
+        break;
+    case 2:
+        format_integer(sink, static_cast<std::uint16_t>(a.value.u), fs);
+        break;
+    case 4:
+        format_integer(sink, static_cast<std::uint32_t>(a.value.u), fs);
+        break;
+    default:
+        format_integer(sink, a.value.u, fs);
+        break;
+    }
+}
+
+inline void format_arg(FormatSink& sink, const FormatArg& a, const FormatSpec& fs) {
+    switch (a.kind) {
+    case FormatArg::Bool:
+        format_value(sink, a.value.b, fs);
+        break;
+    case FormatArg::SChar:
+        format_value(sink, static_cast<signed char>(a.value.i), fs);
+        break;
+    case FormatArg::UChar:
+        format_value(sink, static_cast<unsigned char>(a.value.u), fs);
+        break;
+    case FormatArg::Int:
+        format_int_arg(sink, a, fs);
+        break;
+    case FormatArg::UInt:
+        format_uint_arg(sink, a, fs);
+        break;
+    case FormatArg::Float:
+        format_float(sink, a.value.f, fs);
+        break;
+    case FormatArg::Double:
+        format_float(sink, a.value.d, fs);
+        break;
+    case FormatArg::Str:
+        format_text(sink, a.value.str.ptr, a.value.str.len, fs);
+        break;
+    case FormatArg::Custom:
+        a.value.custom.fn(sink, a.value.custom.ptr, fs);
+        break;
+    case FormatArg::None:
+        format_error("not enough arguments");
+        break;
+    }
+}
+
+// 动态宽度/精度必须是非负整数参数
+inline int arg_dynamic_value(const FormatArg& a) {
+    switch (a.kind) {
+    case FormatArg::Int:
+    case FormatArg::SChar:
+        if (a.value.i < 0 || a.value.i > 1000000000) format_error("dynamic width or precision out of range");
+        return static_cast<int>(a.value.i);
+    case FormatArg::UInt:
+    case FormatArg::UChar:
+        if (a.value.u > 1000000000u) format_error("dynamic width or precision out of range");
+        return static_cast<int>(a.value.u);
+    default:
+        format_error("dynamic width or precision must be an integer");
+        return 0;
+    }
+}
+
+// 字段引用参数的方式: 自动编号 "{}" 与手动编号 "{0}" / "{name}" 不能混用
+class FormatArgIndexer {
+  public:
+    FormatArgIndexer() : next_(0), manual_(false) {}
+
+    std::size_t next() {
+        if (manual_) format_error("cannot switch from manual to automatic argument indexing");
+        return next_++;
+    }
+
+    std::size_t index(std::size_t idx) {
+        if (next_ > 0) format_error("cannot switch from automatic to manual argument indexing");
+        manual_ = true;
+        return idx;
+    }
+
+    // 动态宽度/精度: SPEC_NEXT_ARG 取下一个自动编号, 否则是参数序号
+    int dynamic(int ref) {
+        if (ref == SPEC_NO_ARG) return SPEC_NO_ARG;
+        return static_cast<int>(ref == SPEC_NEXT_ARG ? next() : index(static_cast<std::size_t>(ref)));
+    }
+
+  private:
+    std::size_t next_;
+    bool manual_;
+};
+
+inline bool arg_id_is_name_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// 解析 s[begin, end) 中的字段内容 "[arg_id][:spec]"; 空 arg_id 为自动编号
+inline FormatField parse_field(FormatArgIndexer& indexer, const char* s, std::size_t begin, std::size_t end) {
+    const char* id = s + begin;
+    const void* colon = std::memchr(id, ':', end - begin);
+    const std::size_t len =
+        colon == nullptr ? end - begin : static_cast<std::size_t>(static_cast<const char*>(colon) - id);
+
+    FormatField f = {begin, 0, 0, parse_spec(KAStr(id + len, end - begin - len))};
+    if (len == 0) {
+        f.index = indexer.next();
+    } else if (spec_is_digit(id[0])) {
+        if (spec_digits_end(id, len, 0) != len) format_error("invalid argument id: " + std::string(id, len));
+        f.index = indexer.index(static_cast<std::size_t>(spec_number(id, 0, len, 0)));
+    } else {
+        if (! arg_id_is_name_start(id[0])) format_error("invalid argument id: " + std::string(id, len));
+        for (std::size_t i = 1; i < len; ++i) {
+            if (! arg_id_is_name_start(id[i]) && ! spec_is_digit(id[i])) {
+                format_error("invalid argument id: " + std::string(id, len));
+            }
+        }
+        f.name_len = len;
+    }
+    f.spec.width_arg = indexer.dynamic(f.spec.width_arg);
+    f.spec.precision_arg = indexer.dynamic(f.spec.precision_arg);
+    return f;
+}
+
+/**
+ * @brief 一次扫描格式串, 语法与 parse_format 一致
+ *
+ * handler.literal(begin, len) 收到字面量在 s 中的区间("{{" / "}}" 各对应一个字节),
+ * handler.field(const FormatField&) 收到解析好的字段
+ */
+template <typename Handler>
+void scan_format(const char* s, std::size_t len, Handler& handler) {
+    std::size_t pos = 0;
+    std::size_t last = 0;
+    FormatArgIndexer indexer;
+
+    while (pos < len) {
+        const char c = s[pos];
+        if (c != '{' && c != '}') {
+            ++pos;
+            continue;
+        }
+
+        if (pos > last) handler.literal(last, pos - last);
+        if (pos + 1 < len && s[pos + 1] == c) { // "{{" 或 "}}"
+            handler.literal(pos, 1);
+            pos += 2;
+            last = pos;
+            continue;
+        }
+        if (c == '}') format_error("unmatched '}'");
+
+        const std::size_t close = find_field_close(s, len, pos + 1);
+        if (close == len) format_error("unmatched '{'");
+
+        handler.field(parse_field(indexer, s, pos + 1, close));
+        pos = close + 1;
+        last = pos;
+    }
+    if (len > last) handler.literal(last, len - last);
+}
+
+inline const FormatArg& format_arg_at(const FormatArgs& args, std::size_t idx) {
+    if (idx >= args.count) format_error("not enough arguments");
+    return args.args[idx];
+}
+
+inline const FormatArg& format_arg_named(const FormatArgs& args, const char* name, std::size_t len) {
+    for (std::size_t i = 0; i < args.count; ++i) {
+        const FormatArg& a = args.args[i];
+        if (a.name_len == len && std::memcmp(a.name, name, len) == 0) return a;
+    }
+    format_error("named argument not found: " + std::string(name, len));
+    return args.args[0];
+}
+
+// 按解析好的字段取参数并输出; s 是字段所在的格式串
+inline void format_field(FormatSink& sink, const char* s, const FormatField& f, const FormatArgs& args) {
+    const FormatArg& value = f.name_len == 0 ? format_arg_at(args, f.index)
+                                             : format_arg_named(args, s + f.name_begin, f.name_len);
+    if (f.spec.width_arg == SPEC_NO_ARG && f.spec.precision_arg == SPEC_NO_ARG) {
+        format_arg(sink, value, f.spec);
+        return;
+    }
+    FormatSpec fs = f.spec;
+    if (fs.width_arg != SPEC_NO_ARG) {
+        fs.width = arg_dynamic_value(format_arg_at(args, static_cast<std::size_t>(fs.width_arg)));
+    }
+    if (fs.precision_arg != SPEC_NO_ARG) {
+        fs.precision = arg_dynamic_value(format_arg_at(args, static_cast<std::size_t>(fs.precision_arg)));
+    }
+    format_arg(sink, value, fs);
+}
+
+// 边扫描边输出
+struct FormatDirect {
+    FormatSink& sink;
+    const char* s;
+    const FormatArgs& args;
+
+    void literal(std::size_t begin, std::size_t len) {
+        sink.append(s + begin, len);
+    }
+
+    void field(const FormatField& f) {
+        format_field(sink, s, f, args);
+    }
+};
+
+// 运行期格式化: 一次扫描, 字面量和参数直接写入 sink, 不生成中间的 parts
+// 不是模板, 各调用点只需为参数类型实例化 make_format_arg
+inline void format_to_sink(FormatSink& sink, const KAStr& fmt, const FormatArgs& args) {
+    const char* s = reinterpret_cast<const char*>(fmt.data());
+    FormatDirect direct = {sink, s, args};
+    scan_format(s, fmt.byte_size(), direct);
+}
+
+// ---- 编译期格式串 ----
+// C++11 的 constexpr 函数体只能有一条 return, 下面的扫描都写成递归形式
+// 段: 一段连续字面量, 一个转义的 "{{" / "}}", 或一个 "{...}" 字段
+enum FmtSegKind {
+    FmtLiteral,
+    FmtField,
+    FmtBadBrace
+};
+
+struct FmtSeg {
+    FmtSegKind kind;
+    std::size_t begin; // 字面量的起点; 字段则为花括号内内容的起点
+    std::size_t len;
+    std::size_t next; // 下一段的起点
+
+    constexpr FmtSeg(FmtSegKind k, std::size_t b, std::size_t l, std::size_t nx) : kind(k), begin(b), len(l), next(nx) {}
+};
+
+constexpr bool fmt_is_brace(char c) {
+    return c == '{' || c == '}';
+}
+
+constexpr bool fmt_no_brace8(const char* s, std::size_t i) {
+    return ! fmt_is_brace(s[i]) && ! fmt_is_brace(s[i + 1]) && ! fmt_is_brace(s[i + 2]) && ! fmt_is_brace(s[i + 3])
+           && ! fmt_is_brace(s[i + 4]) && ! fmt_is_brace(s[i + 5]) && ! fmt_is_brace(s[i + 6])
+           && ! fmt_is_brace(s[i + 7]);
+}
+
+constexpr std::size_t fmt_literal_end1(const char* s, std::size_t n, std::size_t i) {
+    return (i >= n || fmt_is_brace(s[i])) ? i : fmt_literal_end1(s, n, i + 1);
+}
+
+// 每层递归跨 8 个字节, 避免长字面量超出编译器的 constexpr 递归深度
+constexpr std::size_t fmt_literal_end(const char* s, std::size_t n, std::size_t i) {
+    return (i + 8 <= n && fmt_no_brace8(s, i)) ? fmt_literal_end(s, n, i + 8) : fmt_literal_end1(s, n, i);
+}
+
+// 与 find_field_close 相同, spec 里可以嵌套一层 "{}"
+constexpr std::size_t fmt_find_close(const char* s, std::size_t n, std::size_t i, std::size_t depth) {
+    return i >= n                         ? n
+           : s[i] == '{'                  ? fmt_find_close(s, n, i + 1, depth + 1)
+           : (s[i] == '}' && depth == 0) ? i
+           : s[i] == '}'                  ? fmt_find_close(s, n, i + 1, depth - 1)
+                                          : fmt_find_close(s, n, i + 1, depth);
+}
+
+constexpr FmtSeg fmt_field_seg(std::size_t open, std::size_t close, std::size_t n) {
+    return close >= n ? FmtSeg(FmtBadBrace, open, 0, n) : FmtSeg(FmtField, open + 1, close - open - 1, close + 1);
+}
+
+constexpr FmtSeg fmt_literal_seg(std::size_t i, std::size_t end) {
+    return FmtSeg(FmtLiteral, i, end - i, end);
+}
+
+// 从 i 开始的一段; 出错时 next 直接跳到末尾
+constexpr FmtSeg fmt_seg_at(const char* s, std::size_t n, std::size_t i) {
+    return s[i] == '{'   ? (i + 1 < n && s[i + 1] == '{' ? FmtSeg(FmtLiteral, i, 1, i + 2)
+                                                         : fmt_field_seg(i, fmt_find_close(s, n, i + 1, 0), n))
+           : s[i] == '}' ? (i + 1 < n && s[i + 1] == '}' ? FmtSeg(FmtLiteral, i, 1, i + 2) : FmtSeg(FmtBadBrace, i, 0, n))
+                         : fmt_literal_seg(i, fmt_literal_end(s, n, i));
+}
+
+constexpr std::size_t fmt_seg_count(const char* s, std::size_t n, std::size_t i) {
+    return i >= n ? 0 : 1 + fmt_seg_count(s, n, fmt_seg_at(s, n, i).next);
+}
+
+// 第 k 段的起点
+constexpr std::size_t fmt_seg_pos(const char* s, std::size_t n, std::size_t i, std::size_t k) {
+    return k == 0 ? i : fmt_seg_pos(s, n, fmt_seg_at(s, n, i).next, k - 1);
+}
+
+constexpr std::size_t fmt_seg_args(const char* s, const FmtSeg& seg) {
+    return seg.kind == FmtField ? 1 + spec_dynamic_args(s + seg.begin, seg.len) : 0;
+}
+
+// [i, end) 之间的字段消耗的参数个数, 也就是起点为 end 的字段的参数序号
+constexpr std::size_t fmt_field_count(const char* s, std::size_t n, std::size_t i, std::size_t end) {
+    return i >= end ? 0 : fmt_seg_args(s, fmt_seg_at(s, n, i)) + fmt_field_count(s, n, fmt_seg_at(s, n, i).next, end);
+}
+
+constexpr std::size_t fmt_literal_bytes(const char* s, std::size_t n, std::size_t i) {
+    return i >= n ? 0
+                  : (fmt_seg_at(s, n, i).kind == FmtLiteral ? fmt_seg_at(s, n, i).len : 0)
+                        + fmt_literal_bytes(s, n, fmt_seg_at(s, n, i).next);
+}
+
+constexpr bool fmt_has_bad_brace(const char* s, std::size_t n, std::size_t i) {
+    return i < n && (fmt_seg_at(s, n, i).kind == FmtBadBrace || fmt_has_bad_brace(s, n, fmt_seg_at(s, n, i).next));
+}
+
+constexpr bool fmt_seg_bad_spec(const char* s, const FmtSeg& seg) {
+    return seg.kind == FmtField && ! spec_valid(s + seg.begin, seg.len);
+}
+
+constexpr bool fmt_has_bad_spec(const char* s, std::size_t n, std::size_t i) {
+    return i < n && (fmt_seg_bad_spec(s, fmt_seg_at(s, n, i)) || fmt_has_bad_spec(s, n, fmt_seg_at(s, n, i).next));
+}
+
+// KA_FMT 只支持自动编号: 字段以 ':' 开头, 动态宽度/精度只能是 "{}"
+constexpr bool fmt_seg_manual(const char* s, const FmtSeg& seg) {
+    return seg.kind == FmtField && seg.len > 0
+           && (s[seg.begin] != ':'
+               || (spec_valid(s + seg.begin, seg.len)
+                   && (spec_parse(s + seg.begin, seg.len).width_arg >= 0
+                       || spec_parse(s + seg.begin, seg.len).precision_arg >= 0)));
+}
+
+constexpr bool fmt_has_manual_index(const char* s, std::size_t n, std::size_t i) {
+    return i < n && (fmt_seg_manual(s, fmt_seg_at(s, n, i)) || fmt_has_manual_index(s, n, fmt_seg_at(s, n, i).next));
+}
+
+template <std::size_t... Is>
+struct index_seq {};
+
+template <std::size_t N, std::size_t... Is>
+struct make_index_seq : make_index_seq<N - 1, N - 1, Is...> {};
+
+template <std::size_t... Is>
+struct make_index_seq<0, Is...> {
+    typedef index_seq<Is...> type;
+};
+
+// 格式串 S 第 K 段的编译期信息
+template <typename S, std::size_t K>
+struct FmtSegInfo {
+    enum : std::size_t {
+        pos = fmt_seg_pos(S::data(), S::size(), 0, K),
+        begin = fmt_seg_at(S::data(), S::size(), pos).begin,
+        len = fmt_seg_at(S::data(), S::size(), pos).len,
+        arg = fmt_field_count(S::data(), S::size(), 0, pos)
+    };
+
+    static constexpr FmtSegKind kind = fmt_seg_at(S::data(), S::size(), pos).kind;
+
+    static constexpr FormatSpec spec() {
+        return spec_parse(S::data() + begin, len);
+    }
+};
+
+// 动态宽度/精度: 编译期已知参数序号, 不是动态值时直接返回 spec 里的常量
+template <bool Dynamic, std::size_t I>
+struct FmtDynValue {
+    template <typename Tuple>
+    static int get(const Tuple& /*tup*/, int fixed) {
+        return fixed;
+    }
+};
+
+template <std::size_t I>
+struct FmtDynValue<true, I> {
+    template <typename Tuple>
+    static int get(const Tuple& tup, int /*fixed*/) {
+        return spec_dynamic_value(std::get<I>(tup));
+    }
+};
+
+template <typename S, std::size_t K, FmtSegKind Kind = FmtSegInfo<S, K>::kind>
+struct FmtSegEmit;
+
+template <typename S, std::size_t K>
+struct FmtSegEmit<S, K, FmtLiteral> {
+    template <typename Tuple>
+    static void emit(FormatSink& sink, const Tuple& /*tup*/) {
+        sink.append(S::data() + FmtSegInfo<S, K>::begin, FmtSegInfo<S, K>::len);
+    }
+};
+
+template <typename S, std::size_t K>
+struct FmtSegEmit<S, K, FmtField> {
+    template <typename Tuple>
+    static void emit(FormatSink& sink, const Tuple& tup) {
+        typedef FmtSegInfo<S, K> Info;
+        constexpr FormatSpec cs = Info::spec();
+        enum : std::size_t {
+            WIDTH_DYN = cs.width_arg == SPEC_NEXT_ARG,
+            PRECISION_DYN = cs.precision_arg == SPEC_NEXT_ARG
+        };
+        if (WIDTH_DYN || PRECISION_DYN) {
+            FormatSpec fs = cs;
+            fs.width = FmtDynValue<WIDTH_DYN != 0, Info::arg + 1>::get(tup, cs.width);
+            fs.precision = FmtDynValue<PRECISION_DYN != 0, Info::arg + 1 + WIDTH_DYN>::get(tup, cs.precision);
+            format_value(sink, std::get<Info::arg>(tup), fs);
+        } else {
+            format_value(sink, std::get<Info::arg>(tup), cs);
+        }
+    }
+};
+
+template <typename S, typename Tuple, std::size_t... Ks>
+void fmt_emit_all(FormatSink& sink, const Tuple& tup, index_seq<Ks...>) {
+    int expand[] = {0, (FmtSegEmit<S, Ks>::emit(sink, tup), 0)...};
+    (void)expand;
+}
+} // namespace
+
+/**
+ * @brief 编译期解析的格式串, 由 KA_FMT("...") 生成
+ *
+ * 花括号配对、spec 合法性以及占位符与参数个数是否一致都在编译期检查;
+ * 运行期只按预先切好的段依次输出字面量和参数, 不再分配 parts 或解析 spec
+ */
+template <typename S>
+class KAFormatString {
+    static_assert(! fmt_has_bad_brace(S::data(), S::size(), 0), "KA_FMT: unmatched '{' or '}' in format string");
+    static_assert(! fmt_has_manual_index(S::data(), S::size(), 0),
+                  "KA_FMT: positional and named arguments are only supported by KAStr::fmt");
+    static_assert(! fmt_has_bad_spec(S::data(), S::size(), 0), "KA_FMT: unsupported format spec");
+
+  public:
+    enum : std::size_t {
+        SEGMENTS = fmt_seg_count(S::data(), S::size(), 0),
+        ARGS = fmt_field_count(S::data(), S::size(), 0, S::size()),
+        LITERAL_BYTES = fmt_literal_bytes(S::data(), S::size(), 0)
+    };
+
+    KAStr str() const {
+        return KAStr(S::data(), S::size());
+    }
+
+    template <typename... Args>
+    KAString fmt(const Args&... args) const {
+        KAString out;
+        out.reserve(LITERAL_BYTES + 8 * ARGS);
+        fmt_to(out, args...);
+        return out;
+    }
+
+    template <typename... Args>
+    void fmt_to(KAString& out, const Args&... args) const {
+        FormatSink sink(out);
+        emit(sink, args...);
+    }
+
+    template <typename... Args>
+    FormatResult fmt_to(char* buf, std::size_t cap, const Args&... args) const {
+        FormatSink sink(buf, cap);
+        emit(sink, args...);
+        return sink.result();
+    }
+
+    template <typename... Args>
+    std::size_t formatted_size(const Args&... args) const {
+        FormatSink sink;
+        emit(sink, args...);
+        return sink.size();
+    }
+
+  private:
+    template <typename... Args>
+    void emit(FormatSink& sink, const Args&... args) const {
+        static_assert(sizeof...(Args) == ARGS, "KA_FMT: number of arguments does not match the placeholders");
+        std::tuple<const Args&...> tup(args...);
+        fmt_emit_all<S>(sink, tup, typename make_index_seq<SEGMENTS>::type());
+    }
+};
+
+template <typename S>
+KAFormatString<S> make_format_string(S) {
+    return KAFormatString<S>();
+}
+
+// 公共接口
+namespace {
+// 参数数组放在栈上; 多留一个元素, 无参数时数组也不为空
+template <typename... Args>
+void format_args_to(FormatSink& sink, const KAStr& fmt, const Args&... args) {
+    const FormatArg store[sizeof...(Args) + 1] = {make_format_arg(args)..., FormatArg()};
+    const FormatArgs list = {store, sizeof...(Args)};
+    format_to_sink(sink, fmt, list);
+}
+} // namespace
+
+template <typename... Args>
+KAString KAStr::fmt(const Args&... args) const {
+    KAString out;
+    fmt_to(out, args...);
+    return out;
+}
+
+template <typename... Args>
+void KAStr::fmt_to(KAString& out, const Args&... args) const {
+    FormatSink sink(out);
+    format_args_to(sink, *this, args...);
+}
+
+template <typename... Args>
+FormatResult KAStr::fmt_to(char* buf, std::size_t cap, const Args&... args) const {
+    FormatSink sink(buf, cap);
+    format_args_to(sink, *this, args...);
+    return sink.result();
+}
+
+template <typename... Args>
+std::size_t KAStr::formatted_size(const Args&... args) const {
+    FormatSink sink;
+    format_args_to(sink, *this, args...);
+    return sink.size();
+}
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
+
+// 用法: KA_FMT("{} -> {:x}").fmt(a, b)
+// 每个 KA_FMT 生成一个独有的类型, 格式串在编译期切段和校验, 参数个数不符直接编译失败
+#define KA_FMT(s)                                                                                                      \
+    (::kastring::make_format_string([]() {                                                                             \
+        struct KAFmtLiteral {                                                                                          \
+            static constexpr const char* data() {                                                                      \
+                return s;                                                                                              \
+            }                                                                                                          \
+            static constexpr std::size_t size() {                                                                      \
+                return sizeof(s) - 1;                                                                                  \
+            }                                                                                                          \
+        };                                                                                                             \
+        return KAFmtLiteral();                                                                                         \
+    }()))
@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+#include "./format.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+/**
+ * @brief 运行期解析一次、可反复使用的格式模板
+ *
+ * 用于运行期才拿到的格式串(配置里的告警模板、日志格式等): 构造时解析成由字面量区间和参数槽位组成的指令表,
+ * 之后每次格式化只按指令表输出, 不再扫描花括号或解析 spec
+ * 语法与 KAStr::fmt 完全相同, 格式串非法时构造函数抛出 std::invalid_argument
+ */
+class KAFormatTemplate {
+  public:
+    explicit KAFormatTemplate(const KAStr& fmt) : text_(fmt), ops_(), fields_(), arg_count_(0), literal_bytes_(0) {
+        if (fmt.byte_size() >= FIELD_OP) throw std::length_error("KAFormatTemplate: format string too long");
+        Recorder rec = {this};
+        scan_format(text(), text_.byte_size(), rec);
+    }
+
+    KAStr str() const {
+        return text_.as_kastr();
+    }
+
+    // 按序号引用到的参数个数, 传入的参数少于此数时格式化必然失败
+    std::size_t arg_count() const {
+        return arg_count_;
+    }
+
+    // 指令条数: 合并后的字面量区间与字段之和
+    std::size_t instruction_count() const {
+        return ops_.size();
+    }
+
+    std::size_t literal_bytes() const {
+        return literal_bytes_;
+    }
+
+    template <typename... Args>
+    KAString fmt(const Args&... args) const {
+        KAString out;
+        out.reserve(literal_bytes_ + 8 * fields_.size());
+        fmt_to(out, args...);
+        return out;
+    }
+
+    template <typename... Args>
+    void fmt_to(KAString& out, const Args&... args) const {
+        FormatSink sink(out);
+        emit(sink, args...);
+    }
+
+    template <typename... Args>
+    FormatResult fmt_to(char* buf, std::size_t cap, const Args&... args) const {
+        FormatSink sink(buf, cap);
+        emit(sink, args...);
+        return sink.result();
+    }
+
+    template <typename... Args>
+    std::size_t formatted_size(const Args&... args) const {
+        FormatSink sink;
+        emit(sink, args...);
+        return sink.size();
+    }
+
+    /**
+     * @brief 按列批量格式化: 第 i 行以每列的第 i 个元素作为参数, 所有行依次写入同一个 KAString
+     *
+     * 列可以是任何支持 size() 和 operator[] 的容器(std::vector、span、std::array 等), 各列长度必须相同;
+     * 每个字段在进入循环前就绑定到对应列的类型化输出函数, 逐行输出时不再按参数类型分派
+     * 模板中不能有具名字段
+     */
+    template <typename... Cols>
+    KAString fmt_rows(const Cols&... cols) const {
+        KAString out;
+        fmt_rows_to(out, 1, cols...);
+        return out;
+    }
+
+    // 同 fmt_rows, 行数足够多时把行切成 threads 段并行格式化, 再按顺序拼接
+    template <typename... Cols>
+    KAString fmt_rows_parallel(std::size_t threads, const Cols&... cols) const {
+        KAString out;
+        fmt_rows_to(out, threads, cols...);
+        return out;
+    }
+
+    // 追加到 out 末尾
+    template <typename... Cols>
+    void fmt_rows_to(KAString& out, std::size_t threads, const Cols&... cols) const {
+        const Column columns[sizeof...(Cols) + 1] = {column_of(cols)..., Column()};
+        run_rows(out, threads, columns, sizeof...(Cols));
+    }
+
+    // 直接使用已打包好的参数
+    void run(FormatSink& sink, const FormatArgs& args) const {
+        const char* s = text();
+        for (const Op& op : ops_) {
+            if (op.len == FIELD_OP) {
+                format_field(sink, s, fields_[op.begin], args);
+            } else {
+                sink.append(s + op.begin, op.len);
+            }
+        }
+    }
+
+  private:
+    enum : std::uint32_t { FIELD_OP = 0xffffffffu };
+
+    enum : std::size_t {
+        ROW_SAMPLE = 32,            // 估算输出大小时抽样的行数
+        MIN_ROWS_PER_THREAD = 4096 // 每个线程至少分到的行数, 行数太少时并行得不偿失
+    };
+
+    // 类型擦除后的一列; 输出函数按列的元素类型实例化
+    typedef void (*CellFn)(FormatSink&, const void*, std::size_t, const FormatSpec&);
+    typedef int (*DynamicFn)(const void*, std::size_t);
+
+    struct Column {
+        const void* data;
+        std::size_t size;
+        CellFn format;
+        DynamicFn dynamic;
+
+        Column() : data(nullptr), size(0), format(nullptr), dynamic(nullptr) {}
+
+        Column(const void* data_, std::size_t size_, CellFn format_, DynamicFn dynamic_)
+            : data(data_), size(size_), format(format_), dynamic(dynamic_) {}
+    };
+
+    template <typename Col>
+    static void format_cell(FormatSink& sink, const void* col, std::size_t row, const FormatSpec& fs) {
+        format_value(sink, (*static_cast<const Col*>(col))[row], fs);
+    }
+
+    template <typename Col>
+    static int dynamic_cell(const void* col, std::size_t row) {
+        return arg_dynamic_value(make_format_arg((*static_cast<const Col*>(col))[row]));
+    }
+
+    template <typename Col>
+    static Column column_of(const Col& col) {
+        return Column(&col, static_cast<std::size_t>(col.size()), &format_cell<Col>, &dynamic_cell<Col>);
+    }
+
+    // 输出 [begin, end) 行
+    void format_rows(FormatSink& sink, const Column* cols, std::size_t begin, std::size_t end) const {
+        const char* s = text();
+        for (std::size_t row = begin; row < end; ++row) {
+            for (const Op& op : ops_) {
+                if (op.len != FIELD_OP) {
+                    sink.append(s + op.begin, op.len);
+                    continue;
+                }
+                const FormatField& f = fields_[op.begin];
+                const Column& c = cols[f.index];
+                if (f.spec.width_arg == SPEC_NO_ARG && f.spec.precision_arg == SPEC_NO_ARG) {
+                    c.format(sink, c.data, row, f.spec);
+                    continue;
+                }
+                FormatSpec fs = f.spec;
+                if (fs.width_arg != SPEC_NO_ARG) {
+                    const Column& w = cols[static_cast<std::size_t>(fs.width_arg)];
+                    fs.width = w.dynamic(w.data, row);
+                }
+                if (fs.precision_arg != SPEC_NO_ARG) {
+                    const Column& p = cols[static_cast<std::size_t>(fs.precision_arg)];
+                    fs.precision = p.dynamic(p.data, row);
+                }
+                c.format(sink, c.data, row, fs);
+            }
+        }
+    }
+
+    void run_rows(KAString& out, std::size_t threads, const Column* cols, std::size_t ncols) const {
+        for (const FormatField& f : fields_) {
+            if (f.name_len != 0) {
+                throw std::invalid_argument("KAFormatTemplate::fmt_rows(): named fields are not supported");
+            }
+        }
+        if (ncols < arg_count_) {
+            throw std::invalid_argument("KAFormatTemplate::fmt_rows(): expected " + std::to_string(arg_count_)
+                                        + " columns, got " + std::to_string(ncols));
+        }
+        const std::size_t rows = ncols == 0 ? 0 : cols[0].size;
+        for (std::size_t i = 1; i < ncols; ++i) {
+            if (cols[i].size != rows) {
+                throw std::invalid_argument("KAFormatTemplate::fmt_rows(): columns differ in length");
+            }
+        }
+        if (ncols == 0) return;
+
+        // 抽样前几行得到每行的平均宽度, 一次性预留整个输出
+        const std::size_t sample = std::min<std::size_t>(rows, ROW_SAMPLE);
+        FormatSink counter;
+        format_rows(counter, cols, 0, sample);
+        const std::size_t estimate = sample == 0 ? 0 : counter.size() / sample * rows + counter.size();
+        out.reserve(out.byte_size() + estimate);
+
+        const std::size_t parts = std::min(threads, rows / MIN_ROWS_PER_THREAD);
+        if (parts <= 1) {
+            FormatSink sink(out);
+            format_rows(sink, cols, 0, rows);
+            return;
+        }
+
+        // 第 0 段由当前线程完成, 其余段各开一个线程, 结束后按顺序拼接
+        const std::size_t chunk = (rows + parts - 1) / parts;
+        std::vector<KAString> pieces(parts);
+        std::vector<std::exception_ptr> errors(parts);
+        std::vector<std::thread> workers;
+        workers.reserve(parts - 1);
+        auto work = [&](std::size_t i) {
+            try {
+                const std::size_t begin = i * chunk;
+                const std::size_t end = std::min(rows, begin + chunk);
+                pieces[i].reserve(estimate / parts + counter.size());
+                FormatSink sink(pieces[i]);
+                format_rows(sink, cols, begin, end);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        };
+        for (std::size_t i = 1; i < parts; ++i) workers.emplace_back(work, i);
+        work(0);
+        for (std::thread& t : workers) t.join();
+        for (const std::exception_ptr& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+
+        std::size_t total = 0;
+        for (const KAString& p : pieces) total += p.byte_size();
+        out.reserve(out.byte_size() + total);
+        for (const KAString& p : pieces) out.append(p);
+    }
+
+    // 字面量: text_ 中的 [begin, begin + len); 字段: len == FIELD_OP, begin 是 fields_ 的下标
+    struct Op {
+        std::uint32_t begin;
+        std::uint32_t len;
+    };
+
+    struct Recorder {
+        KAFormatTemplate* self;
+
+        void literal(std::size_t begin, std::size_t len) {
+            std::vector<Op>& ops = self->ops_;
+            self->literal_bytes_ += len;
+            // "{{" 紧跟在字面量之后时与之合并
+            if (! ops.empty() && ops.back().len != FIELD_OP && ops.back().begin + ops.back().len == begin) {
+                ops.back().len += static_cast<std::uint32_t>(len);
+                return;
+            }
+            Op op = {static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(len)};
+            ops.push_back(op);
+        }
+
+        void field(const FormatField& f) {
+            if (f.name_len == 0) self->need_arg(f.index);
+            if (f.spec.width_arg >= 0) self->need_arg(static_cast<std::size_t>(f.spec.width_arg));
+            if (f.spec.precision_arg >= 0) self->need_arg(static_cast<std::size_t>(f.spec.precision_arg));
+            Op op = {static_cast<std::uint32_t>(self->fields_.size()), FIELD_OP};
+            self->fields_.push_back(f);
+            self->ops_.push_back(op);
+        }
+    };
+
+    void need_arg(std::size_t idx) {
+        if (idx + 1 > arg_count_) arg_count_ = idx + 1;
+    }
+
+    const char* text() const {
+        return reinterpret_cast<const char*>(text_.data());
+    }
+
+    template <typename... Args>
+    void emit(FormatSink& sink, const Args&... args) const {
+        const FormatArg store[sizeof...(Args) + 1] = {make_format_arg(args)..., FormatArg()};
+        const FormatArgs list = {store, sizeof...(Args)};
+        run(sink, list);
+    }
+
+    KAString text_;
+    std::vector<Op> ops_;
+    std::vector<FormatField> fields_;
+    std::size_t arg_count_;
+    std::size_t literal_bytes_;
+};
+
+/**
+ * @brief 线程安全的 KAFormatTemplate LRU 缓存, 以格式串的字节内容为键
+ *
+ * 给临时拼出格式串的调用方使用: 同一格式串只解析一次, 超出容量时淘汰最久未使用的模板
+ * 返回的 shared_ptr 在模板被淘汰后依然有效
+ */
+class KAFormatCache {
+  public:
+    enum : std::size_t { DEFAULT_CAPACITY = 256 };
+
+    explicit KAFormatCache(std::size_t capacity = DEFAULT_CAPACITY)
+        : mtx_(), lru_(), index_(), capacity_(capacity), hits_(0), misses_(0) {
+        if (capacity == 0) throw std::invalid_argument("KAFormatCache: capacity must not be zero");
+    }
+
+    KAFormatCache(const KAFormatCache&) = delete;
+    KAFormatCache& operator=(const KAFormatCache&) = delete;
+
+    // 进程内共享的缓存
+    static KAFormatCache& shared() {
+        static KAFormatCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const KAFormatTemplate> get(const KAStr& fmt) {
+        const std::uint64_t h = hash_bytes(fmt.data(), fmt.byte_size());
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            std::shared_ptr<const KAFormatTemplate> hit = lookup(fmt, h);
+            if (hit) {
+                ++hits_;
+                return hit;
+            }
+        }
+
+        // 解析放在锁外, 不同格式串的首次解析互不阻塞
+        std::shared_ptr<const KAFormatTemplate> tpl = std::make_shared<const KAFormatTemplate>(fmt);
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        // 解析期间已被其他线程插入: 返回已缓存的模板, 计为命中
+        std::shared_ptr<const KAFormatTemplate> raced = lookup(fmt, h);
+        if (raced) {
+            ++hits_;
+            return raced;
+        }
+        ++misses_;
+
+        Entry e = {h, tpl};
+        lru_.push_front(e);
+        index_.insert(std::make_pair(h, lru_.begin()));
+        if (lru_.size() > capacity_) evict_last();
+        return tpl;
+    }
+
+    template <typename... Args>
+    KAString fmt(const KAStr& fmt, const Args&... args) {
+        return get(fmt)->fmt(args...);
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return lru_.size();
+    }
+
+    std::size_t capacity() const {
+        return capacity_;
+    }
+
+    std::size_t hits() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return hits_;
+    }
+
+    std::size_t misses() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return misses_;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        index_.clear();
+        lru_.clear();
+    }
+
+  private:
+    struct Entry {
+        std::uint64_t hash;
+        std::shared_ptr<const KAFormatTemplate> tpl;
+    };
+
+    typedef std::list<Entry> List;
+
+    // 调用方持有锁; 命中时移到表头
+    std::shared_ptr<const KAFormatTemplate> lookup(const KAStr& fmt, std::uint64_t h) {
+        auto range = index_.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second->tpl->str() == fmt) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return it->second->tpl;
+            }
+        }
+        return std::shared_ptr<const KAFormatTemplate>();
+    }
+
+    void evict_last() {
+        List::iterator last = std::prev(lru_.end());
+        auto range = index_.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                index_.erase(it);
+                break;
+            }
+        }
+        lru_.erase(last);
+    }
+
+    mutable std::mutex mtx_;
+    List lru_; // 表头是最近使用的
+    std::unordered_multimap<std::uint64_t, List::iterator> index_;
+    std::size_t capacity_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
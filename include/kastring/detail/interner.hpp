@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+/**
+ * @brief 并发字符串驻留池: 相同内容只保存一份, 返回 32 位符号 ID
+ *
+ * - 按哈希高位分片, 每个分片一把锁, 不同分片的 intern 互不阻塞
+ * - 字符串字节存放在按块增长的 arena 中, 已返回的 KAStr 永远不会失效或移动
+ * - resolve(id) 是 O(1) 且无锁的
+ *
+ * ID 的低 SHARD_BITS 位是分片号, 高位是分片内序号, 因此 ID 不连续
+ */
+class KAInterner {
+  public:
+    typedef std::uint32_t id_type;
+
+    enum : std::size_t {
+        SHARD_BITS = 4,
+        SHARD_COUNT = std::size_t(1) << SHARD_BITS,
+        DEFAULT_CHUNK_SIZE = 64 * 1024
+    };
+
+    explicit KAInterner(std::size_t chunk_size = DEFAULT_CHUNK_SIZE) : shards_() {
+        if (chunk_size == 0) throw std::invalid_argument("KAInterner: chunk_size must not be zero");
+        for (std::size_t i = 0; i < SHARD_COUNT; ++i) shards_[i].chunk_size = chunk_size;
+    }
+
+    KAInterner(const KAInterner&) = delete;
+    KAInterner& operator=(const KAInterner&) = delete;
+
+    id_type intern(const KAStr& str) {
+        const std::uint64_t h = hash_bytes(str.data(), str.byte_size());
+        const std::size_t shard_idx = static_cast<std::size_t>(h >> (64 - SHARD_BITS));
+        Shard& shard = shards_[shard_idx];
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        std::size_t slot = shard.probe(str, h);
+        if (shard.table[slot] != 0) return make_id(shard_idx, (shard.table[slot] & kIdMask) - 1);
+
+        const std::uint32_t local = shard.push(str);
+        shard.table[slot] = static_cast<std::uint64_t>(local + 1) | (h & kTagMask);
+        if (++shard.used * 4 > shard.table.size() * 3) shard.rehash();
+        return make_id(shard_idx, local);
+    }
+
+    // 只查找不插入, 找到返回 true 并写入 id
+    bool find(const KAStr& str, id_type& id) const {
+        const std::uint64_t h = hash_bytes(str.data(), str.byte_size());
+        const std::size_t shard_idx = static_cast<std::size_t>(h >> (64 - SHARD_BITS));
+        const Shard& shard = shards_[shard_idx];
+
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        if (shard.table.empty()) return false;
+        std::size_t slot = shard.probe(str, h);
+        if (shard.table[slot] == 0) return false;
+        id = make_id(shard_idx, (shard.table[slot] & kIdMask) - 1);
+        return true;
+    }
+
+    bool contains(const KAStr& str) const {
+        id_type id;
+        return find(str, id);
+    }
+
+    KAStr resolve(id_type id) const {
+        const Shard& shard = shards_[id & (SHARD_COUNT - 1)];
+        const std::uint32_t local = id >> SHARD_BITS;
+        if (local >= shard.count.load(std::memory_order_acquire)) {
+            throw std::out_of_range("KAInterner::resolve(): unknown id " + std::to_string(id));
+        }
+        return shard.entry(local);
+    }
+
+    // 已驻留的不同字符串数量
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < SHARD_COUNT; ++i) n += shards_[i].count.load(std::memory_order_acquire);
+        return n;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // arena 已申请的字节数(不含索引结构)
+    std::size_t arena_bytes() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < SHARD_COUNT; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mtx);
+            n += shards_[i].arena_bytes;
+        }
+        return n;
+    }
+
+  private:
+    // 哈希表槽位: 低 32 位是 (分片内序号 + 1), 0 表示空; 高 32 位保存哈希高位用于快速比较
+    enum : std::uint64_t {
+        kIdMask = 0xffffffffull,
+        kTagMask = 0xffffffff00000000ull
+    };
+
+    // 分片内条目表按段增长: 第 k 段容量为 FIRST_SEG << k, 段一旦分配就不再移动, 因此 resolve 可以无锁读取
+    enum : std::size_t {
+        FIRST_SEG_BITS = 10,
+        MAX_LOCAL_BITS = 32 - SHARD_BITS,
+        SEG_COUNT = MAX_LOCAL_BITS - FIRST_SEG_BITS + 1
+    };
+
+    struct Entry {
+        const Byte* ptr;
+        std::size_t len;
+    };
+
+    static std::size_t seg_of(std::uint32_t local, std::size_t& offset) {
+        const std::uint64_t v = static_cast<std::uint64_t>(local) + (std::uint64_t(1) << FIRST_SEG_BITS);
+        const std::size_t bits = 63 - detail::clz64(v);
+        offset = static_cast<std::size_t>(v - (std::uint64_t(1) << bits));
+        return bits - FIRST_SEG_BITS;
+    }
+
+    struct Shard {
+        mutable std::mutex mtx;
+        std::vector<std::uint64_t> table;
+        std::size_t used;
+        std::atomic<std::uint32_t> count;
+        std::atomic<Entry*> segs[SEG_COUNT];
+
+        std::vector<std::unique_ptr<Byte[]>> chunks;
+        Byte* cur;
+        std::size_t remain;
+        std::size_t chunk_size;
+        std::size_t arena_bytes;
+
+        Shard() : mtx(), table(), used(0), count(0), chunks(), cur(nullptr), remain(0), chunk_size(0), arena_bytes(0) {
+            for (std::size_t i = 0; i < SEG_COUNT; ++i) segs[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        Shard(const Shard&) = delete;
+        Shard& operator=(const Shard&) = delete;
+
+        ~Shard() {
+            for (std::size_t i = 0; i < SEG_COUNT; ++i) delete[] segs[i].load(std::memory_order_relaxed);
+        }
+
+        KAStr entry(std::uint32_t local) const {
+            std::size_t offset;
+            const std::size_t seg = seg_of(local, offset);
+            const Entry& e = segs[seg].load(std::memory_order_acquire)[offset];
+            return KAStr(e.ptr, e.len);
+        }
+
+        // 线性探测, 返回命中的槽位或应插入的空槽位; 调用方持有锁
+        std::size_t probe(const KAStr& str, std::uint64_t h) {
+            if (table.empty()) table.assign(64, 0);
+            return static_cast<const Shard*>(this)->probe(str, h);
+        }
+
+        std::size_t probe(const KAStr& str, std::uint64_t h) const {
+            const std::size_t mask = table.size() - 1;
+            const std::uint64_t tag = h & kTagMask;
+            std::size_t i = static_cast<std::size_t>(h) & mask;
+            while (true) {
+                const std::uint64_t slot = table[i];
+                if (slot == 0) return i;
+                if ((slot & kTagMask) == tag && entry(static_cast<std::uint32_t>(slot & kIdMask) - 1) == str) return i;
+                i = (i + 1) & mask;
+            }
+        }
+
+        void rehash() {
+            std::vector<std::uint64_t> old(table.size() * 2, 0);
+            old.swap(table);
+            const std::size_t mask = table.size() - 1;
+            for (std::uint64_t slot : old) {
+                if (slot == 0) continue;
+                const KAStr s = entry(static_cast<std::uint32_t>(slot & kIdMask) - 1);
+                std::size_t i = static_cast<std::size_t>(hash_bytes(s.data(), s.byte_size())) & mask;
+                while (table[i] != 0) i = (i + 1) & mask;
+                table[i] = slot;
+            }
+        }
+
+        const Byte* store_bytes(const KAStr& str) {
+            const std::size_t n = str.byte_size();
+            if (n == 0) return nullptr;
+            Byte* dst;
+            if (n > chunk_size / 4) { // 大字符串单独分配, 避免浪费当前块的剩余空间
+                chunks.emplace_back(new Byte[n]);
+                dst = chunks.back().get();
+                arena_bytes += n;
+            } else {
+                if (n > remain) {
+                    chunks.emplace_back(new Byte[chunk_size]);
+                    cur = chunks.back().get();
+                    remain = chunk_size;
+                    arena_bytes += chunk_size;
+                }
+                dst = cur;
+                cur += n;
+                remain -= n;
+            }
+            std::memcpy(dst, str.data(), n);
+            return dst;
+        }
+
+        std::uint32_t push(const KAStr& str) {
+            const std::uint32_t local = count.load(std::memory_order_relaxed);
+            if (local >= (std::uint32_t(1) << MAX_LOCAL_BITS) - 1) {
+                throw std::length_error("KAInterner: too many strings in one shard");
+            }
+            std::size_t offset;
+            const std::size_t seg = seg_of(local, offset);
+            Entry* block = segs[seg].load(std::memory_order_relaxed);
+            if (block == nullptr) {
+                block = new Entry[std::size_t(1) << (seg + FIRST_SEG_BITS)];
+                segs[seg].store(block, std::memory_order_release);
+            }
+            block[offset].ptr = store_bytes(str);
+            block[offset].len = str.byte_size();
+            count.store(local + 1, std::memory_order_release);
+            return local;
+        }
+    };
+
+    static id_type make_id(std::size_t shard_idx, std::uint64_t local) {
+        return static_cast<id_type>((local << SHARD_BITS) | shard_idx);
+    }
+
+    Shard shards_[SHARD_COUNT];
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
@@ -0,0 +1,597 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+namespace detail {
+// 需要转义的字节: '"'、'\\' 以及 0x00..0x1F
+inline bool json_needs_escape(Byte c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+// 从 i 开始第一个需要转义的字节, 没有则返回 n
+inline std::size_t json_find_escape(const Byte* p, std::size_t i, std::size_t n) {
+#ifdef KASTRING_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        // 无符号 v <= 0x1F 等价于 max(v, 0x1F) == 0x1F
+        const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+                                         _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask != 0) return i + ctz64(mask);
+    }
+#endif
+    while (i < n && ! json_needs_escape(p[i])) ++i;
+    return i;
+}
+
+// 64 字节一块的字符位掩码, 供 skip() 批量跳过容器
+struct JsonBlockMasks {
+    std::uint64_t quote;     // '"'
+    std::uint64_t backslash; // '\\'
+    std::uint64_t open;      // '{' 或 '['
+    std::uint64_t close;     // '}' 或 ']'
+};
+
+inline JsonBlockMasks json_classify_block(const Byte* p) {
+    JsonBlockMasks m = {0, 0, 0, 0};
+#ifdef KASTRING_SSE2
+    // '[' ']' 与 '{' '}' 只差 0x20, 或上 0x20 后各比较一次
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    for (unsigned k = 0; k < 4; ++k) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+        const __m128i folded = _mm_or_si128(v, lower);
+        const unsigned shift = 16 * k;
+        m.quote |= std::uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= std::uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, slash)))) << shift;
+        m.open |= std::uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, open)))) << shift;
+        m.close |= std::uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, close)))) << shift;
+    }
+#else
+    for (unsigned k = 0; k < 64; ++k) {
+        const Byte c = p[k];
+        const std::uint64_t bit = std::uint64_t(1) << k;
+        if (c == '"') m.quote |= bit;
+        if (c == '\\') m.backslash |= bit;
+        if (c == '{' || c == '[') m.open |= bit;
+        if (c == '}' || c == ']') m.close |= bit;
+    }
+#endif
+    return m;
+}
+
+// 被反斜杠转义的位置; carry 表示上一块以未转义的反斜杠结尾, 本块第 0 个字节被转义
+inline std::uint64_t json_escaped_mask(std::uint64_t backslash, std::uint64_t& carry) {
+    std::uint64_t escaped = carry;
+    std::uint64_t starts = backslash & ~carry;
+    carry = 0;
+    while (starts) {
+        const std::size_t bit = ctz64(starts);
+        starts &= starts - 1;
+        if (bit == 63) {
+            carry = 1;
+            break;
+        }
+        const std::uint64_t next = std::uint64_t(1) << (bit + 1);
+        escaped |= next;
+        starts &= ~next;
+    }
+    return escaped;
+}
+
+inline unsigned json_hex4(const Byte* p) {
+    unsigned v = 0;
+    for (std::size_t k = 0; k < 4; ++k) {
+        const Byte c = p[k];
+        const Byte lower = static_cast<Byte>(c | 0x20);
+        unsigned d;
+        if (c >= '0' && c <= '9') {
+            d = static_cast<unsigned>(c - '0');
+        } else if (lower >= 'a' && lower <= 'f') {
+            d = static_cast<unsigned>(lower - 'a' + 10);
+        } else {
+            return 0x10000; // 不合法
+        }
+        v = v << 4 | d;
+    }
+    return v;
+}
+
+inline void json_put_utf8(KAString& out, CodePoint cp) {
+    char buf[4];
+    std::size_t len;
+    if (cp < 0x80) {
+        buf[0] = static_cast<char>(cp);
+        len = 1;
+    } else if (cp < 0x800) {
+        buf[0] = static_cast<char>(0xC0 | (cp >> 6));
+        buf[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        len = 2;
+    } else if (cp < 0x10000) {
+        buf[0] = static_cast<char>(0xE0 | (cp >> 12));
+        buf[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        len = 3;
+    } else {
+        buf[0] = static_cast<char>(0xF0 | (cp >> 18));
+        buf[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        buf[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        buf[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        len = 4;
+    }
+    out.append(buf, len);
+}
+} // namespace detail
+
+/**
+ * @brief 把 s 按 JSON 字符串的规则转义后追加到 out, 不添加两侧的引号
+ *
+ * 只转义 '"'、'\\' 和控制字符, 其余字节(包括 UTF-8 多字节序列)原样复制
+ * 用 SSE2 一次检查 16 字节, 不需要转义的连续片段整段追加, 总开销与长度成线性关系
+ */
+inline void json_escape_to(KAString& out, const KAStr& s) {
+    static const char hex[] = "0123456789abcdef";
+    enum : std::size_t {
+        STAGE_BYTES = 512
+    };
+    const Byte* p = s.data();
+    const std::size_t n = s.byte_size();
+    out.reserve(out.byte_size() + n + 2);
+    // 短片段和转义序列先拼在栈上的缓冲区里, 避免每段都调用一次 append
+    char stage[STAGE_BYTES];
+    std::size_t used = 0;
+    std::size_t i = 0;
+    for (;;) {
+        const std::size_t j = detail::json_find_escape(p, i, n);
+        const std::size_t run = j - i;
+        // 缓冲区要留出 6 字节给随后的转义序列
+        if (used > STAGE_BYTES - 6 || run > STAGE_BYTES - 6 - used) {
+            out.append(stage, used);
+            used = 0;
+            if (run > STAGE_BYTES - 6) {
+                out.append(KAStr(p + i, run));
+            } else {
+                std::memcpy(stage, p + i, run);
+                used = run;
+            }
+        } else {
+            std::memcpy(stage + used, p + i, run);
+            used += run;
+        }
+        if (j == n) break;
+        const Byte c = p[j];
+        char* e = stage + used;
+        e[0] = '\\';
+        used += 2;
+        switch (c) {
+        case '"':
+            e[1] = '"';
+            break;
+        case '\\':
+            e[1] = '\\';
+            break;
+        case '\b':
+            e[1] = 'b';
+            break;
+        case '\f':
+            e[1] = 'f';
+            break;
+        case '\n':
+            e[1] = 'n';
+            break;
+        case '\r':
+            e[1] = 'r';
+            break;
+        case '\t':
+            e[1] = 't';
+            break;
+        default:
+            e[1] = 'u';
+            e[2] = '0';
+            e[3] = '0';
+            e[4] = hex[c >> 4];
+            e[5] = hex[c & 0xF];
+            used += 4;
+        }
+        i = j + 1;
+    }
+    out.append(stage, used);
+}
+
+/**
+ * @brief 把 JSON 字符串的内容(不含两侧引号)反转义后追加到 out
+ *
+ * 支持全部转义序列, \uXXXX 转为 UTF-8, 代理对合并为一个码点, 落单的代理项写入 U+FFFD
+ * 遇到不合法的转义时返回 false, 此时 out 中只有出错位置之前的内容
+ * 不含 '\\' 的片段用 memchr(各平台都有向量化实现)定位后整段追加
+ */
+inline bool json_unescape_to(KAString& out, const KAStr& s) {
+    const Byte* p = s.data();
+    const std::size_t n = s.byte_size();
+    out.reserve(out.byte_size() + n);
+    std::size_t i = 0;
+    while (i < n) {
+        const void* hit = std::memchr(p + i, '\\', n - i);
+        const std::size_t j = hit == nullptr ? n : static_cast<std::size_t>(static_cast<const Byte*>(hit) - p);
+        out.append(KAStr(p + i, j - i));
+        if (j == n) break;
+        if (j + 1 == n) return false;
+        i = j + 2;
+        switch (p[j + 1]) {
+        case '"':
+            out.append('"');
+            break;
+        case '\\':
+            out.append('\\');
+            break;
+        case '/':
+            out.append('/');
+            break;
+        case 'b':
+            out.append('\b');
+            break;
+        case 'f':
+            out.append('\f');
+            break;
+        case 'n':
+            out.append('\n');
+            break;
+        case 'r':
+            out.append('\r');
+            break;
+        case 't':
+            out.append('\t');
+            break;
+        case 'u': {
+            if (n - i < 4) return false;
+            CodePoint cp = detail::json_hex4(p + i);
+            if (cp > 0xFFFF) return false;
+            i += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                const unsigned low = n - i >= 6 && p[i] == '\\' && p[i + 1] == 'u' ? detail::json_hex4(p + i + 2) : 0;
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                } else {
+                    cp = ILL_CODEPOINT;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = ILL_CODEPOINT;
+            }
+            detail::json_put_utf8(out, cp);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+enum class JsonTokenKind : unsigned char {
+    ObjectBegin,
+    ObjectEnd,
+    ArrayBegin,
+    ArrayEnd,
+    Key,    // 对象的键, text 是引号内的原始内容
+    String, // text 是引号内的原始内容, escaped 为 true 时需要 json_unescape_to
+    Number, // text 是数字的原文, 可以直接交给 parse<double> / parse<long long>
+    True,
+    False,
+    Null,
+    End,  // 文档结束
+    Error // 语法错误, offset() 是出错的位置
+};
+
+struct KAJsonToken {
+    KAJsonToken() : kind(JsonTokenKind::End), text(), escaped(false) {}
+
+    JsonTokenKind kind;
+    KAStr text;   // 指向原文档
+    bool escaped; // 字符串中含有转义序列
+};
+
+/**
+ * @brief JSON 拉取式分词器: 每次 next() 返回一个记号, 不构建 DOM, 不复制字节
+ *
+ * KAJsonTokenizer json(doc);
+ * KAJsonToken tok;
+ * json.next(tok);                           // ObjectBegin
+ * if (json.find_key("id") && json.next(tok)) use(parse<long long>(tok.text));
+ *
+ * 会检查逗号、冒号、括号配对以及数字和字面量的语法; 字符串中的转义序列只在 json_unescape_to 时检查
+ * skip() 跳过整个对象或数组时只做括号计数与字符串边界识别, 每次处理 64 字节
+ */
+class KAJsonTokenizer {
+  public:
+    explicit KAJsonTokenizer(const KAStr& text) : text_(text), pos_(0), stack_(), state_(Value) {}
+
+    // 产出下一个记号; 到达结尾或出错时返回 false, 此时 tok.kind 为 End 或 Error
+    bool next(KAJsonToken& tok) {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        tok.escaped = false;
+        if (state_ == Failed) return fail(tok);
+        skip_space();
+
+        switch (state_) {
+        case Done:
+            if (pos_ != n) return fail(tok);
+            tok.kind = JsonTokenKind::End;
+            tok.text = KAStr();
+            return false;
+        case CommaOrClose:
+            if (pos_ < n && p[pos_] == ',') {
+                ++pos_;
+                skip_space();
+                return stack_.back() == '{' ? read_key(tok) : read_value(tok);
+            }
+            return read_close(tok);
+        case KeyOrClose:
+            if (pos_ < n && p[pos_] == '}') return read_close(tok);
+            return read_key(tok);
+        case ValueOrClose:
+            if (pos_ < n && p[pos_] == ']') return read_close(tok);
+            return read_value(tok);
+        default:
+            return read_value(tok);
+        }
+    }
+
+    /**
+     * @brief 跳过下一个值: 标量只读一个记号, 对象或数组整体跳过
+     *
+     * 通常在 Key 之后调用; 被跳过的容器内部只检查括号计数与字符串边界
+     */
+    bool skip() {
+        KAJsonToken tok;
+        if (! next(tok)) return false;
+        if (tok.kind != JsonTokenKind::ObjectBegin && tok.kind != JsonTokenKind::ArrayBegin) return true;
+
+        // simdjson 的做法: 每块先算出字符串内的区间, 区间外的括号用 popcount 整块计数,
+        // 只有深度可能在本块归零时才逐位查找结束位置
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        std::size_t depth = 1;
+        std::uint64_t in_string = 0;
+        std::uint64_t escape_carry = 0;
+        for (std::size_t i = pos_; i < n; i += 64) {
+            detail::JsonBlockMasks m;
+            if (n - i >= 64) {
+                m = detail::json_classify_block(p + i);
+            } else {
+                Byte tail[64] = {};
+                std::memcpy(tail, p + i, n - i);
+                m = detail::json_classify_block(tail);
+            }
+            const std::uint64_t escaped =
+                (m.backslash | escape_carry) != 0 ? detail::json_escaped_mask(m.backslash, escape_carry) : 0;
+            const std::uint64_t inside = detail::prefix_xor64(m.quote & ~escaped) ^ in_string;
+            in_string = (inside >> 63) ? ~std::uint64_t(0) : 0;
+            const std::uint64_t open = m.open & ~inside;
+            const std::uint64_t close = m.close & ~inside;
+            if (detail::popcount64(close) < depth) {
+                depth += detail::popcount64(open) - detail::popcount64(close);
+                continue;
+            }
+            for (std::uint64_t bits = open | close; bits; bits &= bits - 1) {
+                const std::uint64_t bit = bits & (0 - bits);
+                if (open & bit) {
+                    ++depth;
+                } else if (--depth == 0) {
+                    pos_ = i + detail::ctz64(bit) + 1;
+                    stack_.pop_back();
+                    after_value();
+                    return true;
+                }
+            }
+        }
+        pos_ = n;
+        return fail(tok);
+    }
+
+    /**
+     * @brief 在当前对象中找到原始内容等于 key 的键, 成功时停在它的值之前
+     *
+     * 在 ObjectBegin 或对象中的一个值之后调用; 不匹配的值用 skip() 跳过
+     * 找不到时返回 false, 此时对象的 ObjectEnd 已被读取
+     */
+    bool find_key(const KAStr& key) {
+        KAJsonToken tok;
+        while (next(tok)) {
+            if (tok.kind != JsonTokenKind::Key) return false;
+            if (tok.text == key) return true;
+            if (! skip()) return false;
+        }
+        return false;
+    }
+
+    // 已读取的字节数; 出错后是出错的位置
+    std::size_t offset() const {
+        return pos_;
+    }
+
+    // 当前所在的对象 / 数组嵌套层数
+    std::size_t depth() const {
+        return stack_.size();
+    }
+
+    bool failed() const {
+        return state_ == Failed;
+    }
+
+  private:
+    enum State : unsigned char {
+        Value,        // 需要一个值
+        ValueOrClose, // '[' 之后
+        KeyOrClose,   // '{' 之后
+        CommaOrClose, // 容器中的一个值之后
+        Done,         // 顶层的值已经结束
+        Failed
+    };
+
+    void skip_space() {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        while (pos_ < n && (p[pos_] == ' ' || p[pos_] == '\n' || p[pos_] == '\r' || p[pos_] == '\t')) ++pos_;
+    }
+
+    bool fail(KAJsonToken& tok) {
+        state_ = Failed;
+        tok.kind = JsonTokenKind::Error;
+        tok.text = KAStr();
+        return false;
+    }
+
+    void after_value() {
+        state_ = stack_.empty() ? Done : CommaOrClose;
+    }
+
+    bool emit(KAJsonToken& tok, JsonTokenKind kind, std::size_t begin, std::size_t end) {
+        tok.kind = kind;
+        tok.text = KAStr(text_.data() + begin, end - begin);
+        return true;
+    }
+
+    // i 是左引号之后的位置, 返回右引号的位置; 没有闭合或含有控制字符时返回 knpos
+    std::size_t scan_string(std::size_t i, bool& escaped) const {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        for (;;) {
+            i = detail::json_find_escape(p, i, n);
+            if (i == n || p[i] < 0x20) return knpos;
+            if (p[i] == '"') return i;
+            escaped = true;
+            i += 2;
+            if (i > n) return knpos;
+        }
+    }
+
+    bool read_string(KAJsonToken& tok, JsonTokenKind kind) {
+        const std::size_t begin = pos_ + 1;
+        const std::size_t end = scan_string(begin, tok.escaped);
+        if (end == knpos) return fail(tok);
+        pos_ = end + 1;
+        return emit(tok, kind, begin, end);
+    }
+
+    bool read_key(KAJsonToken& tok) {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        if (pos_ >= n || p[pos_] != '"') return fail(tok);
+        const std::size_t begin = pos_ + 1;
+        const std::size_t end = scan_string(begin, tok.escaped);
+        if (end == knpos) return fail(tok);
+        pos_ = end + 1;
+        skip_space();
+        if (pos_ >= n || p[pos_] != ':') return fail(tok);
+        ++pos_;
+        state_ = Value;
+        return emit(tok, JsonTokenKind::Key, begin, end);
+    }
+
+    bool read_close(KAJsonToken& tok) {
+        const Byte* p = text_.data();
+        if (pos_ >= text_.byte_size() || stack_.empty()) return fail(tok);
+        const Byte c = p[pos_];
+        const Byte open = stack_.back();
+        if (! ((c == '}' && open == '{') || (c == ']' && open == '['))) return fail(tok);
+        stack_.pop_back();
+        ++pos_;
+        after_value();
+        return emit(tok, c == '}' ? JsonTokenKind::ObjectEnd : JsonTokenKind::ArrayEnd, pos_ - 1, pos_);
+    }
+
+    bool read_literal(KAJsonToken& tok, const char* word, std::size_t len, JsonTokenKind kind) {
+        if (text_.byte_size() - pos_ < len || std::memcmp(text_.data() + pos_, word, len) != 0) return fail(tok);
+        pos_ += len;
+        after_value();
+        return emit(tok, kind, pos_ - len, pos_);
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool read_number(KAJsonToken& tok) {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        const std::size_t begin = pos_;
+        std::size_t i = pos_;
+        if (p[i] == '-') ++i;
+        if (i < n && p[i] == '0') {
+            ++i;
+        } else if (i < n && p[i] >= '1' && p[i] <= '9') {
+            while (i < n && p[i] >= '0' && p[i] <= '9') ++i;
+        } else {
+            pos_ = i;
+            return fail(tok);
+        }
+        if (i < n && p[i] == '.') {
+            const std::size_t digits = ++i;
+            while (i < n && p[i] >= '0' && p[i] <= '9') ++i;
+            if (i == digits) {
+                pos_ = i;
+                return fail(tok);
+            }
+        }
+        if (i < n && (p[i] | 0x20) == 'e') {
+            ++i;
+            if (i < n && (p[i] == '+' || p[i] == '-')) ++i;
+            const std::size_t digits = i;
+            while (i < n && p[i] >= '0' && p[i] <= '9') ++i;
+            if (i == digits) {
+                pos_ = i;
+                return fail(tok);
+            }
+        }
+        pos_ = i;
+        after_value();
+        return emit(tok, JsonTokenKind::Number, begin, i);
+    }
+
+    bool read_value(KAJsonToken& tok) {
+        const Byte* p = text_.data();
+        if (pos_ >= text_.byte_size()) return fail(tok);
+        const Byte c = p[pos_];
+        switch (c) {
+        case '{':
+        case '[':
+            stack_.push_back(c);
+            ++pos_;
+            state_ = c == '{' ? KeyOrClose : ValueOrClose;
+            return emit(tok, c == '{' ? JsonTokenKind::ObjectBegin : JsonTokenKind::ArrayBegin, pos_ - 1, pos_);
+        case '"':
+            if (! read_string(tok, JsonTokenKind::String)) return false;
+            after_value();
+            return true;
+        case 't':
+            return read_literal(tok, "true", 4, JsonTokenKind::True);
+        case 'f':
+            return read_literal(tok, "false", 5, JsonTokenKind::False);
+        case 'n':
+            return read_literal(tok, "null", 4, JsonTokenKind::Null);
+        default:
+            return read_number(tok);
+        }
+    }
+
+    KAStr text_;
+    std::size_t pos_;
+    std::vector<Byte> stack_; // 尚未闭合的 '{' / '['
+    State state_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
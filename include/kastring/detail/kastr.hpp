@@ -1,6 +1,8 @@
 #pragma once
 
 #include "base.hpp"
+#include "./parse_float.hpp"
+#include "./parse_int.hpp"
 #include <cstring>
 #include <stdexcept>
 #include <string>
@@ -9,6 +11,17 @@
 #include <vector>
 
 namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// fmt_to(char* buf, cap, ...) 的结果: size 是完整输出需要的字节数, written 是实际写入 buf 的字节数
+struct FormatResult {
+    std::size_t size;
+    std::size_t written;
+
+    bool truncated() const {
+        return written < size;
+    }
+};
+
 // ascii-only string, read-only and hasn't ownership
 class KAStr {
   public:
@@ -457,51 +470,43 @@ class KAStr {
     }
 
     long long to_longlong(int base = 10) const {
-        check_base(base);
-        return std::stoll(*this, nullptr, base);
+        return parse_or_throw<long long>(base, "KAString::to_longlong");
     }
 
     unsigned long long to_ulonglong(int base = 10) const {
-        check_base(base);
-        return std::stoull(*this, nullptr, base);
+        return parse_or_throw<unsigned long long>(base, "KAString::to_ulonglong");
     }
 
     long to_long(int base = 10) const {
-        check_base(base);
-        return std::stol(*this, nullptr, base);
+        return parse_or_throw<long>(base, "KAString::to_long");
     }
 
     unsigned long to_ulong(int base = 10) const {
-        check_base(base);
-        return std::stoul(*this, nullptr, base);
+        return parse_or_throw<unsigned long>(base, "KAString::to_ulong");
     }
 
     int to_int(int base = 10) const {
-        check_base(base);
-        return std::stoi(*this, nullptr, base);
+        return parse_or_throw<int>(base, "KAString::to_int");
     }
 
     unsigned int to_uint(int base = 10) const {
-        check_base(base);
-        return checked_numeric_cast<unsigned int>(to_ulong(base), "KAString::to_uint");
+        return parse_or_throw<unsigned int>(base, "KAString::to_uint");
     }
 
     short to_short(int base = 10) const {
-        check_base(base);
-        return checked_numeric_cast<short>(to_int(base), "KAString::to_short");
+        return parse_or_throw<short>(base, "KAString::to_short");
     }
 
     unsigned short to_ushort(int base = 10) const {
-        check_base(base);
-        return checked_numeric_cast<unsigned short>(to_uint(base), "KAString::to_ushort");
+        return parse_or_throw<unsigned short>(base, "KAString::to_ushort");
     }
 
     float to_float() const {
-        return std::stof(*this);
+        return parse_or_throw<float>("KAString::to_float");
     }
 
     double to_double() const {
-        return std::stod(*this);
+        return parse_or_throw<double>("KAString::to_double");
     }
 
     // kAString-related
@@ -514,6 +519,18 @@ class KAStr {
     template <typename... Args>
     KAString fmt(const Args&... args) const;
 
+    // 把格式化结果追加到 out 末尾, out 的已有容量可复用
+    template <typename... Args>
+    void fmt_to(KAString& out, const Args&... args) const;
+
+    // 写入定长缓冲区, 不追加 '\0', 超出 cap 的部分被丢弃
+    template <typename... Args>
+    FormatResult fmt_to(char* buf, std::size_t cap, const Args&... args) const;
+
+    // 只计算格式化结果的字节数, 不产生输出
+    template <typename... Args>
+    std::size_t formatted_size(const Args&... args) const;
+
     StyledKAStr style() const;
 
   private:
@@ -554,12 +571,22 @@ class KAStr {
         return result;
     }
 
-    template <typename Target, typename Source>
-    Target checked_numeric_cast(Source value, const char* context) const {
-        if (value < static_cast<Source>(std::numeric_limits<Target>::min()) ||
-            value > static_cast<Source>(std::numeric_limits<Target>::max()))
-            throw std::out_of_range(std::string(context) + ": out of range");
-        return static_cast<Target>(value);
+    // 与 std::stoll / std::stoull 的语法和结果相同(含 "-1" 转无符号数时取模), 但直接读取字节, 不构造临时 std::string
+    template <typename T>
+    T parse_or_throw(int base, const char* context) const {
+        check_base(base);
+        const ParseResult<T> r = detail::parse_integer<T>(data(), byte_size(), base, ParseMode::Lenient, true);
+        if (r.error == ParseError::Overflow) throw std::out_of_range(std::string(context) + ": out of range");
+        if (! r.ok()) throw std::invalid_argument(std::string(context) + ": invalid argument");
+        return r.value;
+    }
+
+    template <typename T>
+    T parse_or_throw(const char* context) const {
+        const ParseResult<T> r = detail::parse_float<T>(data(), byte_size(), ParseMode::Lenient);
+        if (r.error == ParseError::Overflow) throw std::out_of_range(std::string(context) + ": out of range");
+        if (! r.ok()) throw std::invalid_argument(std::string(context) + ": invalid argument");
+        return r.value;
     }
 
     void check_base(int base) const {
@@ -572,6 +599,7 @@ class KAStr {
     // 不拥有所有权
     ByteSpan data_;
 };
+} // namespace KASTRING_ABI_NAMESPACE
 } // namespace kastring
 
 namespace std {
@@ -8,13 +8,17 @@
 #include <stdexcept>
 #include <string>
 #include <ostream>
+#include <type_traits>
 #include <vector>
 
 #include "./kastr.hpp"
 #include "./sso.hpp"
+#include "./float_to_chars.hpp"
+#include "./to_chars.hpp"
 #include "./style.hpp"
 
 namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
 class KAString {
   public:
     KAString() : data_() {}
@@ -29,7 +33,8 @@ class KAString {
 
     KAString(std::initializer_list<Byte> vec) : data_(vec) {}
 
-    KAString(const KAStr& kastr) : data_(kastr.data(), kastr.byte_size()) {}
+    // KAStr 视图通常不以 '\0' 结尾, 不能走 SSOBytes(const Byte*, len) 的 strlen 调试检查
+    KAString(const KAStr& kastr) : data_(reinterpret_cast<const char*>(kastr.data()), kastr.byte_size()) {}
 
     // 拷贝构造/赋值, 移动构造/赋值, 析构
     KAString(const KAString&) = default;
@@ -273,6 +278,32 @@ class KAString {
         data_.reserve(cap);
     }
 
+    // 内容足够短时回到 SSO 并释放堆内存
+    void shrink_to_fit() {
+        data_.shrink_to_fit();
+    }
+
+    // 清空并释放全部容量
+    void release() {
+        data_.release();
+    }
+
+    std::size_t heap_bytes() const {
+        return data_.heap_bytes();
+    }
+
+    std::size_t footprint() const {
+        return sizeof(*this) + data_.heap_bytes();
+    }
+
+    static double growth_factor() {
+        return SSOBytes::growth_factor();
+    }
+
+    static void set_growth_factor(double factor) {
+        SSOBytes::set_growth_factor(factor);
+    }
+
     void reverse() {
         std::reverse(begin(), end());
     }
@@ -703,40 +734,48 @@ class KAString {
         return result;
     }
 
-    static KAString from_num(int n, int base = 10) {
-        char buf[64];
-        const char* digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    // 适用于所有整数类型, 负数输出为 '-' 加绝对值
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value, KAString>::type
+    from_num(T n, int base = 10) {
+        KAString result;
+        result.append_num(n, base);
+        return result;
+    }
 
+    // 原地追加整数的文本形式, 不产生临时对象
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value>::type
+    append_num(T n, int base = 10) {
         if (base < 2 || base > 36)
-            throw std::invalid_argument("KAString::fromNum(int, int), base must meet: 2 <= base <= 36, got " +
+            throw std::invalid_argument("KAString::append_num(), base must meet: 2 <= base <= 36, got " +
                                         std::to_string(base));
 
-        char* p = buf + sizeof(buf);
-        bool negative = (n < 0);
-        unsigned int u = negative ? -static_cast<unsigned int>(n) : static_cast<unsigned int>(n);
-
-        do {
-            *--p = digits[u % base];
-            u /= base;
-        } while (u > 0);
+        char buf[detail::INT_CHARS_MAX];
+        append(buf, detail::int_to_chars(buf, n, base));
+    }
 
-        if (negative) *--p = '-';
+    // 枚举按其底层整数类型输出, 而不是隐式转换成 double
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value, KAString>::type from_num(T n, int base = 10) {
+        return from_num(static_cast<typename std::underlying_type<T>::type>(n), base);
+    }
 
-        return KAString(p, static_cast<std::size_t>((buf + sizeof(buf)) - p));
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type append_num(T n, int base = 10) {
+        append_num(static_cast<typename std::underlying_type<T>::type>(n), base);
     }
 
+    // 与 printf 的 %.<precision><fmt> 输出一致, 但不经过 stdio
     static KAString from_num(double d, char fmt = 'g', int precision = 6) {
         if (fmt != 'f' && fmt != 'e' && fmt != 'g') {
             throw std::invalid_argument(
                 "KAString::fromNum(double, char, int), fmt only support `f`, `e` and `g`, got " + std::to_string(fmt));
         }
 
-        char fmt_buf[16];
-        char buf[128];
-
-        std::snprintf(fmt_buf, sizeof(fmt_buf), "%%.%d%c", precision, fmt);
-        std::snprintf(buf, sizeof(buf), fmt_buf, d);
-        return KAString(buf);
+        KAString result;
+        detail::format_float_precision(result, d, fmt, precision);
+        return result;
     }
 
     long long to_longlong(int base = 10) const {
@@ -812,6 +851,21 @@ class KAString {
         return as_kastr().fmt(args...);
     }
 
+    template <typename... Args>
+    void fmt_to(KAString& out, const Args&... args) const {
+        as_kastr().fmt_to(out, args...);
+    }
+
+    template <typename... Args>
+    FormatResult fmt_to(char* buf, std::size_t cap, const Args&... args) const {
+        return as_kastr().fmt_to(buf, cap, args...);
+    }
+
+    template <typename... Args>
+    std::size_t formatted_size(const Args&... args) const {
+        return as_kastr().formatted_size(args...);
+    }
+
     StyledKAStr style() const {
         return as_kastr().style();
     }
@@ -988,6 +1042,7 @@ class KAString {
         throw std::invalid_argument("base must be in [2, 36], but got " + std::to_string(base));
     }
 };
+} // namespace KASTRING_ABI_NAMESPACE
 } // namespace kastring
 
 namespace std {
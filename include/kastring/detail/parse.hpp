@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "./kastr.hpp"
+#include "./parse_float.hpp"
+#include "./parse_int.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+/**
+ * @brief 在原地解析整数, 不分配内存, 不抛异常
+ *
+ * 支持所有整数类型(bool 除外)和 2..36 进制; 溢出时返回 ParseError::Overflow 而不是截断
+ * 10 进制走 SSE2 / SWAR 快速路径, 一次转换 16 / 8 位数字
+ */
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value, ParseResult<T> >::type
+parse(const KAStr& s, int base = 10, ParseMode mode = ParseMode::Strict) noexcept {
+    return detail::parse_integer<T>(s.data(), s.byte_size(), base, mode);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && ! std::is_same<T, bool>::value, ParseResult<T> >::type
+parse(const KAStr& s, ParseMode mode) noexcept {
+    return detail::parse_integer<T>(s.data(), s.byte_size(), 10, mode);
+}
+
+/**
+ * @brief 在原地解析 float / double, 不分配内存, 不抛异常, 不受 locale 影响
+ *
+ * 结果总是正确舍入; 支持小数、指数以及 inf / infinity / nan, 不支持十六进制浮点数
+ */
+template <typename T>
+typename std::enable_if<std::is_same<T, float>::value || std::is_same<T, double>::value, ParseResult<T> >::type
+parse(const KAStr& s, ParseMode mode = ParseMode::Strict) noexcept {
+    return detail::parse_float<T>(s.data(), s.byte_size(), mode);
+}
+
+// parse_column / parse_columns 中一个出错的字段
+struct ColumnError {
+    std::size_t row;    // 行号; parse_column 中是字段序号
+    std::size_t column; // 列号; parse_column 中总是 0
+    std::size_t offset; // 字段在 text 中的起始字节
+    ParseError error;
+};
+
+struct ColumnParseResult {
+    std::size_t rows;                // 写入每个输出 vector 的元素个数
+    std::vector<ColumnError> errors; // 为空表示全部字段都解析成功
+
+    bool ok() const {
+        return errors.empty();
+    }
+};
+
+namespace detail {
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, ParseResult<T> >::type
+column_parse_value(const Byte* p, std::size_t n) {
+    return parse_integer<T>(p, n, 10, ParseMode::Lenient);
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, ParseResult<T> >::type
+column_parse_value(const Byte* p, std::size_t n) {
+    return parse_float<T>(p, n, ParseMode::Lenient);
+}
+
+/**
+ * @brief 从 pos 开始解析一个字段并追加到 out, 返回字段结束的位置(分隔符或 n)
+ *
+ * 数字直接从缓冲区读取, 读完后只检查下一个字节是不是分隔符, 不需要先切分出字段
+ * 宽松模式允许数字两侧有空白(空白本身是分隔符时除外); 出错的字段写入 T()
+ */
+template <typename T>
+std::size_t column_parse_field(const Byte* p, std::size_t n, std::size_t pos, const ByteSet& delims, ParseMode mode,
+                               std::vector<T>& out, ParseError& error) {
+    std::size_t i = pos;
+    if (mode == ParseMode::Lenient) {
+        while (i < n && parse_is_space(p[i]) && ! delims.contains(p[i])) ++i;
+    }
+    error = ParseError::Ok;
+    if (i == n || delims.contains(p[i])) {
+        error = ParseError::Empty;
+        out.push_back(T());
+        return i;
+    }
+    if (parse_is_space(p[i])) {
+        error = ParseError::InvalidChar;
+    } else {
+        const ParseResult<T> r = column_parse_value<T>(p + i, n - i);
+        i += r.consumed;
+        error = r.error;
+        if (mode == ParseMode::Lenient) {
+            while (i < n && parse_is_space(p[i]) && ! delims.contains(p[i])) ++i;
+        }
+        if (error == ParseError::Ok && i < n && ! delims.contains(p[i])) error = ParseError::InvalidChar;
+        if (error == ParseError::Ok) {
+            out.push_back(r.value);
+            return i;
+        }
+    }
+    out.push_back(T());
+    while (i < n && ! delims.contains(p[i])) ++i;
+    return i;
+}
+
+inline std::size_t column_count_delims(const Byte* p, std::size_t n, const ByteSet& delims) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) count += delims.contains(p[i]) ? 1 : 0;
+    return count;
+}
+
+// parse_columns 的一列: 类型擦除后的输出 vector, 与 KAFormatTemplate::Column 的做法相同
+struct ColumnSink {
+    typedef std::size_t (*FieldFn)(const Byte*, std::size_t, std::size_t, const ByteSet&, ParseMode, void*,
+                                   ParseError&);
+    typedef void (*ReserveFn)(void*, std::size_t);
+
+    void* out;
+    FieldFn field;
+    ReserveFn reserve;
+};
+
+template <typename T>
+std::size_t column_sink_field(const Byte* p, std::size_t n, std::size_t pos, const ByteSet& delims, ParseMode mode,
+                              void* out, ParseError& error) {
+    return column_parse_field<T>(p, n, pos, delims, mode, *static_cast<std::vector<T>*>(out), error);
+}
+
+template <typename T>
+void column_sink_reserve(void* out, std::size_t extra) {
+    std::vector<T>& v = *static_cast<std::vector<T>*>(out);
+    v.reserve(v.size() + extra);
+}
+
+template <typename T>
+ColumnSink column_sink_of(std::vector<T>& out) {
+    ColumnSink sink = {&out, &column_sink_field<T>, &column_sink_reserve<T>};
+    return sink;
+}
+
+inline void column_report(ColumnParseResult& result, std::size_t row, std::size_t column, std::size_t offset,
+                          ParseError error) {
+    ColumnError e = {row, column, offset, error};
+    result.errors.push_back(e);
+}
+
+inline ColumnParseResult parse_columns_impl(const KAStr& text, const ByteSet& field_delims,
+                                            const ByteSet& row_delims, ParseMode mode, const ColumnSink* sinks,
+                                            std::size_t ncols) {
+    const Byte* p = text.data();
+    const std::size_t n = text.byte_size();
+    const ByteSet delims = field_delims | row_delims;
+    ColumnParseResult result = {0, std::vector<ColumnError>()};
+
+    const std::size_t rows_hint = column_count_delims(p, n, row_delims) + 1;
+    for (std::size_t c = 0; c < ncols; ++c) sinks[c].reserve(sinks[c].out, rows_hint);
+
+    std::size_t pos = 0;
+    while (pos < n) {
+        // 空行(包括 "\r\n" 中间的空位)不算一行
+        if (row_delims.contains(p[pos])) {
+            ++pos;
+            continue;
+        }
+        const std::size_t row = result.rows++;
+        std::size_t c = 0;
+        for (; c < ncols; ++c) {
+            ParseError error;
+            const std::size_t begin = pos;
+            pos = sinks[c].field(p, n, pos, delims, mode, sinks[c].out, error);
+            if (error != ParseError::Ok) column_report(result, row, c, begin, error);
+            // 行在最后一列之前就结束了, 剩下的列补 T() 并报告为空
+            if (pos == n || row_delims.contains(p[pos])) {
+                for (++c; c < ncols; ++c) {
+                    sinks[c].field(p, n, pos, delims, mode, sinks[c].out, error);
+                    column_report(result, row, c, pos, ParseError::Empty);
+                }
+                break;
+            }
+            if (c + 1 < ncols) ++pos;
+        }
+        // 多余的字段
+        if (pos < n && ! row_delims.contains(p[pos])) {
+            column_report(result, row, ncols, pos + 1, ParseError::InvalidChar);
+            while (pos < n && ! row_delims.contains(p[pos])) ++pos;
+        }
+    }
+    return result;
+}
+} // namespace detail
+
+/**
+ * @brief 把以 delims 分隔的数值字段依次解析并追加到 out, 切分与解析在同一遍扫描中完成
+ *
+ * 例如 parse_column<long>("1,2,3\n4", ",\n", out); 不会为字段构造 KAStr 或 std::string
+ * 先按分隔符个数为 out 预留空间; 末尾的分隔符不产生空字段
+ * 出错的字段(空字段、非法字符、溢出)写入 T() 并记录在返回值中, 不抛异常
+ */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value && ! std::is_same<T, bool>::value, ColumnParseResult>::type
+parse_column(const KAStr& text, const ByteSet& delims, std::vector<T>& out, ParseMode mode = ParseMode::Strict) {
+    const Byte* p = text.data();
+    const std::size_t n = text.byte_size();
+    ColumnParseResult result = {0, std::vector<ColumnError>()};
+    out.reserve(out.size() + detail::column_count_delims(p, n, delims) + 1);
+
+    std::size_t pos = 0;
+    while (pos < n) {
+        ParseError error;
+        const std::size_t end = detail::column_parse_field(p, n, pos, delims, mode, out, error);
+        if (error != ParseError::Ok) detail::column_report(result, result.rows, 0, pos, error);
+        ++result.rows;
+        pos = end + 1;
+    }
+    return result;
+}
+
+/**
+ * @brief 多列版本: row_delims 分隔行, field_delims 分隔行内的字段, 第 i 个字段追加到第 i 个 vector
+ *
+ * 例如 parse_columns("1,2.5\n2,3.5\n", ",", "\n", ids, values);
+ * 空行被跳过; 字段不足的行补 T() 并报告 Empty, 字段多余时报告 InvalidChar(column 为列数)
+ * 所有输出 vector 的长度始终保持一致
+ */
+template <typename... Ts>
+ColumnParseResult parse_columns(const KAStr& text, const ByteSet& field_delims, const ByteSet& row_delims,
+                                std::vector<Ts>&... outs) {
+    const detail::ColumnSink sinks[sizeof...(Ts)] = {detail::column_sink_of(outs)...};
+    return detail::parse_columns_impl(text, field_delims, row_delims, ParseMode::Strict, sinks, sizeof...(Ts));
+}
+
+template <typename... Ts>
+ColumnParseResult parse_columns(const KAStr& text, const ByteSet& field_delims, const ByteSet& row_delims,
+                                ParseMode mode, std::vector<Ts>&... outs) {
+    const detail::ColumnSink sinks[sizeof...(Ts)] = {detail::column_sink_of(outs)...};
+    return detail::parse_columns_impl(text, field_delims, row_delims, mode, sinks, sizeof...(Ts));
+}
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
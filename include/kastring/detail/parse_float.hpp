@@ -0,0 +1,904 @@
+#pragma once
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "base.hpp"
+#include "./parse_int.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+namespace detail {
+// 文本转浮点数, 不经过 strtod, 不受 locale 影响, 结果总是正确舍入(就近, 恰好一半时取偶)
+// 1. 不超过 2^mbits 的整数乘除 10 的小次幂时直接用浮点运算 (Clinger, 1990)
+// 2. 其余情况用 Eisel-Lemire 算法: 64 位尾数乘 128 位截断的 10^e, 能确定舍入方向时直接出结果
+// 3. 仍无法确定时(接近一半或有效数字超过 19 位), 退回十进制大数逐步移位的精确算法
+
+typedef std::uint64_t LemireSplit[2];
+
+enum : int {
+    LEMIRE_MIN_EXP10 = -348,
+    LEMIRE_MAX_EXP10 = 347
+};
+
+// 10^e 的最高 128 位(截断), e 从 LEMIRE_MIN_EXP10 开始, 低 64 位在前
+inline const LemireSplit* lemire_pow10_split() {
+    static const LemireSplit table[LEMIRE_MAX_EXP10 - LEMIRE_MIN_EXP10 + 1] = {
+        {1671618768450675795u, 18054884314459144840u}, {1044761730281672372u, 11284302696536965525u},
+        {5917638181279478369u, 14105378370671206906u}, {16620419763454123769u, 17631722963339008632u},
+        {10387762352158827356u, 11019826852086880395u}, {8373016921771146291u, 13774783565108600494u},
+        {1242899115359157055u, 17218479456385750618u}, {5388497965526861063u, 10761549660241094136u},
+        {6735622456908576329u, 13451937075301367670u}, {17642900107990496220u, 16814921344126709587u},
+        {8720969558280366185u, 10509325840079193492u}, {10901211947850457732u, 13136657300098991865u},
+        {18238200953240460069u, 16420821625123739831u}, {18316404623416369399u, 10263013515702337394u},
+        {13672133742415685941u, 12828766894627921743u}, {12478481159592219522u, 16035958618284902179u},
+        {5493207715531443249u, 10022474136428063862u}, {16089881681269079869u, 12528092670535079827u},
+        {15500666083158961933u, 15660115838168849784u}, {9687916301974351208u, 9787572398855531115u},
+        {7498209359040551106u, 12234465498569413894u}, {149389661945913074u, 15293081873211767368u},
+        {93368538716195671u, 9558176170757354605u}, {4728396691822632493u, 11947720213446693256u},
+        {5910495864778290617u, 14934650266808366570u}, {8305745933913819539u, 9334156416755229106u},
+        {1158810380537498616u, 11667695520944036383u}, {15283571030954036982u, 14584619401180045478u},
+        {9881091751837770420u, 18230774251475056848u}, {6175682344898606512u, 11394233907171910530u},
+        {16942974967978033949u, 14242792383964888162u}, {11955346673117766628u, 17803490479956110203u},
+        {5166248661484910190u, 11127181549972568877u}, {11069496845283525642u, 13908976937465711096u},
+        {13836871056604407053u, 17386221171832138870u}, {4036358391950366504u, 10866388232395086794u},
+        {14268820026792733938u, 13582985290493858492u}, {17836025033490917422u, 16978731613117323115u},
+        {8841672636718129437u, 10611707258198326947u}, {6440404777470273892u, 13264634072747908684u},
+        {8050505971837842365u, 16580792590934885855u}, {11949095260039733334u, 10362995369334303659u},
+        {10324683056622278764u, 12953744211667879574u}, {3682481783923072647u, 16192180264584849468u},
+        {11524923151806696212u, 10120112665365530917u}, {571095884476206553u, 12650140831706913647u},
+        {14548927910877421904u, 15812676039633642058u}, {13704765962725776594u, 9882922524771026286u},
+        {7907585416552444934u, 12353653155963782858u}, {661109733835780360u, 15442066444954728573u},
+        {2719036592861056677u, 9651291528096705358u}, {12622167777931096654u, 12064114410120881697u},
+        {1942651667131707105u, 15080143012651102122u}, {5825843310384704845u, 9425089382906938826u},
+        {16505676174835656864u, 11781361728633673532u}, {2185351144835019464u, 14726702160792091916u},
+        {2731688931043774330u, 18408377700990114895u}, {8624834609543440812u, 11505236063118821809u},
+        {15392729280356688919u, 14381545078898527261u}, {5405853545163697437u, 17976931348623159077u},
+        {5684501474941004850u, 11235582092889474423u}, {2493940825248868159u, 14044477616111843029u},
+        {7729112049988473103u, 17555597020139803786u}, {9442381049670183593u, 10972248137587377366u},
+        {2579604275232953683u, 13715310171984221708u}, {3224505344041192104u, 17144137714980277135u},
+        {8932844867666826921u, 10715086071862673209u}, {15777742103010921555u, 13393857589828341511u},
+        {15110491610336264040u, 16742321987285426889u}, {2526528228819083169u, 10463951242053391806u},
+        {12381532322878629770u, 13079939052566739757u}, {1641857348316123500u, 16349923815708424697u},
+        {12555375888766046947u, 10218702384817765435u}, {11082533842530170780u, 12773377981022206794u},
+        {4629795266307937667u, 15966722476277758493u}, {5199465050656154994u, 9979201547673599058u},
+        {15722703350174969551u, 12474001934591998822u}, {10430007150863936130u, 15592502418239998528u},
+        {6518754469289960081u, 9745314011399999080u}, {8148443086612450102u, 12181642514249998850u},
+        {962181821410786819u, 15227053142812498563u}, {16742264702877599426u, 9516908214257811601u},
+        {7092772823314835570u, 11896135267822264502u}, {18089338065998320271u, 14870169084777830627u},
+        {8999993282035256217u, 9293855677986144142u}, {2026619565689294464u, 11617319597482680178u},
+        {11756646493966393888u, 14521649496853350222u}, {5472436080603216552u, 18152061871066687778u},
+        {8031958568804398249u, 11345038669416679861u}, {14651634229432885715u, 14181298336770849826u},
+        {9091170749936331336u, 17726622920963562283u}, {3376138709496513133u, 11079139325602226427u},
+        {18055231442152805128u, 13848924157002783033u}, {8733981247408842698u, 17311155196253478792u},
+        {5458738279630526686u, 10819471997658424245u}, {11435108867965546262u, 13524339997073030306u},
+        {5070514048102157020u, 16905424996341287883u}, {863228270850154185u, 10565890622713304927u},
+        {14914093393844856443u, 13207363278391631158u}, {9419244705451294746u, 16509204097989538948u},
+        {15110399977761835024u, 10318252561243461842u}, {9664627935347517973u, 12897815701554327303u},
+        {7469098900757009562u, 16122269626942909129u}, {16197401859041600736u, 10076418516839318205u},
+        {6411694268519837208u, 12595523146049147757u}, {12626303854077184414u, 15744403932561434696u},
+        {7891439908798240259u, 9840252457850896685u}, {14475985904425188227u, 12300315572313620856u},
+        {18094982380531485284u, 15375394465392026070u}, {6697677969404790399u, 9609621540870016294u},
+        {17595469498610763806u, 12012026926087520367u}, {17382650854836066854u, 15015033657609400459u},
+        {8558313775058847832u, 9384396036005875287u}, {6086206200396171886u, 11730495045007344109u},
+        {12219443768922602761u, 14663118806259180136u}, {15274304711153253452u, 18328898507823975170u},
+        {14158126462898171311u, 11455561567389984481u}, {3862600023340550427u, 14319451959237480602u},
+        {14051622066030463842u, 17899314949046850752u}, {8782263791269039901u, 11187071843154281720u},
+        {10977829739086299876u, 13983839803942852150u}, {4498915137003099037u, 17479799754928565188u},
+        {12035193997481712706u, 10924874846830353242u}, {5820620459997365075u, 13656093558537941553u},
+        {11887461593424094248u, 17070116948172426941u}, {9735506505103752857u, 10668823092607766838u},
+        {2946011094524915263u, 13336028865759708548u}, {3682513868156144079u, 16670036082199635685u},
+        {4607414176811284001u, 10418772551374772303u}, {1147581702586717097u, 13023465689218465379u},
+        {15269535183515560084u, 16279332111523081723u}, {7237616480483531100u, 10174582569701926077u},
+        {13658706619031801779u, 12718228212127407596u}, {17073383273789752224u, 15897785265159259495u},
+        {17588393573759676996u, 9936115790724537184u}, {3538747893490044629u, 12420144738405671481u},
+        {9035120885289943691u, 15525180923007089351u}, {12564479580947296663u, 9703238076879430844u},
+        {15705599476184120828u, 12129047596099288555u}, {15020313326802763131u, 15161309495124110694u},
+        {4776009810824339053u, 9475818434452569184u}, {5970012263530423816u, 11844773043065711480u},
+        {7462515329413029771u, 14805966303832139350u}, {52386062455755702u, 9253728939895087094u},
+        {9288854614924470436u, 11567161174868858867u}, {6999382250228200141u, 14458951468586073584u},
+        {8749227812785250177u, 18073689335732591980u}, {14691639419845557168u, 11296055834832869987u},
+        {13752863256379558556u, 14120069793541087484u}, {17191079070474448196u, 17650087241926359355u},
+        {8438581409832836170u, 11031304526203974597u}, {15159912780718433117u, 13789130657754968246u},
+        {9726518939043265588u, 17236413322193710308u}, {15302446373756816800u, 10772758326371068942u},
+        {9904685930341245193u, 13465947907963836178u}, {3157485376071780683u, 16832434884954795223u},
+        {8890957387685944783u, 10520271803096747014u}, {1890324697752655170u, 13150339753870933768u},
+        {2362905872190818963u, 16437924692338667210u}, {6088502188546649756u, 10273702932711667006u},
+        {16833999772538088003u, 12842128665889583757u}, {7207441660390446292u, 16052660832361979697u},
+        {16033866083812498692u, 10032913020226237310u}, {10818960567910847557u, 12541141275282796638u},
+        {4300328673033783639u, 15676426594103495798u}, {16522763475928278486u, 9797766621314684873u},
+        {6818396289628184396u, 12247208276643356092u}, {8522995362035230495u, 15309010345804195115u},
+        {3021029092058325107u, 9568131466127621947u}, {17611344420355070096u, 11960164332659527433u},
+        {8179122470161673908u, 14950205415824409292u}, {14335323580705822000u, 9343878384890255807u},
+        {13307468457454889596u, 11679847981112819759u}, {12022649553391224092u, 14599809976391024699u},
+        {10416625923311642211u, 18249762470488780874u}, {11122077220497164286u, 11406101544055488046u},
+        {4679224488766679549u, 14257626930069360058u}, {15072402647813125244u, 17822033662586700072u},
+        {9420251654883203278u, 11138771039116687545u}, {16387000587031392001u, 13923463798895859431u},
+        {15872064715361852097u, 17404329748619824289u}, {3002511419460075705u, 10877706092887390181u},
+        {8364825292752482535u, 13597132616109237726u}, {1232659579085827361u, 16996415770136547158u},
+        {14605470292210805812u, 10622759856335341973u}, {4421779809981343554u, 13278449820419177467u},
+        {915538744049291538u, 16598062275523971834u}, {5183897733458195115u, 10373788922202482396u},
+        {6479872166822743894u, 12967236152753102995u}, {3488154190101041964u, 16209045190941378744u},
+        {2180096368813151227u, 10130653244338361715u}, {16560178516298602746u, 12663316555422952143u},
+        {16088537126945865529u, 15829145694278690179u}, {7749492695127472003u, 9893216058924181362u},
+        {463493832054564196u, 12366520073655226703u}, {14414425345350368957u, 15458150092069033378u},
+        {13620701859271368502u, 9661343807543145861u}, {3190819268807046916u, 12076679759428932327u},
+        {17823582141290972357u, 15095849699286165408u}, {11139738838306857723u, 9434906062053853380u},
+        {13924673547883572154u, 11793632577567316725u}, {3570783879572301480u, 14742040721959145907u},
+        {18298537904747540562u, 18427550902448932383u}, {18354115218108294707u, 11517219314030582739u},
+        {18330958004207980480u, 14396524142538228424u}, {4466953431550423984u, 17995655178172785531u},
+        {486002885505321038u, 11247284486357990957u}, {5219189625309039202u, 14059105607947488696u},
+        {6523987031636299002u, 17573882009934360870u}, {17912549950054850588u, 10983676256208975543u},
+        {17779001419141175331u, 13729595320261219429u}, {8388693718644305452u, 17161994150326524287u},
+        {12160462601793772764u, 10726246343954077679u}, {10588892233814828051u, 13407807929942597099u},
+        {8624429273841147159u, 16759759912428246374u}, {778582277723329070u, 10474849945267653984u},
+        {973227847154161338u, 13093562431584567480u}, {1216534808942701673u, 16366953039480709350u},
+        {14595392310871352257u, 10229345649675443343u}, {13632554370161802418u, 12786682062094304179u},
+        {12429006944274865118u, 15983352577617880224u}, {7768129340171790699u, 9989595361011175140u},
+        {9710161675214738374u, 12486994201263968925u}, {16749388112445810871u, 15608742751579961156u},
+        {1244995533423855986u, 9755464219737475723u}, {15391302472061983695u, 12194330274671844653u},
+        {5404070034795315907u, 15242912843339805817u}, {14906758817815542202u, 9526820527087378635u},
+        {14021762503842039848u, 11908525658859223294u}, {8303831092947774002u, 14885657073574029118u},
+        {578208414664970847u, 9303535670983768199u}, {14557818573613377271u, 11629419588729710248u},
+        {18197273217016721589u, 14536774485912137810u}, {13523219484416126178u, 18170968107390172263u},
+        {15369541205401160717u, 11356855067118857664u}, {765182433041899281u, 14196068833898572081u},
+        {5568164059729762005u, 17745086042373215101u}, {5785945546544795205u, 11090678776483259438u},
+        {16455803970035769814u, 13863348470604074297u}, {6734696907262548556u, 17329185588255092872u},
+        {4209185567039092847u, 10830740992659433045u}, {9873167977226253963u, 13538426240824291306u},
+        {3118087934678041646u, 16923032801030364133u}, {4254647968387469981u, 10576895500643977583u},
+        {706623942056949572u, 13221119375804971979u}, {14718337982853350677u, 16526399219756214973u},
+        {11504804248497038125u, 10328999512347634358u}, {5157633273766521849u, 12911249390434542948u},
+        {6447041592208152311u, 16139061738043178685u}, {6335244004343789146u, 10086913586276986678u},
+        {17142427042284512241u, 12608641982846233347u}, {16816347784428252397u, 15760802478557791684u},
+        {1286845328412881940u, 9850501549098619803u}, {15443614715798266137u, 12313126936373274753u},
+        {5469460339465668959u, 15391408670466593442u}, {8030098730593431003u, 9619630419041620901u},
+        {14649309431669176658u, 12024538023802026126u}, {9088264752731695015u, 15030672529752532658u},
+        {10291851488884697288u, 9394170331095332911u}, {8253128342678483706u, 11742712913869166139u},
+        {5704724409920716729u, 14678391142336457674u}, {16354277549255671720u, 18347988927920572092u},
+        {998051431430019017u, 11467493079950357558u}, {10470936326142299579u, 14334366349937946947u},
+        {8476984389250486570u, 17917957937422433684u}, {14521487280136329914u, 11198723710889021052u},
+        {18151859100170412392u, 13998404638611276315u}, {18078137856785627587u, 17498005798264095394u},
+        {15910522178918405146u, 10936253623915059621u}, {6053094668365842720u, 13670317029893824527u},
+        {2954682317029915496u, 17087896287367280659u}, {17987577512639554849u, 10679935179604550411u},
+        {17872785872372055657u, 13349918974505688014u}, {13117610303610293764u, 16687398718132110018u},
+        {12810192458183821506u, 10429624198832568761u}, {2177682517447613171u, 13037030248540710952u},
+        {2722103146809516464u, 16296287810675888690u}, {6313000485183335694u, 10185179881672430431u},
+        {3279564588051781713u, 12731474852090538039u}, {17934513790346890853u, 15914343565113172548u},
+        {1985699082112030975u, 9946464728195732843u}, {16317181907922202431u, 12433080910244666053u},
+        {6561419329620589327u, 15541351137805832567u}, {11018416108653950185u, 9713344461128645354u},
+        {4549648098962661924u, 12141680576410806693u}, {10298746142130715309u, 15177100720513508366u},
+        {1825030320404309164u, 9485687950320942729u}, {6892973918932774359u, 11857109937901178411u},
+        {4004531380238580045u, 14821387422376473014u}, {16337890167931276240u, 9263367138985295633u},
+        {6587304654631931588u, 11579208923731619542u}, {17457502855144690293u, 14474011154664524427u},
+        {17210192550503474962u, 18092513943330655534u}, {6144684325637283947u, 11307821214581659709u},
+        {12292541425473992838u, 14134776518227074636u}, {15365676781842491048u, 17668470647783843295u},
+        {16521077016292638761u, 11042794154864902059u}, {16039660251938410547u, 13803492693581127574u},
+        {10826203278068237376u, 17254365866976409468u}, {15989749085647424168u, 10783978666860255917u},
+        {6152128301777116498u, 13479973333575319897u}, {12301846395648783526u, 16849966666969149871u},
+        {14606183024921571560u, 10531229166855718669u}, {4422670725869800738u, 13164036458569648337u},
+        {10140024425764638826u, 16455045573212060421u}, {8643358275316593218u, 10284403483257537763u},
+        {6192511825718353619u, 12855504354071922204u}, {7740639782147942024u, 16069380442589902755u},
+        {2532056854628769813u, 10043362776618689222u}, {12388443105140738074u, 12554203470773361527u},
+        {10873867862998534689u, 15692754338466701909u}, {9102010423587778132u, 9807971461541688693u},
+        {15989199047912110569u, 12259964326927110866u}, {10763126773035362404u, 15324955408658888583u},
+        {13644483260788183358u, 9578097130411805364u}, {17055604075985229198u, 11972621413014756705u},
+        {7484447039699372786u, 14965776766268445882u}, {9289465418239495895u, 9353610478917778676u},
+        {11611831772799369869u, 11692013098647223345u}, {679731660717048624u, 14615016373309029182u},
+        {10073036612751086588u, 18268770466636286477u}, {8601490892183123069u, 11417981541647679048u},
+        {10751863615228903837u, 14272476927059598810u}, {4216457482181353988u, 17840596158824498513u},
+        {14164500972431816002u, 11150372599265311570u}, {8482254178684994195u, 13937965749081639463u},
+        {5991131704928854840u, 17422457186352049329u}, {15273672361649004035u, 10889035741470030830u},
+        {9868718415206479236u, 13611294676837538538u}, {3112525982153323237u, 17014118346046923173u},
+        {4251171748059520975u, 10633823966279326983u}, {702278666647013314u, 13292279957849158729u},
+        {5489534351736154547u, 16615349947311448411u}, {1125115960621402640u, 10384593717069655257u},
+        {6018080969204141204u, 12980742146337069071u}, {2910915193077788601u, 16225927682921336339u},
+        {17960223060169475539u, 10141204801825835211u}, {17838592806784456520u, 12676506002282294014u},
+        {13074868971625794843u, 15845632502852867518u}, {3560107088838733872u, 9903520314283042199u},
+        {18285191916330581053u, 12379400392853802748u}, {4409745821703674700u, 15474250491067253436u},
+        {11979463175419572495u, 9671406556917033397u}, {1139270913992301907u, 12089258196146291747u},
+        {15259146697772541096u, 15111572745182864683u}, {7231123676894144233u, 9444732965739290427u},
+        {4427218577690292387u, 11805916207174113034u}, {14757395258967641292u, 14757395258967641292u},
+        {0u, 9223372036854775808u}, {0u, 11529215046068469760u},
+        {0u, 14411518807585587200u}, {0u, 18014398509481984000u},
+        {0u, 11258999068426240000u}, {0u, 14073748835532800000u},
+        {0u, 17592186044416000000u}, {0u, 10995116277760000000u},
+        {0u, 13743895347200000000u}, {0u, 17179869184000000000u},
+        {0u, 10737418240000000000u}, {0u, 13421772800000000000u},
+        {0u, 16777216000000000000u}, {0u, 10485760000000000000u},
+        {0u, 13107200000000000000u}, {0u, 16384000000000000000u},
+        {0u, 10240000000000000000u}, {0u, 12800000000000000000u},
+        {0u, 16000000000000000000u}, {0u, 10000000000000000000u},
+        {0u, 12500000000000000000u}, {0u, 15625000000000000000u},
+        {0u, 9765625000000000000u}, {0u, 12207031250000000000u},
+        {0u, 15258789062500000000u}, {0u, 9536743164062500000u},
+        {0u, 11920928955078125000u}, {0u, 14901161193847656250u},
+        {4611686018427387904u, 9313225746154785156u}, {5764607523034234880u, 11641532182693481445u},
+        {11817445422220181504u, 14551915228366851806u}, {5548434740920451072u, 18189894035458564758u},
+        {17302829768357445632u, 11368683772161602973u}, {7793479155164643328u, 14210854715202003717u},
+        {14353534962383192064u, 17763568394002504646u}, {4359273333062107136u, 11102230246251565404u},
+        {5449091666327633920u, 13877787807814456755u}, {2199678564482154496u, 17347234759768070944u},
+        {1374799102801346560u, 10842021724855044340u}, {1718498878501683200u, 13552527156068805425u},
+        {6759809616554491904u, 16940658945086006781u}, {6530724019560251392u, 10587911840678754238u},
+        {17386777061305090048u, 13234889800848442797u}, {7898413271349198848u, 16543612251060553497u},
+        {16465723340661719040u, 10339757656912845935u}, {15970468157399760896u, 12924697071141057419u},
+        {15351399178322313216u, 16155871338926321774u}, {4982938468024057856u, 10097419586828951109u},
+        {10840359103457460224u, 12621774483536188886u}, {4327076842467049472u, 15777218104420236108u},
+        {11927795063396681728u, 9860761315262647567u}, {10298057810818464256u, 12325951644078309459u},
+        {8260886245095692416u, 15407439555097886824u}, {5163053903184807760u, 9629649721936179265u},
+        {11065503397408397604u, 12037062152420224081u}, {18443565265187884909u, 15046327690525280101u},
+        {13833071299956122020u, 9403954806578300063u}, {12679653106517764621u, 11754943508222875079u},
+        {11237880364719817872u, 14693679385278593849u}, {212292400617608628u, 18367099231598242312u},
+        {132682750386005392u, 11479437019748901445u}, {4777539456409894645u, 14349296274686126806u},
+        {15195296357367144114u, 17936620343357658507u}, {7191217214140771119u, 11210387714598536567u},
+        {4377335499248575995u, 14012984643248170709u}, {10083355392488107898u, 17516230804060213386u},
+        {10913783138732455340u, 10947644252537633366u}, {4418856886560793367u, 13684555315672041708u},
+        {5523571108200991709u, 17105694144590052135u}, {10369760970266701674u, 10691058840368782584u},
+        {12962201212833377092u, 13363823550460978230u}, {6979379479186945558u, 16704779438076222788u},
+        {13585484211346616781u, 10440487148797639242u}, {7758483227328495169u, 13050608935997049053u},
+        {14309790052588006865u, 16313261169996311316u}, {18166990819722280098u, 10195788231247694572u},
+        {4261994450943298507u, 12744735289059618216u}, {5327493063679123134u, 15930919111324522770u},
+        {7941369183226839863u, 9956824444577826731u}, {5315025460606161924u, 12446030555722283414u},
+        {15867153862612478214u, 15557538194652854267u}, {7611128154919104931u, 9723461371658033917u},
+        {14125596212076269068u, 12154326714572542396u}, {17656995265095336336u, 15192908393215677995u},
+        {8729779031470891258u, 9495567745759798747u}, {6300537770911226168u, 11869459682199748434u},
+        {17099044250493808518u, 14836824602749685542u}, {6075216638131242420u, 9273015376718553464u},
+        {7594020797664053025u, 11591269220898191830u}, {269153960225290473u, 14489086526122739788u},
+        {336442450281613091u, 18111358157653424735u}, {7127805559067090038u, 11319598848533390459u},
+        {4298070930406474644u, 14149498560666738074u}, {14595960699862869113u, 17686873200833422592u},
+        {9122475437414293195u, 11054295750520889120u}, {11403094296767866494u, 13817869688151111400u},
+        {14253867870959833118u, 17272337110188889250u}, {13520353437777283602u, 10795210693868055781u},
+        {3065383741939440791u, 13494013367335069727u}, {17666787732706464701u, 16867516709168837158u},
+        {6430056314514152534u, 10542197943230523224u}, {8037570393142690668u, 13177747429038154030u},
+        {823590954573587527u, 16472184286297692538u}, {5126430365035880108u, 10295115178936057836u},
+        {6408037956294850135u, 12868893973670072295u}, {3398361426941174765u, 16086117467087590369u},
+        {13653190937906703988u, 10053823416929743980u}, {17066488672383379985u, 12567279271162179975u},
+        {16721424822051837077u, 15709099088952724969u}, {3533361486141316317u, 9818186930595453106u},
+        {13640073894531421205u, 12272733663244316382u}, {7826720331309500698u, 15340917079055395478u},
+        {280014188641050032u, 9588073174409622174u}, {9573389772656088348u, 11985091468012027717u},
+        {16578423234247498339u, 14981364335015034646u}, {5749828502977298558u, 9363352709384396654u},
+        {16410657665576399005u, 11704190886730495817u}, {6678264026688335045u, 14630238608413119772u},
+        {8347830033360418806u, 18287798260516399715u}, {2911550761636567802u, 11429873912822749822u},
+        {12862810488900485560u, 14287342391028437277u}, {2243455055843443238u, 17859177988785546597u},
+        {3708002419115845976u, 11161986242990966623u}, {23317005467419566u, 13952482803738708279u},
+        {13864204312116438170u, 17440603504673385348u}, {17888499731927549664u, 10900377190420865842u},
+        {13137252628054661272u, 13625471488026082303u}, {11809879766640938686u, 17031839360032602879u},
+        {14298703881791668535u, 10644899600020376799u}, {13261693833812197764u, 13306124500025470999u},
+        {11965431273837859301u, 16632655625031838749u}, {9784237555362356015u, 10395409765644899218u},
+        {3006924907348169211u, 12994262207056124023u}, {17593714189467375226u, 16242827758820155028u},
+        {1772699331562333708u, 10151767349262596893u}, {6827560182880305039u, 12689709186578246116u},
+        {8534450228600381299u, 15862136483222807645u}, {7639874402088932264u, 9913835302014254778u},
+        {326470965756389522u, 12392294127517818473u}, {5019774725622874806u, 15490367659397273091u},
+        {831516194300602802u, 9681479787123295682u}, {10262767279730529310u, 12101849733904119602u},
+        {3605087062808385830u, 15127312167380149503u}, {9170708441896323000u, 9454570104612593439u},
+        {6851699533943015846u, 11818212630765741799u}, {3952938399001381903u, 14772765788457177249u},
+        {13999801545444333449u, 9232978617785735780u}, {17499751931805416812u, 11541223272232169725u},
+        {8039631859474607303u, 14426529090290212157u}, {14661225842770647033u, 18033161362862765196u},
+        {18386638188586430203u, 11270725851789228247u}, {18371611717305649850u, 14088407314736535309u},
+        {9129456591349898601u, 17610509143420669137u}, {17235125415662156385u, 11006568214637918210u},
+        {12320534732722919674u, 13758210268297397763u}, {10788982397476261688u, 17197762835371747204u},
+        {15966486035277439363u, 10748601772107342002u}, {10734735507242023396u, 13435752215134177503u},
+        {8806733365625141341u, 16794690268917721879u}, {12421737381156795194u, 10496681418073576174u},
+        {6303799689591218185u, 13120851772591970218u}, {17103121648843798539u, 16401064715739962772u},
+        {1466078993672598279u, 10250665447337476733u}, {6444284760518135752u, 12813331809171845916u},
+        {8055355950647669691u, 16016664761464807395u}, {2728754459941099604u, 10010415475915504622u},
+        {12634315111781150314u, 12513019344894380777u}, {1957835834444274180u, 15641274181117975972u},
+        {10447019433382447170u, 9775796363198734982u}, {3835402254873283155u, 12219745453998418728u},
+        {4794252818591603944u, 15274681817498023410u}, {7608094030047140369u, 9546676135936264631u},
+        {4898431519131537557u, 11933345169920330789u}, {10734725417341809851u, 14916681462400413486u},
+        {2097517367411243253u, 9322925914000258429u}, {7233582727691441970u, 11653657392500323036u},
+        {9041978409614302462u, 14567071740625403795u}, {6690786993590490174u, 18208839675781754744u},
+        {4181741870994056359u, 11380524797363596715u}, {615491320315182544u, 14225655996704495894u},
+        {9992736187248753989u, 17782069995880619867u}, {3939617107816777291u, 11113793747425387417u},
+        {9536207403198359517u, 13892242184281734271u}, {7308573235570561493u, 17365302730352167839u},
+        {11485387299872682789u, 10853314206470104899u}, {9745048106413465582u, 13566642758087631124u},
+        {12181310133016831978u, 16958303447609538905u}, {695789805494438130u, 10598939654755961816u},
+        {869737256868047663u, 13248674568444952270u}, {10310543607939835386u, 16560843210556190337u},
+        {17973304801030866876u, 10350527006597618960u}, {4019886927579031980u, 12938158758247023701u},
+        {9636544677901177879u, 16172698447808779626u}, {10634526442115624078u, 10107936529880487266u},
+        {4069786015789754290u, 12634920662350609083u}, {475546501309804958u, 15793650827938261354u},
+        {4908902581746016003u, 9871031767461413346u}, {15359500264037295811u, 12338789709326766682u},
+        {9976003293191843956u, 15423487136658458353u}, {17764217104313372233u, 9639679460411536470u},
+        {12981899343536939483u, 12049599325514420588u}, {16227374179421174354u, 15061999156893025735u},
+        {17059637889779315827u, 9413749473058141084u}, {2877803288514593168u, 11767186841322676356u},
+        {3597254110643241460u, 14708983551653345445u}, {9108253656731439729u, 18386229439566681806u},
+        {1080972517029761926u, 11491393399729176129u}, {5962901664714590312u, 14364241749661470161u},
+        {12065313099320625794u, 17955302187076837701u}, {9846663696289085073u, 11222063866923023563u},
+        {7696643601933968437u, 14027579833653779454u}, {397432465562684739u, 17534474792067224318u},
+        {14083453346258841674u, 10959046745042015198u}, {8380944645968776284u, 13698808431302518998u},
+        {1252808770606194547u, 17123510539128148748u}, {10006377518483647400u, 10702194086955092967u},
+        {7896285879677171346u, 13377742608693866209u}, {14482043368023852087u, 16722178260867332761u},
+        {2133748077373825698u, 10451361413042082976u}, {2667185096717282123u, 13064201766302603720u},
+        {3333981370896602653u, 16330252207878254650u}, {6695424375237764562u, 10206407629923909156u},
+        {8369280469047205703u, 12758009537404886445u}, {15073286604736395033u, 15947511921756108056u},
+        {9420804127960246895u, 9967194951097567535u}, {7164319141522920715u, 12458993688871959419u},
+        {4343712908476262990u, 15573742111089949274u}, {7326506586225052273u, 9733588819431218296u},
+        {9158133232781315341u, 12166986024289022870u}, {2224294504121868368u, 15208732530361278588u},
+        {10613556101930943538u, 9505457831475799117u}, {17878631145841067327u, 11881822289344748896u},
+        {3901544858591782542u, 14852277861680936121u}, {13967680582688333849u, 9282673663550585075u},
+        {12847914709933029407u, 11603342079438231344u}, {16059893387416286759u, 14504177599297789180u},
+        {1628122660560806833u, 18130221999122236476u}, {10240948699705280078u, 11331388749451397797u},
+        {17412871893058988002u, 14164235936814247246u}, {12542717829468959195u, 17705294921017809058u},
+        {12450884661845487401u, 11065809325636130661u}, {1728547772024695539u, 13832261657045163327u},
+        {15995742770313033136u, 17290327071306454158u}, {5385653213018257806u, 10806454419566533849u},
+        {11343752534700210161u, 13508068024458167311u}, {9568004649947874797u, 16885085030572709139u},
+        {3674159897003727796u, 10553178144107943212u}, {4592699871254659745u, 13191472680134929015u},
+        {1129188820640936778u, 16489340850168661269u}, {3011586022114279438u, 10305838031355413293u},
+        {8376168546070237202u, 12882297539194266616u}, {10470210682587796502u, 16102871923992833270u},
+        {1932195658189984910u, 10064294952495520794u}, {11638616609592256945u, 12580368690619400992u},
+        {14548270761990321182u, 15725460863274251240u}, {9092669226243950738u, 9828413039546407025u},
+        {15977522551232326327u, 12285516299433008781u}, {6136845133758244197u, 15356895374291260977u},
+        {15364743254667372383u, 9598059608932038110u}, {9982557031479439671u, 11997574511165047638u},
+        {3254824252494523781u, 14996968138956309548u}, {11257637194663853171u, 9373105086847693467u},
+        {9460360474902428559u, 11716381358559616834u}, {2602078556773259891u, 14645476698199521043u},
+        {17087656251248738576u, 18306845872749401303u}, {17597314184671543466u, 11441778670468375814u},
+        {12773270693984653525u, 14302223338085469768u}, {15966588367480816906u, 17877779172606837210u},
+        {14590803748102898470u, 11173611982879273256u}, {18238504685128623088u, 13967014978599091570u},
+        {13574758819556003052u, 17458768723248864463u}, {15401753289863583763u, 10911730452030540289u},
+        {5417133557047315992u, 13639663065038175362u}, {15994788983163920798u, 17049578831297719202u},
+        {14608429132904838403u, 10655986769561074501u}, {4425478360848884291u, 13319983461951343127u},
+        {920161932633717460u, 16649979327439178909u}, {2880944217109767365u, 10406237079649486818u},
+        {12824552308241985014u, 13007796349561858522u}, {6807318348447705459u, 16259745436952323153u},
+        {15783789013848285672u, 10162340898095201970u}, {10506364230455581282u, 12702926122619002463u},
+        {8521269269642088699u, 15878657653273753079u}, {12243322321167387293u, 9924161033296095674u},
+        {6080780864604458308u, 12405201291620119593u}, {12212662099182960789u, 15506501614525149491u},
+        {5327070802775656541u, 9691563509078218432u}, {6658838503469570676u, 12114454386347773040u},
+        {8323548129336963345u, 15143067982934716300u}, {14425589617690377899u, 9464417489334197687u},
+        {13420301003685584469u, 11830521861667747109u}, {2940318199324816875u, 14788152327084683887u},
+        {8755227902219092403u, 9242595204427927429u}, {15555720896201253407u, 11553244005534909286u},
+        {10221279083396790951u, 14441555006918636608u}, {12776598854245988689u, 18051943758648295760u},
+        {7985374283903742931u, 11282464849155184850u}, {758345818024902856u, 14103081061443981063u},
+        {14782990327813292282u, 17628851326804976328u}, {9239368954883307676u, 11018032079253110205u},
+        {16160897212031522499u, 13772540099066387756u}, {1754377441329851508u, 17215675123832984696u},
+        {1096485900831157192u, 10759796952395615435u}, {15205665431321110202u, 13449746190494519293u},
+        {5172023733869224041u, 16812182738118149117u}, {5538357842881958977u, 10507614211323843198u},
+        {16146319340457224530u, 13134517764154803997u}, {6347841120289366950u, 16418147205193504997u},
+        {6273243709394548296u, 10261342003245940623u}, {3229868618315797466u, 12826677504057425779u},
+        {17872393828176910545u, 16033346880071782223u}, {18087775170251650946u, 10020841800044863889u},
+        {8774660907532399971u, 12526052250056079862u}, {1744954097560724156u, 15657565312570099828u},
+        {10313968347830228405u, 9785978320356312392u}, {12892460434787785506u, 12232472900445390490u},
+        {6892203506629956075u, 15290591125556738113u}, {15836842237712192307u, 9556619453472961320u},
+        {1349308723430688768u, 11945774316841201651u}, {15521693959570524672u, 14932217896051502063u},
+        {16618587752372659776u, 9332636185032188789u}, {6938176635183661008u, 11665795231290235987u},
+        {4061034775552188356u, 14582244039112794984u}, {5076293469440235445u, 18227805048890993730u},
+        {7784369436827535057u, 11392378155556871081u}, {14342147814461806725u, 14240472694446088851u},
+        {13315998749649870503u, 17800590868057611064u}, {8322499218531169064u, 11125369292536006915u},
+        {5791438004736573426u, 13906711615670008644u}, {7239297505920716783u, 17383389519587510805u},
+        {6830403950414141941u, 10864618449742194253u}, {13149690956445065330u, 13580773062177742816u},
+        {16437113695556331663u, 16975966327722178520u}, {10273196059722707289u, 10609978954826361575u},
+        {8229809056225996208u, 13262473693532951969u}, {14898947338709883164u, 16578092116916189961u},
+        {2394313059052595121u, 10361307573072618726u}, {12216263360670519709u, 12951634466340773407u},
+        {10658643182410761733u, 16189543082925966759u}, {13579181016647807939u, 10118464426828729224u},
+        {16973976270809759924u, 12648080533535911530u}, {11994098301657424097u, 15810100666919889413u},
+        {9802154447749584012u, 9881312916824930883u}, {7641007041259592112u, 12351641146031163604u},
+        {9551258801574490140u, 15439551432538954505u}, {17498751797052526097u, 9649719645336846565u},
+        {8038381691033493909u, 12062149556671058207u}, {5436291095364479483u, 15077686945838822759u}
+    };
+    return table;
+}
+
+template <typename T>
+struct FloatLayout;
+
+template <>
+struct FloatLayout<double> {
+    typedef std::uint64_t Bits;
+
+    enum : int {
+        MANT_BITS = 52,
+        EXP_BITS = 11,
+        BIAS = -1023,
+        EXACT_MAX_EXP10 = 22, // 10^22 是 double 能精确表示的最大 10 的幂
+        EXACT_MAX_INT_DIGITS = 15
+    };
+
+    static double pow10(int e) {
+        static const double table[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return table[e];
+    }
+};
+
+template <>
+struct FloatLayout<float> {
+    typedef std::uint32_t Bits;
+
+    enum : int {
+        MANT_BITS = 23,
+        EXP_BITS = 8,
+        BIAS = -127,
+        EXACT_MAX_EXP10 = 10,
+        EXACT_MAX_INT_DIGITS = 7
+    };
+
+    static float pow10(int e) {
+        static const float table[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        return table[e];
+    }
+};
+
+template <typename T>
+T float_from_bits(std::uint64_t bits) {
+    typedef typename FloatLayout<T>::Bits Bits;
+    const Bits b = static_cast<Bits>(bits);
+    T v;
+    std::memcpy(&v, &b, sizeof(v));
+    return v;
+}
+
+template <typename T>
+std::uint64_t float_sign_bit(bool negative) {
+    return negative ? std::uint64_t(1) << (FloatLayout<T>::MANT_BITS + FloatLayout<T>::EXP_BITS) : 0;
+}
+
+// 第一步: 尾数和 10 的幂都能精确表示时, 一次浮点乘除就是正确舍入的结果
+// 要求浮点运算不使用更高的中间精度(如 x87)
+template <typename T>
+bool float_clinger(std::uint64_t mantissa, std::int64_t exp10, bool negative, T& out) {
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    typedef FloatLayout<T> L;
+    if (mantissa >> L::MANT_BITS) return false;
+    T f = static_cast<T>(mantissa);
+    if (exp10 == 0) {
+    } else if (exp10 > 0 && exp10 <= L::EXACT_MAX_INT_DIGITS + L::EXACT_MAX_EXP10) {
+        // 指数较大但有效数字少时, 先把一部分 0 乘进整数部分
+        if (exp10 > L::EXACT_MAX_EXP10) {
+            f *= L::pow10(static_cast<int>(exp10 - L::EXACT_MAX_EXP10));
+            exp10 = L::EXACT_MAX_EXP10;
+        }
+        if (f > L::pow10(L::EXACT_MAX_INT_DIGITS)) return false;
+        f *= L::pow10(static_cast<int>(exp10));
+    } else if (exp10 < 0 && exp10 >= -L::EXACT_MAX_EXP10) {
+        f /= L::pow10(static_cast<int>(-exp10));
+    } else {
+        return false;
+    }
+    out = negative ? -f : f;
+    return true;
+#else
+    (void)mantissa;
+    (void)exp10;
+    (void)negative;
+    (void)out;
+    return false;
+#endif
+}
+
+// floor(e * log2(10)), |e| <= 348 时精确
+inline std::int64_t floor_log2_pow10(std::int64_t e) {
+    const std::int64_t p = 217706 * e;
+    return p >= 0 ? p / 65536 : -((-p + 65535) / 65536);
+}
+
+/**
+ * @brief 第二步: Eisel-Lemire 算法 (Daniel Lemire, "Number Parsing at a Gigabyte per Second", 2021)
+ *
+ * 返回 false 表示 128 位近似不足以确定舍入方向, 或结果是次正规数 / 溢出, 需要交给精确算法
+ */
+template <typename T>
+bool float_eisel_lemire(std::uint64_t mantissa, std::int64_t exp10, bool negative, T& out) {
+    typedef FloatLayout<T> L;
+    if (mantissa == 0) {
+        out = float_from_bits<T>(float_sign_bit<T>(negative));
+        return true;
+    }
+    if (exp10 < LEMIRE_MIN_EXP10 || exp10 > LEMIRE_MAX_EXP10) return false;
+
+    // 舍入前多保留 2 位(用于取偶和进位检测), 剩下的低位用来判断近似误差
+    const unsigned drop = 64 - L::MANT_BITS - 3;
+    const std::uint64_t drop_mask = (std::uint64_t(1) << drop) - 1;
+
+    const std::size_t clz = clz64(mantissa);
+    mantissa <<= clz;
+    std::uint64_t exp2 = static_cast<std::uint64_t>(floor_log2_pow10(exp10) + 64 - L::BIAS)
+                         - static_cast<std::uint64_t>(clz);
+
+    const LemireSplit& pow = lemire_pow10_split()[exp10 - LEMIRE_MIN_EXP10];
+    std::uint64_t x_hi;
+    std::uint64_t x_lo = umul128(mantissa, pow[1], x_hi);
+    // 截断误差可能影响舍入时, 再乘上 10^e 的低 64 位
+    if ((x_hi & drop_mask) == drop_mask && x_lo + mantissa < mantissa) {
+        std::uint64_t y_hi;
+        const std::uint64_t y_lo = umul128(mantissa, pow[0], y_hi);
+        std::uint64_t merged_hi = x_hi;
+        const std::uint64_t merged_lo = x_lo + y_hi;
+        if (merged_lo < x_lo) ++merged_hi;
+        if ((merged_hi & drop_mask) == drop_mask && merged_lo + 1 == 0 && y_lo + mantissa < mantissa) return false;
+        x_hi = merged_hi;
+        x_lo = merged_lo;
+    }
+
+    const unsigned msb = static_cast<unsigned>(x_hi >> 63);
+    std::uint64_t m = x_hi >> (msb + drop);
+    exp2 -= 1 ^ msb;
+
+    // 恰好落在两个可表示值中间, 近似值无法判断是否真的是一半
+    if (x_lo == 0 && (x_hi & drop_mask) == 0 && (m & 3) == 1) return false;
+
+    m += m & 1;
+    m >>= 1;
+    if (m >> (L::MANT_BITS + 1)) {
+        m >>= 1;
+        ++exp2;
+    }
+    // exp2 为 0 (次正规数) 或全 1 (溢出) 时交给精确算法
+    if (exp2 - 1 >= (std::uint64_t(1) << L::EXP_BITS) - 2) return false;
+
+    const std::uint64_t bits = (exp2 << L::MANT_BITS) | (m & ((std::uint64_t(1) << L::MANT_BITS) - 1));
+    out = float_from_bits<T>(bits | float_sign_bit<T>(negative));
+    return true;
+}
+
+enum : std::size_t {
+    // 精确算法保留的十进制位数, 超出部分只记录是否非零
+    DECIMAL_MAX_DIGITS = 800,
+    // 一次移位的最大位数, 保证 (9 << k) 加进位不会溢出 uint64_t
+    DECIMAL_MAX_SHIFT = 60
+};
+
+/**
+ * @brief 第三步用到的十进制大数: 值 = 0.d[0]d[1]...d[nd-1] * 10^dp
+ *
+ * 反复乘除 2 的幂把值缩放到 [0.5, 1), 再取出 mbits + 1 位整数, 与 Go strconv 的慢速路径相同
+ */
+struct ParseDecimal {
+    Byte d[DECIMAL_MAX_DIGITS]; // 0..9, 不是字符
+    std::size_t nd;
+    std::int64_t dp;
+    bool truncated; // d 之后还有非零数字
+};
+
+inline void decimal_trim(ParseDecimal& a) {
+    while (a.nd > 0 && a.d[a.nd - 1] == 0) --a.nd;
+    if (a.nd == 0) a.dp = 0;
+}
+
+// a *= 2^k
+inline void decimal_shl(ParseDecimal& a, unsigned k) {
+    Byte tmp[DECIMAL_MAX_DIGITS + 20];
+    std::size_t w = sizeof(tmp);
+    std::uint64_t n = 0;
+    for (std::size_t r = a.nd; r-- > 0;) {
+        n += static_cast<std::uint64_t>(a.d[r]) << k;
+        const std::uint64_t q = n / 10;
+        tmp[--w] = static_cast<Byte>(n - q * 10);
+        n = q;
+    }
+    while (n > 0) {
+        const std::uint64_t q = n / 10;
+        tmp[--w] = static_cast<Byte>(n - q * 10);
+        n = q;
+    }
+    std::size_t count = sizeof(tmp) - w;
+    a.dp += static_cast<std::int64_t>(count - a.nd);
+    if (count > DECIMAL_MAX_DIGITS) {
+        for (std::size_t i = w + DECIMAL_MAX_DIGITS; i < sizeof(tmp); ++i) {
+            if (tmp[i] != 0) a.truncated = true;
+        }
+        count = DECIMAL_MAX_DIGITS;
+    }
+    for (std::size_t k = 0; k < count; ++k) a.d[k] = tmp[w + k];
+    a.nd = count;
+    decimal_trim(a);
+}
+
+// a /= 2^k, 移出的低位写在末尾
+inline void decimal_shr(ParseDecimal& a, unsigned k) {
+    std::size_t r = 0;
+    std::size_t w = 0;
+    std::uint64_t n = 0;
+    // 先读入足够多的高位, 使第一次除法商非零
+    for (; (n >> k) == 0; ++r) {
+        if (r >= a.nd) {
+            if (n == 0) {
+                a.nd = 0;
+                a.dp = 0;
+                return;
+            }
+            while ((n >> k) == 0) {
+                n *= 10;
+                ++r;
+            }
+            break;
+        }
+        n = n * 10 + a.d[r];
+    }
+    a.dp -= static_cast<std::int64_t>(r) - 1;
+
+    const std::uint64_t mask = (std::uint64_t(1) << k) - 1;
+    for (; r < a.nd; ++r) {
+        const std::uint64_t digit = n >> k;
+        n &= mask;
+        a.d[w++] = static_cast<Byte>(digit);
+        n = n * 10 + a.d[r];
+    }
+    while (n > 0) {
+        const std::uint64_t digit = n >> k;
+        n &= mask;
+        if (w < DECIMAL_MAX_DIGITS) {
+            a.d[w++] = static_cast<Byte>(digit);
+        } else if (digit > 0) {
+            a.truncated = true;
+        }
+        n *= 10;
+    }
+    a.nd = w;
+    decimal_trim(a);
+}
+
+inline void decimal_shift(ParseDecimal& a, std::int64_t k) {
+    if (a.nd == 0) return;
+    for (; k > static_cast<std::int64_t>(DECIMAL_MAX_SHIFT); k -= DECIMAL_MAX_SHIFT) decimal_shl(a, DECIMAL_MAX_SHIFT);
+    for (; k < -static_cast<std::int64_t>(DECIMAL_MAX_SHIFT); k += DECIMAL_MAX_SHIFT) decimal_shr(a, DECIMAL_MAX_SHIFT);
+    if (k > 0) decimal_shl(a, static_cast<unsigned>(k));
+    if (k < 0) decimal_shr(a, static_cast<unsigned>(-k));
+}
+
+// 整数部分, 按小数部分就近舍入, 恰好一半时取偶; 调用方保证结果不超过 64 位
+inline std::uint64_t decimal_rounded_integer(const ParseDecimal& a) {
+    if (a.dp < 0) return 0;
+    std::uint64_t n = 0;
+    std::size_t i = 0;
+    const std::size_t dp = static_cast<std::size_t>(a.dp);
+    for (; i < dp && i < a.nd; ++i) n = n * 10 + a.d[i];
+    for (; i < dp; ++i) n *= 10;
+    if (dp < a.nd) {
+        bool up = a.d[dp] >= 5;
+        if (a.d[dp] == 5 && dp + 1 == a.nd && ! a.truncated) up = (n & 1) != 0;
+        if (up) ++n;
+    }
+    return n;
+}
+
+// 把 a 缩放到 [0.5, 1) 时每步移位的位数: powtab[i] 位移动后十进制小数点至多移动 i 位
+inline unsigned decimal_shift_for(std::int64_t dp) {
+    static const unsigned powtab[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+    return dp < 9 ? powtab[dp] : 27;
+}
+
+/**
+ * @brief 第三步: 精确算法, 返回不带符号位的 IEEE 位模式, 溢出时返回 inf
+ */
+template <typename T>
+std::uint64_t decimal_to_float_bits(ParseDecimal& a) {
+    typedef FloatLayout<T> L;
+    const std::int64_t exp_all_ones = (std::int64_t(1) << L::EXP_BITS) - 1;
+    const std::uint64_t inf_bits = static_cast<std::uint64_t>(exp_all_ones) << L::MANT_BITS;
+    // 明显上溢 / 下溢, 对 double 和 float 都成立
+    if (a.nd == 0 || a.dp < -330) return 0;
+    if (a.dp > 310) return inf_bits;
+
+    std::int64_t exp = 0;
+    while (a.dp > 0) {
+        const unsigned n = decimal_shift_for(a.dp);
+        decimal_shift(a, -static_cast<std::int64_t>(n));
+        exp += n;
+    }
+    while (a.dp < 0 || (a.dp == 0 && a.d[0] < 5)) {
+        const unsigned n = decimal_shift_for(-a.dp);
+        decimal_shift(a, n);
+        exp -= n;
+    }
+    // 现在值在 [0.5, 1), IEEE 的尾数在 [1, 2)
+    --exp;
+    // 小于最小正规指数时按次正规数处理
+    if (exp < L::BIAS + 1) {
+        decimal_shift(a, -(L::BIAS + 1 - exp));
+        exp = L::BIAS + 1;
+    }
+    if (exp - L::BIAS >= exp_all_ones) return inf_bits;
+
+    decimal_shift(a, 1 + L::MANT_BITS);
+    std::uint64_t mant = decimal_rounded_integer(a);
+    // 舍入进位到了 mbits + 2 位
+    if (mant == (std::uint64_t(2) << L::MANT_BITS)) {
+        mant >>= 1;
+        ++exp;
+        if (exp - L::BIAS >= exp_all_ones) return inf_bits;
+    }
+    // 最高位为 0 说明是次正规数, 指数字段为 0
+    if (! (mant & (std::uint64_t(1) << L::MANT_BITS))) exp = L::BIAS;
+    return (mant & ((std::uint64_t(1) << L::MANT_BITS) - 1))
+           | (static_cast<std::uint64_t>((exp - L::BIAS) & exp_all_ones) << L::MANT_BITS);
+}
+
+// 扫描得到的十进制数: 值约等于 mantissa * 10^exp10, 尾数区间 [mant_begin, mant_end) 供精确算法重新读取
+struct FloatScan {
+    std::uint64_t mantissa;
+    std::int64_t exp10;
+    std::int64_t explicit_exp;
+    std::size_t mant_begin;
+    std::size_t mant_end;
+    bool truncated;
+};
+
+inline void decimal_from_scan(ParseDecimal& a, const Byte* p, const FloatScan& scan) {
+    a.nd = 0;
+    a.dp = 0;
+    a.truncated = false;
+    std::int64_t significant = 0;
+    bool saw_dot = false;
+    for (std::size_t i = scan.mant_begin; i < scan.mant_end; ++i) {
+        if (p[i] == '.') {
+            saw_dot = true;
+            a.dp = significant;
+            continue;
+        }
+        const Byte digit = static_cast<Byte>(p[i] - '0');
+        // 小数点后的前导 0 只移动小数点, 小数点前的会被上面的赋值覆盖
+        if (digit == 0 && significant == 0) {
+            --a.dp;
+            continue;
+        }
+        ++significant;
+        if (a.nd < DECIMAL_MAX_DIGITS) {
+            a.d[a.nd++] = digit;
+        } else if (digit != 0) {
+            a.truncated = true;
+        }
+    }
+    if (! saw_dot) a.dp = significant;
+    a.dp += scan.explicit_exp;
+    decimal_trim(a);
+}
+
+// 大小写不敏感地匹配 word (word 为小写)
+inline bool float_match_word(const Byte* p, std::size_t n, std::size_t i, const char* word, std::size_t len) {
+    if (n - i < len) return false;
+    for (std::size_t k = 0; k < len; ++k) {
+        if ((p[i + k] | 0x20) != static_cast<Byte>(word[k])) return false;
+    }
+    return true;
+}
+
+template <typename T>
+ParseResult<T> float_special(const Byte* p, std::size_t n, std::size_t i, bool negative) {
+    typedef FloatLayout<T> L;
+    const std::uint64_t exp_bits = ((std::uint64_t(1) << L::EXP_BITS) - 1) << L::MANT_BITS;
+    if (float_match_word(p, n, i, "inf", 3)) {
+        i += float_match_word(p, n, i, "infinity", 8) ? 8 : 3;
+        ParseResult<T> r = {float_from_bits<T>(exp_bits | float_sign_bit<T>(negative)), ParseError::Ok, i};
+        return r;
+    }
+    if (float_match_word(p, n, i, "nan", 3)) {
+        i += 3;
+        // nan(n-char-sequence), 括号不完整时只读取 nan
+        if (i < n && p[i] == '(') {
+            std::size_t j = i + 1;
+            while (j < n && (p[j] == '_' || parse_digit(p[j]) < 36)) ++j;
+            if (j < n && p[j] == ')') i = j + 1;
+        }
+        const std::uint64_t quiet = std::uint64_t(1) << (L::MANT_BITS - 1);
+        ParseResult<T> r = {float_from_bits<T>(exp_bits | quiet | float_sign_bit<T>(negative)), ParseError::Ok, i};
+        return r;
+    }
+    return parse_fail<T>(ParseError::InvalidChar, i);
+}
+
+inline bool float_is_digit(Byte c) {
+    return static_cast<unsigned>(c) - '0' <= 9;
+}
+
+/**
+ * @brief parse<float/double> 与 KAStr::to_float / to_double 共用的解析核心
+ *
+ * 语法: [+-] (digits [. [digits]] | . digits) [(e|E) [+-] digits] | inf | infinity | nan [(chars)], 大小写不敏感
+ * 结果上溢为 inf 或非零值下溢为 0 时报告 ParseError::Overflow, value 仍是正确舍入后的 ±inf / ±0
+ */
+template <typename T>
+ParseResult<T> parse_float(const Byte* p, std::size_t n, ParseMode mode) {
+    std::size_t i = 0;
+    if (mode == ParseMode::Lenient) {
+        while (i < n && parse_is_space(p[i])) ++i;
+    }
+    if (i == n) return parse_fail<T>(ParseError::Empty, i);
+
+    bool negative = false;
+    if (p[i] == '+' || p[i] == '-') {
+        negative = p[i] == '-';
+        ++i;
+    }
+
+    FloatScan scan = {0, 0, 0, i, i, false};
+    std::size_t significant = 0; // 第一个非零数字起的位数
+    std::size_t kept = 0;        // 计入 mantissa 的位数
+    std::int64_t dp = 0;
+    bool saw_digit = false;
+    bool saw_dot = false;
+    for (; i < n; ++i) {
+        const Byte c = p[i];
+        if (c == '.') {
+            if (saw_dot) break;
+            saw_dot = true;
+            dp = static_cast<std::int64_t>(significant);
+            continue;
+        }
+        if (! float_is_digit(c)) break;
+        saw_digit = true;
+        if (c == '0' && significant == 0) {
+            --dp;
+            continue;
+        }
+        // 已经有有效数字时用 SWAR 一次吃 8 位
+        if (significant != 0 && kept + 8 <= DECIMAL_FAST_DIGITS && n - i >= 8) {
+            const std::uint64_t chunk = load_u64_le(p + i);
+            if (swar_is_eight_digits(chunk)) {
+                scan.mantissa = scan.mantissa * 100000000ull + swar_parse_eight_digits(chunk);
+                significant += 8;
+                kept += 8;
+                i += 7;
+                continue;
+            }
+        }
+        ++significant;
+        if (kept < DECIMAL_FAST_DIGITS) {
+            scan.mantissa = scan.mantissa * 10 + static_cast<unsigned>(c - '0');
+            ++kept;
+        } else if (c != '0') {
+            scan.truncated = true;
+        }
+    }
+    if (! saw_digit) {
+        // 没有数字时只可能是 inf / nan
+        if (! saw_dot) {
+            ParseResult<T> r = float_special<T>(p, n, i, negative);
+            if (r.ok() && mode == ParseMode::Strict && r.consumed != n) {
+                return parse_fail<T>(ParseError::InvalidChar, r.consumed);
+            }
+            return r;
+        }
+        return parse_fail<T>(ParseError::InvalidChar, i);
+    }
+    if (! saw_dot) dp = static_cast<std::int64_t>(significant);
+    scan.mant_end = i;
+
+    // 指数部分必须至少有一位数字, 否则 "1e" 只读取 "1"
+    if (i < n && (p[i] | 0x20) == 'e') {
+        std::size_t j = i + 1;
+        bool exp_negative = false;
+        if (j < n && (p[j] == '+' || p[j] == '-')) {
+            exp_negative = p[j] == '-';
+            ++j;
+        }
+        if (j < n && float_is_digit(p[j])) {
+            std::int64_t e = 0;
+            for (; j < n && float_is_digit(p[j]); ++j) {
+                if (e < 100000) e = e * 10 + (p[j] - '0');
+            }
+            scan.explicit_exp = exp_negative ? -e : e;
+            i = j;
+        }
+    }
+    if (mode == ParseMode::Strict && i != n) return parse_fail<T>(ParseError::InvalidChar, i);
+
+    scan.exp10 = dp + scan.explicit_exp - static_cast<std::int64_t>(kept);
+    T value = T(0);
+    bool done = false;
+    if (scan.mantissa == 0) {
+        value = negative ? -T(0) : T(0);
+        done = true;
+    } else if (! scan.truncated && float_clinger<T>(scan.mantissa, scan.exp10, negative, value)) {
+        done = true;
+    } else if (float_eisel_lemire<T>(scan.mantissa, scan.exp10, negative, value)) {
+        // 尾数被截断时, 真值在 mantissa 与 mantissa + 1 之间, 两端结果相同才能确定
+        T upper;
+        done = ! scan.truncated
+               || (float_eisel_lemire<T>(scan.mantissa + 1, scan.exp10, negative, upper) && upper == value);
+    }
+    if (! done) {
+        ParseDecimal a;
+        decimal_from_scan(a, p, scan);
+        value = float_from_bits<T>(decimal_to_float_bits<T>(a) | float_sign_bit<T>(negative));
+    }
+
+    const T abs_value = value < 0 ? -value : value;
+    const bool out_of_range = abs_value == std::numeric_limits<T>::infinity() || abs_value == T(0);
+    // 只有 mantissa 为 0 才是真正的 0, 此时不报告下溢
+    ParseResult<T> r = {value, out_of_range && scan.mantissa != 0 ? ParseError::Overflow : ParseError::Ok, i};
+    return r;
+}
+} // namespace detail
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
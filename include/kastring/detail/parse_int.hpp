@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "base.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// parse 的错误码
+enum class ParseError : unsigned char {
+    Ok = 0,
+    Empty,       // 没有可解析的字符
+    InvalidChar, // 缺少数字, 或严格模式下数字后还有多余字符; consumed 指向出错的字符
+    Overflow,    // 超出目标类型范围(含无符号类型遇到负数), value 饱和为最大/最小值
+    InvalidBase  // base 不在 [2, 36]
+};
+
+enum class ParseMode : unsigned char {
+    // 整个输入必须恰好是一个数: 不跳过空白, 不接受进制前缀, 不允许多余字符
+    Strict,
+    // 与 strtol 一致: 跳过前导空白, base 为 16 时接受 0x 前缀, 遇到第一个非数字字符即停止;
+    // 另外 base 为 2 时接受 C23 的 0b 前缀(旧的 strtol 不认)
+    Lenient
+};
+
+/**
+ * @brief parse<T> 的结果, 永远不会抛出异常
+ *
+ * consumed 是已读取的字节数(含前导空白、符号和前缀); 成功时 value 是解析结果
+ */
+template <typename T>
+struct ParseResult {
+    T value;
+    ParseError error;
+    std::size_t consumed;
+
+    bool ok() const {
+        return error == ParseError::Ok;
+    }
+
+    explicit operator bool() const {
+        return ok();
+    }
+};
+
+namespace detail {
+// 字符对应的数位值, 非数字返回 255; 大小写字母同为 10..35
+inline unsigned parse_digit(Byte c) {
+    if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+    const Byte lower = static_cast<Byte>(c | 0x20);
+    if (lower >= 'a' && lower <= 'z') return static_cast<unsigned>(lower - 'a' + 10);
+    return 255;
+}
+
+// 与 C 语言 isspace 在 "C" locale 下的集合一致
+inline bool parse_is_space(Byte c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// SWAR: 8 个字节是否全是 '0'..'9', 小端序下第一个字节在最低位
+inline bool swar_is_eight_digits(std::uint64_t v) {
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+           == 0x3333333333333333ull;
+}
+
+// SWAR: 8 位十进制数字转整数, 三次乘加把 8 个数位两两合并 (Lemire, 2018)
+inline std::uint32_t swar_parse_eight_digits(std::uint64_t v) {
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)))
+         + (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))))
+        >> 32;
+    return static_cast<std::uint32_t>(v);
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline std::uint64_t load_u64_le(const Byte* p) {
+    return __builtin_bswap64(load_u64(p));
+}
+#else
+inline std::uint64_t load_u64_le(const Byte* p) {
+    return load_u64(p);
+}
+#endif
+
+#ifdef KASTRING_SSE2
+// SSE2: 前 16 个字节中开头连续数字的个数
+inline std::size_t sse2_leading_digits16(const Byte* p) {
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // 有符号比较: >= 0x80 的字节是负数, 同样落在 '0' 之下
+    const __m128i bad = _mm_or_si128(_mm_cmplt_epi8(c, _mm_set1_epi8('0')), _mm_cmpgt_epi8(c, _mm_set1_epi8('9')));
+    return ctz64(static_cast<unsigned>(_mm_movemask_epi8(bad)) | 0x10000u);
+}
+
+// SSE2: 16 位十进制数字转整数, 调用方保证都是数字
+// 逐级用 pmaddwd 合并相邻数位: 1 -> 2 -> 4 -> 8 位, 最后两段 8 位在标量里拼接
+inline std::uint64_t sse2_parse_sixteen_digits(const Byte* p) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i d = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    const __m128i m10 = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+    const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(d, zero), m10);
+    const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), m10);
+    const __m128i m100 = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+    const __m128i four = _mm_madd_epi16(_mm_packs_epi32(lo, hi), m100);
+    const __m128i m10000 = _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+    const __m128i eight = _mm_madd_epi16(_mm_packs_epi32(four, four), m10000);
+    const std::uint64_t high = static_cast<std::uint32_t>(_mm_cvtsi128_si32(eight));
+    const std::uint64_t low = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(eight, 4)));
+    return high * 100000000ull + low;
+}
+#endif
+
+enum : std::size_t {
+    // 19 位十进制数一定放得下 uint64_t, 快速路径不需要溢出检查
+    DECIMAL_FAST_DIGITS = 19
+};
+
+/**
+ * @brief 读取开头至多 19 位十进制数字, 返回读取的位数, 数值写入 out
+ *
+ * 有 16 字节可读时先用 SSE2 一次转换 16 位, 再用 SWAR 一次 8 位, 剩下的逐字节处理
+ */
+inline std::size_t parse_decimal_prefix(const Byte* p, std::size_t n, std::uint64_t& out) {
+    std::uint64_t v = 0;
+    std::size_t k = 0;
+#ifdef KASTRING_SSE2
+    if (n >= 16) {
+        const std::size_t lead = sse2_leading_digits16(p);
+        if (lead == 16) {
+            v = sse2_parse_sixteen_digits(p);
+            k = 16;
+        } else if (lead < 8) {
+            // 短数字直接走标量尾部, 不再试探 SWAR
+            n = lead;
+        }
+    }
+#endif
+    while (k + 8 <= n && k + 8 <= DECIMAL_FAST_DIGITS) {
+        const std::uint64_t chunk = load_u64_le(p + k);
+        if (! swar_is_eight_digits(chunk)) break;
+        v = v * 100000000ull + swar_parse_eight_digits(chunk);
+        k += 8;
+    }
+    for (; k < n && k < DECIMAL_FAST_DIGITS; ++k) {
+        const unsigned d = static_cast<unsigned>(p[k]) - '0';
+        if (d > 9) break;
+        v = v * 10 + d;
+    }
+    out = v;
+    return k;
+}
+
+template <typename T>
+ParseResult<T> parse_fail(ParseError err, std::size_t consumed) {
+    ParseResult<T> r = {T(0), err, consumed};
+    return r;
+}
+
+// 对负数取模: 无符号类型里 -limit 仍然正确
+template <typename T, typename U>
+T parse_apply_sign(U mag, bool negative) {
+    return negative ? static_cast<T>(U(0) - mag) : static_cast<T>(mag);
+}
+
+/**
+ * @brief parse<T> 与 KAStr::to_* 共用的整数解析核心
+ *
+ * 无符号类型也接受负号: "-0" 是 0, 其余负数按溢出处理并饱和为 0
+ *
+ * stdlib_compat 供 KAStr::to_* 沿用 std::stoul 等的语义: 不认 0b 前缀;
+ * 与 unsigned long 等宽的无符号类型遇到负号时按模取反, "-1" 得到最大值
+ */
+template <typename T>
+ParseResult<T> parse_integer(const Byte* p, std::size_t n, int base, ParseMode mode, bool stdlib_compat = false) {
+    typedef typename std::make_unsigned<T>::type U;
+    if (base < 2 || base > 36) return parse_fail<T>(ParseError::InvalidBase, 0);
+
+    std::size_t i = 0;
+    if (mode == ParseMode::Lenient) {
+        while (i < n && parse_is_space(p[i])) ++i;
+    }
+    if (i == n) return parse_fail<T>(ParseError::Empty, i);
+
+    bool negative = false;
+    if (p[i] == '+' || p[i] == '-') {
+        negative = p[i] == '-';
+        ++i;
+    }
+
+    // 只有前缀后确实跟着数字时才吃掉前缀, "0x" 本身解析为 0
+    if (mode == ParseMode::Lenient && (base == 16 || (base == 2 && ! stdlib_compat)) && i + 2 < n && p[i] == '0') {
+        const Byte x = static_cast<Byte>(p[i + 1] | 0x20);
+        if (((base == 16 && x == 'x') || (base == 2 && x == 'b'))
+            && parse_digit(p[i + 2]) < static_cast<unsigned>(base)) {
+            i += 2;
+        }
+    }
+
+    const U max_pos = static_cast<U>(std::numeric_limits<T>::max());
+    const bool wrap_negative = stdlib_compat && ! std::is_signed<T>::value && sizeof(T) >= sizeof(unsigned long);
+    const U limit = ! negative || wrap_negative ? max_pos
+                    : std::is_signed<T>::value  ? static_cast<U>(max_pos + 1)
+                                                : U(0);
+    const U ubase = static_cast<U>(base);
+    const U cutoff = limit / ubase;
+    const unsigned cutlim = static_cast<unsigned>(limit % ubase);
+
+    const std::size_t digits_begin = i;
+    U mag = 0;
+    bool overflow = false;
+    if (base == 10) {
+        std::uint64_t head;
+        i += parse_decimal_prefix(p + i, n - i, head);
+        overflow = head > static_cast<std::uint64_t>(limit);
+        mag = static_cast<U>(head);
+    }
+    // 非 10 进制, 以及超过 19 位的十进制数, 逐位检查溢出
+    for (; i < n; ++i) {
+        const unsigned d = parse_digit(p[i]);
+        if (d >= static_cast<unsigned>(base)) break;
+        if (overflow || mag > cutoff || (mag == cutoff && d > cutlim)) {
+            overflow = true;
+            continue;
+        }
+        mag = static_cast<U>(mag * ubase + d);
+    }
+
+    if (i == digits_begin) return parse_fail<T>(ParseError::InvalidChar, i);
+    if (mode == ParseMode::Strict && i != n) return parse_fail<T>(ParseError::InvalidChar, i);
+    if (overflow) {
+        ParseResult<T> r = {negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max(),
+                            ParseError::Overflow, i};
+        return r;
+    }
+    ParseResult<T> r = {parse_apply_sign<T>(mag, negative), ParseError::Ok, i};
+    return r;
+}
+} // namespace detail
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
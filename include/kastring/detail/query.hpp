@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// 查询串中的一对 key=value, 都是指向原文本的视图, 未做百分号解码
+struct KAQueryPair {
+    KAQueryPair() : key(), value(), has_value(false) {}
+
+    KAStr key;
+    KAStr value;    // 没有 '=' 时为空
+    bool has_value; // 是否出现了键值分隔符, 用来区分 "a" 与 "a="
+};
+
+namespace detail {
+// 十六进制数位的值, 非十六进制返回 255
+inline unsigned query_hex_value(Byte c) {
+    if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+    const Byte lower = static_cast<Byte>(c | 0x20);
+    if (lower >= 'a' && lower <= 'f') return static_cast<unsigned>(lower - 'a' + 10);
+    return 255;
+}
+
+/**
+ * @brief 解码 p[0, n) 中的 %XX 与 '+', 写入 out 并返回写入的字节数, 输出不会比输入长
+ *
+ * 不合法的 %XX 原样保留(与 WHATWG URL 标准一致), 此时 ok 置为 false
+ */
+inline std::size_t query_decode(const Byte* p, std::size_t n, Byte* out, bool plus_as_space, bool& ok) {
+    std::size_t w = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Byte c = p[i];
+        if (c == '%') {
+            const unsigned hi = i + 2 < n ? query_hex_value(p[i + 1]) : 255;
+            const unsigned lo = hi != 255 ? query_hex_value(p[i + 2]) : 255;
+            if (lo != 255) {
+                c = static_cast<Byte>(hi << 4 | lo);
+                i += 2;
+            } else {
+                ok = false;
+            }
+        } else if (c == '+' && plus_as_space) {
+            c = ' ';
+        }
+        out[w++] = c;
+    }
+    return w;
+}
+} // namespace detail
+
+/**
+ * @brief 原地解析 a=1&b=two&c=%20x 这类键值列表, 不分配内存
+ *
+ * for (const KAQueryPair& kv : KAQueryParser(query)) use(kv.key, kv.value);
+ *
+ * 产出的 key / value 都是原始(未解码)视图, 需要时用 decode / decode_to 解码到调用方的缓冲区
+ * pair_seps 中的任一字节都分隔键值对(例如 "&;"); 空的键值对(如 "a=1&&b=2" 中间)被跳过
+ */
+class KAQueryParser {
+  public:
+    class const_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef KAQueryPair value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const KAQueryPair* pointer;
+        typedef const KAQueryPair& reference;
+
+        const_iterator() : parser_(nullptr), pos_(0), next_(0), pair_() {}
+
+        reference operator*() const {
+            return pair_;
+        }
+
+        pointer operator->() const {
+            return &pair_;
+        }
+
+        const_iterator& operator++() {
+            pos_ = next_;
+            next_ = parser_->next_pair(pos_, pair_);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old(*this);
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) {
+            return lhs.pos_ == rhs.pos_;
+        }
+
+        friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) {
+            return lhs.pos_ != rhs.pos_;
+        }
+
+      private:
+        friend class KAQueryParser;
+
+        const_iterator(const KAQueryParser* parser, std::size_t pos)
+            : parser_(parser), pos_(pos), next_(pos), pair_() {
+            if (pos_ != knpos) ++*this;
+        }
+
+        const KAQueryParser* parser_;
+        std::size_t pos_;  // 当前键值对的起点, 结束时为 knpos
+        std::size_t next_; // 下一次查找的起点
+        KAQueryPair pair_;
+    };
+
+    explicit KAQueryParser(const KAStr& text, const ByteSet& pair_seps = ByteSet('&'), char kv_sep = '=')
+        : text_(text), pair_seps_(pair_seps), kv_sep_(static_cast<Byte>(kv_sep)) {}
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, knpos);
+    }
+
+    /**
+     * @brief 找到第一个原始 key 等于 key 的键值对, 把原始 value 写入 value
+     *
+     * 逐个键值对只比较 key 的字节, 找到即停止, 不构造其余的键值对; key 按原始(未解码)形式比较
+     */
+    bool lookup(const KAStr& key, KAStr& value) const {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        const std::size_t klen = key.byte_size();
+        std::size_t pos = 0;
+        while (pos < n) {
+            if (klen <= n - pos && std::memcmp(p + pos, key.data(), klen) == 0) {
+                const std::size_t after = pos + klen;
+                if (after == n || pair_seps_.contains(p[after])) {
+                    if (klen != 0) {
+                        value = KAStr();
+                        return true;
+                    }
+                } else if (p[after] == kv_sep_) {
+                    const std::size_t end = find_pair_end(after + 1);
+                    value = KAStr(p + after + 1, end - after - 1);
+                    return true;
+                }
+            }
+            pos = find_pair_end(pos) + 1;
+        }
+        return false;
+    }
+
+    // lookup 的便捷版本, 找不到时返回空串
+    KAStr lookup(const KAStr& key) const {
+        KAStr value;
+        lookup(key, value);
+        return value;
+    }
+
+    // 原始文本是否需要解码(含有 '%' 或 '+')
+    static bool needs_decode(const KAStr& raw, bool plus_as_space = true) {
+        for (Byte c : raw) {
+            if (c == '%' || (c == '+' && plus_as_space)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 把 raw 解码到调用方提供的缓冲区 out, 返回写入的字节数
+     *
+     * out 至少要有 raw.byte_size() 字节; 不合法的 %XX 原样保留并返回 ok = false
+     */
+    static std::size_t decode_to(const KAStr& raw, char* out, bool& ok, bool plus_as_space = true) {
+        ok = true;
+        return detail::query_decode(raw.data(), raw.byte_size(), reinterpret_cast<Byte*>(out), plus_as_space, ok);
+    }
+
+    // 解码并追加到 out; 不需要解码时直接整段追加
+    static bool decode(const KAStr& raw, KAString& out, bool plus_as_space = true) {
+        if (! needs_decode(raw, plus_as_space)) {
+            out.append(raw);
+            return true;
+        }
+        const std::size_t n = raw.byte_size();
+        char small[256];
+        std::vector<char> large;
+        char* buf = small;
+        if (n > sizeof(small)) {
+            large.resize(n);
+            buf = large.data();
+        }
+        bool ok = true;
+        out.append(buf, decode_to(raw, buf, ok, plus_as_space));
+        return ok;
+    }
+
+  private:
+    // pos 所在键值对的结束位置(分隔符或文本末尾)
+    std::size_t find_pair_end(std::size_t pos) const {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        while (pos < n && ! pair_seps_.contains(p[pos])) ++pos;
+        return pos;
+    }
+
+    // 从 pos 开始读取下一个非空的键值对写入 pair, 返回其后的查找起点; 没有时返回 knpos
+    std::size_t next_pair(std::size_t& pos, KAQueryPair& pair) const {
+        const Byte* p = text_.data();
+        const std::size_t n = text_.byte_size();
+        while (pos < n && pair_seps_.contains(p[pos])) ++pos;
+        if (pos >= n) {
+            pos = knpos;
+            return knpos;
+        }
+        const std::size_t end = find_pair_end(pos);
+        const void* eq = std::memchr(p + pos, kv_sep_, end - pos);
+        if (eq == nullptr) {
+            pair.key = KAStr(p + pos, end - pos);
+            pair.value = KAStr();
+            pair.has_value = false;
+        } else {
+            const std::size_t k = static_cast<std::size_t>(static_cast<const Byte*>(eq) - p);
+            pair.key = KAStr(p + pos, k - pos);
+            pair.value = KAStr(p + k + 1, end - k - 1);
+            pair.has_value = true;
+        }
+        return end;
+    }
+
+    KAStr text_;
+    ByteSet pair_seps_;
+    Byte kv_sep_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
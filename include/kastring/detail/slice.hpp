@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// 拥有所有权的子串: 多个切片共享同一个父缓冲区, 切片本身只记录 offset 和 len
+// 取切片是 O(1) 的, 不发生任何拷贝; 父缓冲区在最后一个切片析构时释放
+class KASlice {
+  public:
+    KASlice() : buf_(), offset_(0), len_(0) {}
+
+    // 接管 str 作为父缓冲区, 传入右值可避免拷贝
+    explicit KASlice(KAString str)
+        : buf_(std::make_shared<const KAString>(std::move(str))), offset_(0), len_(buf_->byte_size()) {}
+
+    explicit KASlice(const KAStr& str) : KASlice(KAString(str)) {}
+
+    explicit KASlice(const char* cstr) : KASlice(KAString(cstr)) {}
+
+    bool empty() const {
+        return len_ == 0;
+    }
+
+    std::size_t byte_size() const {
+        return len_;
+    }
+
+    const Byte* data() const {
+        return buf_ ? buf_->data() + offset_ : nullptr;
+    }
+
+    const Byte* begin() const {
+        return data();
+    }
+
+    const Byte* end() const {
+        return data() + len_;
+    }
+
+    Byte operator[](std::size_t idx) const {
+        if (idx >= len_) throw std::out_of_range("KASlice::operator[] index out of bounds");
+        return data()[idx];
+    }
+
+    KAStr as_kastr() const {
+        return KAStr(data(), len_);
+    }
+
+    operator KAStr() const {
+        return as_kastr();
+    }
+
+    operator std::string() const {
+        return std::string(reinterpret_cast<const char*>(data()), len_);
+    }
+
+    // 与 KAStr::substr 语义一致: start 越界返回空切片, count 超出则截断
+    KASlice substr(std::size_t start, std::size_t count) const {
+        if (start > len_) return KASlice();
+        count = std::min(count, len_ - start);
+        return KASlice(buf_, offset_ + start, count);
+    }
+
+    KASlice substr(std::size_t start) const {
+        if (start >= len_) return KASlice();
+        return substr(start, len_ - start);
+    }
+
+    // [start, end)
+    KASlice subrange(std::size_t start, std::size_t end) const {
+        if (start >= end) return KASlice();
+        return substr(start, end - start);
+    }
+
+    KASlice subrange(std::size_t start) const {
+        return subrange(start, len_);
+    }
+
+    // 把一个指向本切片内部的 KAStr(例如 split/trim 的结果) 提升为共享同一父缓冲区的切片
+    KASlice slice_of(const KAStr& view) const {
+        if (view.empty()) return KASlice();
+        if (view.begin() < begin() || view.end() > end()) {
+            throw std::out_of_range("KASlice::slice_of(): view does not point into this slice");
+        }
+        return KASlice(buf_, offset_ + static_cast<std::size_t>(view.begin() - begin()), view.byte_size());
+    }
+
+    // 父缓冲区的字节数, 即本切片实际钉住的内存
+    std::size_t parent_size() const {
+        return buf_ ? buf_->byte_size() : 0;
+    }
+
+    // 共享同一父缓冲区的切片数量
+    long use_count() const {
+        return buf_.use_count();
+    }
+
+    bool is_compact() const {
+        return len_ == parent_size();
+    }
+
+    // 小切片钉住大父缓冲区时, 将自身内容拷贝到独立的缓冲区并放开父缓冲区
+    KASlice& compact() {
+        if (is_compact()) return *this;
+        KASlice tmp(own());
+        swap(tmp);
+        return *this;
+    }
+
+    KAString own() const {
+        return KAString(as_kastr());
+    }
+
+    void swap(KASlice& other) noexcept {
+        buf_.swap(other.buf_);
+        std::swap(offset_, other.offset_);
+        std::swap(len_, other.len_);
+    }
+
+    friend void swap(KASlice& lhs, KASlice& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    friend bool operator==(const KASlice& lhs, const KASlice& rhs) {
+        return lhs.as_kastr() == rhs.as_kastr();
+    }
+
+    friend bool operator!=(const KASlice& lhs, const KASlice& rhs) {
+        return ! (lhs == rhs);
+    }
+
+    friend bool operator==(const KASlice& lhs, const KAStr& rhs) {
+        return lhs.as_kastr() == rhs;
+    }
+
+    friend bool operator!=(const KASlice& lhs, const KAStr& rhs) {
+        return ! (lhs == rhs);
+    }
+
+    friend bool operator==(const KASlice& lhs, const char* rhs) {
+        return lhs.as_kastr() == KAStr(rhs);
+    }
+
+    friend bool operator!=(const KASlice& lhs, const char* rhs) {
+        return ! (lhs == rhs);
+    }
+
+    friend bool operator<(const KASlice& lhs, const KASlice& rhs) {
+        return lhs.as_kastr() < rhs.as_kastr();
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const KASlice& s) {
+        return os.write(reinterpret_cast<const char*>(s.data()), s.byte_size());
+    }
+
+  private:
+    KASlice(const std::shared_ptr<const KAString>& buf, std::size_t offset, std::size_t len)
+        : buf_(len == 0 ? std::shared_ptr<const KAString>() : buf), offset_(len == 0 ? 0 : offset), len_(len) {}
+
+    std::shared_ptr<const KAString> buf_;
+    std::size_t offset_;
+    std::size_t len_;
+};
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
+
+namespace std {
+template <>
+struct hash<kastring::KASlice> {
+    std::size_t operator()(const kastring::KASlice& s) const {
+        return std::hash<kastring::KAStr>()(s.as_kastr());
+    }
+};
+} // namespace std
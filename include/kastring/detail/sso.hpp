@@ -1,18 +1,25 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include "base.hpp"
+#include "./sso_stats.hpp"
 
 namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
 class SSOBytes {
   public:
     enum : std::size_t {
-        HEAP_VIEW_SIZE = sizeof(std::vector<Byte>) + sizeof(uint8_t),
+        HEAP_VIEW_SIZE = sizeof(detail::SSOHeapVec) + sizeof(uint8_t),
         SSO_CAPACITY = HEAP_VIEW_SIZE - 1
     };
 
@@ -21,6 +28,10 @@ class SSOBytes {
         kHeapFlag = 0x80
     };
 
+    // 开启 KASTRING_SSO_STATS 时为带计数分配器的 vector, 否则就是 std::vector<Byte>
+    // 两种配置的布局不同, 所有翻译单元必须一致 (见 sso_stats.hpp)
+    typedef detail::SSOHeapVec HeapVec;
+
     union {
         struct {
             Byte data[SSO_CAPACITY];
@@ -28,36 +39,110 @@ class SSOBytes {
         } sso;
 
         struct {
-            std::vector<Byte> vec;
+            HeapVec vec;
             uint8_t tag;
         } heap;
     };
 
-    void promote_to_heap() {
-        if (! is_sso()) return;
-        /*
-        不能原地构造, 必须通过构造 tmp 再 move ！！！
-        标准库里 vector 的实现，往往会先在这块内存里写入它自己的 pointer / size / capacity
-        再去把 [first, last) 那段内存拷贝到 heap 上
-        由于拷贝源就是刚刚被自己当作“对象存放区”写过元数据的 sso_data
-        所以前面那几个字节已经不再是 'a','b','c'…，因此复制到堆上的数据就发生了破坏，看上去就像乱码。
-        */
-        std::vector<Byte> tmp(sso.data, sso.data + sso.len);
-        new (&heap.vec) std::vector<Byte>(std::move(tmp));
+    /*
+    从 SSO 一次性升级到容量为 cap 的堆缓冲区, 只分配一次:
+    依次拷入内联的 [0, pos)、新数据 [first, last)、内联的 [pos, len)
+
+    不能原地构造, 必须通过构造 tmp 再 move ！！！
+    标准库里 vector 的实现，往往会先在这块内存里写入它自己的 pointer / size / capacity
+    再去把 [first, last) 那段内存拷贝到 heap 上
+    由于拷贝源就是刚刚被自己当作“对象存放区”写过元数据的 sso_data
+    所以前面那几个字节已经不再是 'a','b','c'…，因此复制到堆上的数据就发生了破坏，看上去就像乱码。
+    */
+    template <typename It>
+    void promote_with(std::size_t cap, std::size_t pos, It first, It last) {
+        HeapVec tmp;
+        tmp.reserve(cap);
+        tmp.insert(tmp.end(), sso.data, sso.data + pos);
+        tmp.insert(tmp.end(), first, last);
+        tmp.insert(tmp.end(), sso.data + pos, sso.data + sso.len);
+        new (&heap.vec) HeapVec(std::move(tmp));
         heap.tag = kHeapFlag;
+        KASTRING_SSO_STAT_PROMOTE();
+    }
+
+    void promote_to_heap(std::size_t cap) {
+        const Byte* none = nullptr;
+        promote_with(cap, sso.len, none, none);
+    }
+
+    // 因追加而溢出 SSO 时的初始堆容量: 至少是 SSO_CAPACITY 按增长倍数扩一次, 避免紧接着的追加再次分配
+    static std::size_t promoted_capacity(std::size_t need) {
+        const std::size_t margin = static_cast<std::size_t>(static_cast<double>(SSO_CAPACITY) * growth_factor());
+        return std::max(need, margin);
+    }
+
+    void demote_to_sso() {
+        if (is_sso()) return;
+        std::array<Byte, SSO_CAPACITY> tmp;
+        const std::size_t n = heap.vec.size();
+        assert(n <= SSO_CAPACITY);
+        if (n != 0) std::memcpy(tmp.data(), heap.vec.data(), n);
+        heap.vec.~vector();
+        if (n != 0) std::memcpy(sso.data, tmp.data(), n);
+        sso.len = static_cast<uint8_t>(n); // sso.len 与 heap.tag 共用同一字节, 写入后即回到 SSO 模式
     }
 
     void init_uncheck(const Byte* p, size_t len) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Construct, false);
         if (len <= SSO_CAPACITY) {
             std::memcpy(sso.data, p, len);
             sso.len = static_cast<uint8_t>(len); // 断言不会超
         } else {
-            new (&heap.vec) std::vector<Byte>(p, p + len);
+            new (&heap.vec) HeapVec(p, p + len);
             heap.tag = kHeapFlag;
         }
     }
 
+    static std::atomic<double>& growth_factor_storage() {
+        static std::atomic<double> factor(2.0);
+        return factor;
+    }
+
+    // 堆模式下保证容量至少为 need, 扩容时按 growth_factor 几何增长
+    void grow_heap(std::size_t need) {
+        const std::size_t cap = heap.vec.capacity();
+        if (need <= cap) return;
+        const double scaled = static_cast<double>(cap) * growth_factor();
+        std::size_t target = scaled >= static_cast<double>(heap.vec.max_size())
+                                 ? heap.vec.max_size()
+                                 : static_cast<std::size_t>(scaled);
+        heap.vec.reserve(std::max(need, target));
+    }
+
+    // p 是否指向自身当前的内容; 用于 append / insert 的源区间来自自身时, 避免扩容后读到已释放的缓冲区
+    bool points_into(const Byte* p) const {
+        const Byte* b = data();
+        return ! std::less<const Byte*>()(p, b) && std::less<const Byte*>()(p, b + size());
+    }
+
+    bool points_into(Byte* p) const {
+        return points_into(static_cast<const Byte*>(p));
+    }
+
+    template <typename It>
+    bool points_into(It) const {
+        return false;
+    }
+
   public:
+    // 进程级的堆扩容倍数, 默认 2.0, 必须大于 1
+    static double growth_factor() {
+        return growth_factor_storage().load(std::memory_order_relaxed);
+    }
+
+    static void set_growth_factor(double factor) {
+        if (! (factor > 1.0)) {
+            throw std::invalid_argument("SSOBytes::set_growth_factor(): factor must be greater than 1");
+        }
+        growth_factor_storage().store(factor, std::memory_order_relaxed);
+    }
+
     bool is_sso() const {
         const uint8_t tag_value = heap.tag; // 强制访问为 heap 联合成员
         return (tag_value & kHeapFlag) == 0;
@@ -119,11 +204,12 @@ class SSOBytes {
     }
 
     SSOBytes(const SSOBytes& other) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Copy, false);
         if (other.is_sso()) {
             std::memcpy(sso.data, other.sso.data, other.sso.len);
             sso.len = other.sso.len;
         } else {
-            new (&heap.vec) std::vector<Byte>(other.heap.vec);
+            new (&heap.vec) HeapVec(other.heap.vec);
             heap.tag = kHeapFlag;
         }
     }
@@ -140,7 +226,7 @@ class SSOBytes {
             std::memcpy(sso.data, other.sso.data, other.sso.len);
             sso.len = other.sso.len;
         } else {
-            new (&heap.vec) std::vector<Byte>(std::move(other.heap.vec));
+            new (&heap.vec) HeapVec(std::move(other.heap.vec));
             heap.tag = kHeapFlag;
         }
     }
@@ -184,6 +270,16 @@ class SSOBytes {
         return is_sso() ? SSO_CAPACITY : heap.vec.capacity();
     }
 
+    // 堆上实际占用的字节数, SSO 模式下为 0
+    std::size_t heap_bytes() const {
+        return is_sso() ? 0 : heap.vec.capacity();
+    }
+
+    // 对象自身加上堆上占用的总字节数
+    std::size_t footprint() const {
+        return sizeof(*this) + heap_bytes();
+    }
+
     bool empty() const {
         return size() == 0;
     }
@@ -221,14 +317,16 @@ class SSOBytes {
     }
 
     void push_back(Byte byte) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Append, ! is_sso());
         if (is_sso()) {
             if (sso.len < SSO_CAPACITY) {
                 sso.data[sso.len++] = byte;
             } else {
-                promote_to_heap();
+                promote_to_heap(promoted_capacity(SSO_CAPACITY + 1));
                 heap.vec.push_back(byte);
             }
         } else {
+            grow_heap(heap.vec.size() + 1);
             heap.vec.push_back(byte);
         }
     }
@@ -245,13 +343,25 @@ class SSOBytes {
     }
 
     void append(const Byte* src, std::size_t len) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Append, ! is_sso());
         if (len == 0) return;
 
-        if (is_sso() && sso.len + len <= SSO_CAPACITY) {
-            std::memcpy(sso.data + sso.len, src, len);
-            sso.len += static_cast<uint8_t>(len);
+        if (is_sso()) {
+            if (len <= SSO_CAPACITY - sso.len) { // 写成减法, 避免 len 很大时加法回绕
+                std::memcpy(sso.data + sso.len, src, len);
+                sso.len += static_cast<uint8_t>(len);
+            } else {
+                promote_with(promoted_capacity(sso.len + len), sso.len, src, src + len);
+            }
+        } else if (points_into(src)) {
+            // 扩容会释放 src 所在的缓冲区, 先记下偏移, 扩容后再取地址
+            const std::size_t offset = static_cast<std::size_t>(src - heap.vec.data());
+            const std::size_t old = heap.vec.size();
+            grow_heap(old + len);
+            heap.vec.resize(old + len);
+            std::memcpy(heap.vec.data() + old, heap.vec.data() + offset, len);
         } else {
-            promote_to_heap();
+            grow_heap(heap.vec.size() + len);
             heap.vec.insert(heap.vec.end(), src, src + len);
         }
     }
@@ -269,6 +379,7 @@ class SSOBytes {
     }
 
     void insert(std::size_t pos, Byte byte) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Insert, ! is_sso());
         if (! (pos <= size())) {
             throw std::out_of_range("SSOBytes::insert()");
         }
@@ -276,14 +387,18 @@ class SSOBytes {
             for (std::size_t i = sso.len; i > pos; --i) sso.data[i] = sso.data[i - 1];
             sso.data[pos] = byte;
             ++sso.len;
+        } else if (is_sso()) {
+            promote_with(promoted_capacity(SSO_CAPACITY + 1), pos, &byte, &byte + 1);
         } else {
-            promote_to_heap();
+            grow_heap(heap.vec.size() + 1);
             heap.vec.insert(std::next(heap.vec.begin(), static_cast<std::ptrdiff_t>(pos)), byte);
         }
     }
 
     void resize(std::size_t n, Byte val = 0) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Resize, ! is_sso());
         if (! is_sso()) {
+            grow_heap(n);
             heap.vec.resize(n, val);
             return;
         }
@@ -294,18 +409,18 @@ class SSOBytes {
                 std::fill(sso.data + sso.len, sso.data + n, val);
             }
             sso.len = static_cast<uint8_t>(n);
-        } else { // 扩展到堆上, 进入 heap 模式
-            promote_to_heap();
-            heap.vec.resize(n, val); // 使用 vector 的 resize
+        } else { // 扩展到堆上, 进入 heap 模式, 按目标大小一次分配
+            promote_to_heap(n);
+            heap.vec.resize(n, val);
         }
     }
 
     void reserve(std::size_t n) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Reserve, ! is_sso());
         if (! is_sso()) {
             heap.vec.reserve(n);
         } else if (n > SSO_CAPACITY) {
-            promote_to_heap();
-            heap.vec.reserve(n);
+            promote_to_heap(n);
         }
     }
 
@@ -340,12 +455,22 @@ class SSOBytes {
         }
     }
 
+    // 内容能放回内联缓冲区时降级为 SSO 并释放堆内存, 否则收缩堆容量
     void shrink_to_fit() {
-        if (! is_sso()) {
+        if (is_sso()) return;
+        if (heap.vec.size() <= SSO_CAPACITY) {
+            demote_to_sso();
+        } else {
             heap.vec.shrink_to_fit();
         }
     }
 
+    // 清空内容并释放全部堆内存, 回到空的 SSO 状态
+    void release() {
+        if (! is_sso()) heap.vec.~vector();
+        sso.len = 0;
+    }
+
     void swap(SSOBytes& other) noexcept {
         if (this == &other) return;
 
@@ -369,19 +494,28 @@ class SSOBytes {
 
     template <typename It>
     void insert(std::size_t pos, It first, It last) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Insert, ! is_sso());
         std::size_t count = static_cast<std::size_t>(std::distance(first, last));
         if(count == 0) return;
         if (! (pos <= size())) {
             throw std::out_of_range("SSOBytes::insert<It>()");
         }
+        // 源区间来自自身: 挪动或扩容都会改写它, 先复制出来
+        if (points_into(first)) {
+            const std::vector<Byte> tmp(first, last);
+            insert(pos, tmp.data(), tmp.data() + tmp.size());
+            return;
+        }
 
         if (is_sso() && sso.len + count <= SSO_CAPACITY) {
             for (std::size_t i = sso.len; i > pos; --i) sso.data[i + count - 1] = sso.data[i - 1];
             for (std::size_t i = 0; i < count; ++i) sso.data[pos + i] = static_cast<Byte>(*first++);
             sso.len += static_cast<Byte>(count);
+        } else if (is_sso()) {
+            promote_with(promoted_capacity(sso.len + count), pos, first, last);
         } else {
-            promote_to_heap();
-            heap.vec.insert(heap.vec.begin() + pos, first, last);
+            grow_heap(heap.vec.size() + count);
+            heap.vec.insert(heap.vec.begin() + static_cast<std::ptrdiff_t>(pos), first, last);
         }
     }
 
@@ -404,14 +538,17 @@ class SSOBytes {
 
     template <typename It>
     void assign(It begin, It end) {
+        KASTRING_SSO_STAT_SCOPE(SSOOp::Construct, ! is_sso());
         std::size_t n = static_cast<std::size_t>(std::distance(begin, end));
         if (is_sso() && n <= SSO_CAPACITY) {
             for (std::size_t i = 0; i < n; ++i) sso.data[i] = static_cast<Byte>(*(begin++));
             sso.len = static_cast<Byte>(n);
-        } else {            // 不是 SSO, 或者 n 过大, 总之都要进入堆模式
-            if (is_sso()) { //
-                promote_to_heap();
-            }
+        } else if (is_sso()) { // n 过大, 直接按 n 建堆缓冲区, 原内容被整体替换
+            HeapVec tmp(begin, end);
+            new (&heap.vec) HeapVec(std::move(tmp));
+            heap.tag = kHeapFlag;
+            KASTRING_SSO_STAT_PROMOTE();
+        } else {
             heap.vec.assign(begin, end);
         }
     }
@@ -451,4 +588,5 @@ class SSOBytes {
         return end();
     }
 };
-} // namespace kstring
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
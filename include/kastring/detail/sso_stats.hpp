@@ -0,0 +1,365 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base.hpp"
+
+#ifdef KASTRING_SSO_STATS
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#endif
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+/**
+ * @brief SSOBytes 的堆分配统计, 编译期开关
+ *
+ * 定义 KASTRING_SSO_STATS 后, SSOBytes 的堆内存改用计数分配器, 并按操作分类记录
+ * 升级到堆的次数、分配/重新分配次数、分配/释放字节数和堆内存峰值;
+ * 未定义时所有钩子展开为空, 查询接口返回全 0
+ *
+ * 该宏改变 SSOBytes / KAString 的内存布局, 同一程序中所有包含 kastring 的翻译单元必须一致地
+ * 定义或不定义它; 两种配置位于不同的内联命名空间 (见 KASTRING_ABI_NAMESPACE), 混用时链接报错
+ */
+enum class SSOOp : unsigned {
+    Append,    // append / push_back
+    Insert,    // insert / prepend
+    Resize,    // resize
+    Reserve,   // reserve
+    Copy,      // 拷贝构造 / 拷贝赋值
+    Construct, // 从字节序列构造 / assign
+    Other      // 析构、shrink_to_fit 等
+};
+
+enum : std::size_t {
+    SSO_OP_COUNT = static_cast<std::size_t>(SSOOp::Other) + 1
+};
+
+struct SSOOpStats {
+    std::uint64_t promotions;      // SSO -> heap
+    std::uint64_t allocations;     // 新建堆缓冲区
+    std::uint64_t reallocations;   // 已在堆上时的扩容
+    std::uint64_t bytes_allocated;
+    std::uint64_t bytes_freed;
+
+    SSOOpStats() : promotions(0), allocations(0), reallocations(0), bytes_allocated(0), bytes_freed(0) {}
+
+    SSOOpStats& operator+=(const SSOOpStats& o) {
+        promotions += o.promotions;
+        allocations += o.allocations;
+        reallocations += o.reallocations;
+        bytes_allocated += o.bytes_allocated;
+        bytes_freed += o.bytes_freed;
+        return *this;
+    }
+};
+
+struct SSOStats {
+    SSOOpStats ops[SSO_OP_COUNT];
+    std::uint64_t peak_live_bytes;
+
+    SSOStats() : ops(), peak_live_bytes(0) {}
+
+    const SSOOpStats& operator[](SSOOp op) const {
+        return ops[static_cast<std::size_t>(op)];
+    }
+
+    SSOOpStats total() const {
+        SSOOpStats t;
+        for (std::size_t i = 0; i < SSO_OP_COUNT; ++i) t += ops[i];
+        return t;
+    }
+
+    // 分配与释放可能发生在不同线程, 因此单个线程的值可能为负
+    std::int64_t live_bytes() const {
+        SSOOpStats t = total();
+        return static_cast<std::int64_t>(t.bytes_allocated) - static_cast<std::int64_t>(t.bytes_freed);
+    }
+
+    static constexpr bool enabled() {
+#ifdef KASTRING_SSO_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // 当前线程的计数
+    static SSOStats thread_snapshot();
+    // 所有线程(包括已退出线程)的汇总, peak_live_bytes 为全局堆内存峰值
+    static SSOStats global_snapshot();
+    // 清零所有线程的计数与峰值, 应在没有并发字符串操作时调用
+    static void reset();
+};
+
+#ifndef KASTRING_SSO_STATS
+
+inline SSOStats SSOStats::thread_snapshot() {
+    return SSOStats();
+}
+
+inline SSOStats SSOStats::global_snapshot() {
+    return SSOStats();
+}
+
+inline void SSOStats::reset() {}
+
+#define KASTRING_SSO_STAT_SCOPE(op, growing)
+#define KASTRING_SSO_STAT_PROMOTE()
+
+namespace detail {
+typedef std::vector<std::uint8_t> SSOHeapVec;
+} // namespace detail
+
+#else
+
+namespace detail {
+enum SSOField : std::size_t {
+    kPromotions,
+    kAllocations,
+    kReallocations,
+    kBytesAllocated,
+    kBytesFreed,
+    kFieldCount
+};
+
+// 每个线程一份, 只由所属线程写入; 其他线程只读, 因此用 relaxed 的 load/store 即可
+struct SSOThreadCounters {
+    std::atomic<std::uint64_t> c[SSO_OP_COUNT][kFieldCount];
+    std::atomic<std::int64_t> live;
+    std::atomic<std::uint64_t> peak;
+
+    SSOThreadCounters() : c(), live(0), peak(0) {
+        clear();
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < SSO_OP_COUNT; ++i) {
+            for (std::size_t j = 0; j < kFieldCount; ++j) c[i][j].store(0, std::memory_order_relaxed);
+        }
+        live.store(0, std::memory_order_relaxed);
+        peak.store(0, std::memory_order_relaxed);
+    }
+
+    void add(std::size_t op, std::size_t field, std::uint64_t v) {
+        std::atomic<std::uint64_t>& a = c[op][field];
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    void fold_into(SSOStats& out) const {
+        for (std::size_t i = 0; i < SSO_OP_COUNT; ++i) {
+            SSOOpStats& o = out.ops[i];
+            o.promotions += c[i][kPromotions].load(std::memory_order_relaxed);
+            o.allocations += c[i][kAllocations].load(std::memory_order_relaxed);
+            o.reallocations += c[i][kReallocations].load(std::memory_order_relaxed);
+            o.bytes_allocated += c[i][kBytesAllocated].load(std::memory_order_relaxed);
+            o.bytes_freed += c[i][kBytesFreed].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+struct SSOStatsRegistry {
+    std::mutex mtx;
+    std::vector<SSOThreadCounters*> threads;
+    SSOStats retired; // 已退出线程的累计值
+    std::atomic<std::int64_t> live;
+    std::atomic<std::uint64_t> peak;
+
+    SSOStatsRegistry() : mtx(), threads(), retired(), live(0), peak(0) {}
+
+    // 故意泄漏: 静态对象析构时仍可能释放字符串
+    static SSOStatsRegistry& instance() {
+        static SSOStatsRegistry* r = new SSOStatsRegistry();
+        return *r;
+    }
+};
+
+struct SSOThreadState {
+    SSOThreadCounters* counters;
+    SSOOp op;
+    bool growing;
+};
+
+inline SSOThreadState& sso_thread_state() {
+    static thread_local SSOThreadState state = {nullptr, SSOOp::Other, false};
+    return state;
+}
+
+// 线程退出时把计数并入 retired 并注销
+struct SSOThreadHolder {
+    SSOThreadCounters* counters;
+
+    SSOThreadHolder() : counters(new SSOThreadCounters()) {
+        SSOStatsRegistry& r = SSOStatsRegistry::instance();
+        std::lock_guard<std::mutex> lock(r.mtx);
+        r.threads.push_back(counters);
+    }
+
+    SSOThreadHolder(const SSOThreadHolder&) = delete;
+    SSOThreadHolder& operator=(const SSOThreadHolder&) = delete;
+
+    ~SSOThreadHolder() {
+        SSOStatsRegistry& r = SSOStatsRegistry::instance();
+        {
+            std::lock_guard<std::mutex> lock(r.mtx);
+            counters->fold_into(r.retired);
+            r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), counters), r.threads.end());
+        }
+        sso_thread_state().counters = nullptr;
+        delete counters;
+    }
+};
+
+inline SSOThreadCounters* sso_thread_counters() {
+    SSOThreadState& st = sso_thread_state();
+    if (st.counters == nullptr) {
+        static thread_local bool destroyed = false;
+        if (destroyed) return nullptr; // 线程退出阶段, 只记全局量
+        static thread_local struct Guard {
+            SSOThreadHolder holder;
+            bool& flag;
+
+            explicit Guard(bool& f) : holder(), flag(f) {}
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() {
+                flag = true;
+            }
+        } guard(destroyed);
+        st.counters = guard.holder.counters;
+    }
+    return st.counters;
+}
+
+inline void sso_stats_on_alloc(std::size_t bytes) {
+    SSOStatsRegistry& r = SSOStatsRegistry::instance();
+    const std::int64_t now = r.live.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed) +
+                             static_cast<std::int64_t>(bytes);
+    std::uint64_t peak = r.peak.load(std::memory_order_relaxed);
+    while (now > 0 && static_cast<std::uint64_t>(now) > peak &&
+           ! r.peak.compare_exchange_weak(peak, static_cast<std::uint64_t>(now), std::memory_order_relaxed)) {
+    }
+
+    SSOThreadCounters* c = sso_thread_counters();
+    if (c == nullptr) return;
+    const SSOThreadState& st = sso_thread_state();
+    const std::size_t op = static_cast<std::size_t>(st.op);
+    c->add(op, st.growing ? kReallocations : kAllocations, 1);
+    c->add(op, kBytesAllocated, bytes);
+    const std::int64_t live = c->live.load(std::memory_order_relaxed) + static_cast<std::int64_t>(bytes);
+    c->live.store(live, std::memory_order_relaxed);
+    if (live > 0 && static_cast<std::uint64_t>(live) > c->peak.load(std::memory_order_relaxed)) {
+        c->peak.store(static_cast<std::uint64_t>(live), std::memory_order_relaxed);
+    }
+}
+
+inline void sso_stats_on_free(std::size_t bytes) {
+    SSOStatsRegistry::instance().live.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+    SSOThreadCounters* c = sso_thread_counters();
+    if (c == nullptr) return;
+    c->add(static_cast<std::size_t>(sso_thread_state().op), kBytesFreed, bytes);
+    c->live.store(c->live.load(std::memory_order_relaxed) - static_cast<std::int64_t>(bytes),
+                  std::memory_order_relaxed);
+}
+
+// 升级完成后, 同一操作内后续的分配都算作重新分配
+inline void sso_stats_on_promote() {
+    SSOThreadState& st = sso_thread_state();
+    st.growing = true;
+    SSOThreadCounters* c = sso_thread_counters();
+    if (c != nullptr) c->add(static_cast<std::size_t>(st.op), kPromotions, 1);
+}
+
+// 标记当前线程正在执行的操作, 作用域结束时恢复, 以支持嵌套调用
+class SSOStatScope {
+  public:
+    SSOStatScope(SSOOp op, bool growing) : prev_op_(sso_thread_state().op), prev_growing_(sso_thread_state().growing) {
+        sso_thread_state().op = op;
+        sso_thread_state().growing = growing;
+    }
+
+    SSOStatScope(const SSOStatScope&) = delete;
+    SSOStatScope& operator=(const SSOStatScope&) = delete;
+
+    ~SSOStatScope() {
+        sso_thread_state().op = prev_op_;
+        sso_thread_state().growing = prev_growing_;
+    }
+
+  private:
+    SSOOp prev_op_;
+    bool prev_growing_;
+};
+
+template <typename T>
+struct SSOStatsAllocator {
+    typedef T value_type;
+
+    SSOStatsAllocator() noexcept {}
+
+    template <typename U>
+    SSOStatsAllocator(const SSOStatsAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        T* p = std::allocator<T>().allocate(n);
+        sso_stats_on_alloc(n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        sso_stats_on_free(n * sizeof(T));
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    friend bool operator==(const SSOStatsAllocator&, const SSOStatsAllocator&) {
+        return true;
+    }
+
+    friend bool operator!=(const SSOStatsAllocator&, const SSOStatsAllocator&) {
+        return false;
+    }
+};
+
+typedef std::vector<std::uint8_t, SSOStatsAllocator<std::uint8_t>> SSOHeapVec;
+} // namespace detail
+
+inline SSOStats SSOStats::thread_snapshot() {
+    SSOStats out;
+    detail::SSOThreadCounters* c = detail::sso_thread_counters();
+    if (c == nullptr) return out;
+    c->fold_into(out);
+    out.peak_live_bytes = c->peak.load(std::memory_order_relaxed);
+    return out;
+}
+
+inline SSOStats SSOStats::global_snapshot() {
+    detail::SSOStatsRegistry& r = detail::SSOStatsRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    SSOStats out = r.retired;
+    for (detail::SSOThreadCounters* c : r.threads) c->fold_into(out);
+    out.peak_live_bytes = r.peak.load(std::memory_order_relaxed);
+    return out;
+}
+
+inline void SSOStats::reset() {
+    detail::SSOStatsRegistry& r = detail::SSOStatsRegistry::instance();
+    std::lock_guard<std::mutex> lock(r.mtx);
+    r.retired = SSOStats();
+    for (detail::SSOThreadCounters* c : r.threads) c->clear();
+    // 峰值从当前仍存活的堆内存重新开始计
+    const std::int64_t live = r.live.load(std::memory_order_relaxed);
+    r.peak.store(live > 0 ? static_cast<std::uint64_t>(live) : 0, std::memory_order_relaxed);
+}
+
+#define KASTRING_SSO_STAT_SCOPE(op, growing) ::kastring::detail::SSOStatScope kastring_sso_stat_scope_((op), (growing))
+#define KASTRING_SSO_STAT_PROMOTE() ::kastring::detail::sso_stats_on_promote()
+
+#endif
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
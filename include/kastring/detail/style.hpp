@@ -3,6 +3,7 @@
 #include "./kastr.hpp"
 
 namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
 class StyledKAStr {
     KAStr text_;
     std::string fg_code_;
@@ -124,4 +125,5 @@ class StyledKAStr {
     friend std::ostream& operator<<(std::ostream& os, const StyledKAStr& s);
 };
 
+} // namespace KASTRING_ABI_NAMESPACE
 } // namespace kastring
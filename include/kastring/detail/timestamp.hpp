@@ -0,0 +1,322 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include "base.hpp"
+#include "./kastr.hpp"
+#include "./kastring.hpp"
+#include "./parse_int.hpp"
+#include "./to_chars.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+// 时间戳按哪个时区解释
+enum class TimestampZone : unsigned char {
+    // 格式化输出 UTC 时间和 'Z'; 解析时没有时区后缀的时间按 UTC 处理
+    Utc,
+    // 本地时间和 "+HH:MM" 偏移; 偏移按 15 分钟粒度缓存, 不必每次调用 localtime
+    Local
+};
+
+enum : std::size_t {
+    // "YYYY-MM-DDTHH:MM:SS.fffffffff+HH:MM"
+    TIMESTAMP_MAX_CHARS = 35
+};
+
+namespace detail {
+inline std::int64_t floor_div(std::int64_t a, std::int64_t b) {
+    const std::int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// 公历日期到 1970-01-01 起的天数 (Howard Hinnant, chrono-Compatible Low-Level Date Algorithms)
+inline std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2 ? 1 : 0;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+inline void civil_from_days(std::int64_t z, std::int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+}
+
+inline unsigned days_in_month(std::int64_t y, unsigned m) {
+    static const unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+    return m == 2 && leap ? 29 : days[m - 1];
+}
+
+// 调用 localtime 算出 utc_secs 时刻本地时间相对 UTC 的偏移(秒)
+inline int local_offset_uncached(std::int64_t utc_secs) {
+    const std::time_t t = static_cast<std::time_t>(utc_secs);
+    std::tm tm_buf;
+#ifdef _WIN32
+    if (localtime_s(&tm_buf, &t) != 0) return 0;
+#else
+    if (localtime_r(&t, &tm_buf) == nullptr) return 0;
+#endif
+    const std::int64_t local = days_from_civil(tm_buf.tm_year + 1900, static_cast<unsigned>(tm_buf.tm_mon + 1),
+                                               static_cast<unsigned>(tm_buf.tm_mday))
+                                   * 86400
+                               + tm_buf.tm_hour * 3600 + tm_buf.tm_min * 60 + tm_buf.tm_sec;
+    // RFC 3339 的偏移只精确到分钟, 早年地方平时的秒数舍去, 保证输出的时间与偏移自洽
+    return static_cast<int>((local - utc_secs) / 60 * 60);
+}
+
+enum : std::int64_t {
+    // 时区偏移和夏令时切换都落在 UTC 的 15 分钟边界上, 同一段内偏移不变
+    TZ_BUCKET_SECONDS = 900,
+    TZ_BUCKET_BIAS = std::int64_t(1) << 40,
+    TZ_OFFSET_BIAS = 1 << 21
+};
+
+/**
+ * @brief utc_secs 时刻的本地时区偏移(秒), 按 15 分钟一段缓存
+ *
+ * 段号和偏移打包在一个 64 位原子变量里, 命中时只有一次 relaxed load, 不加锁也不调用 localtime
+ * 假设进程运行期间不修改 TZ
+ */
+inline int local_utc_offset(std::int64_t utc_secs) {
+    static std::atomic<std::uint64_t> cache(0);
+    const std::int64_t bucket = floor_div(utc_secs, TZ_BUCKET_SECONDS);
+    if (bucket <= -TZ_BUCKET_BIAS || bucket >= TZ_BUCKET_BIAS) return local_offset_uncached(utc_secs);
+    const std::uint64_t key = static_cast<std::uint64_t>(bucket + TZ_BUCKET_BIAS);
+    const std::uint64_t packed = cache.load(std::memory_order_relaxed);
+    if ((packed >> 22) == key) return static_cast<int>(static_cast<std::int64_t>(packed & 0x3FFFFF) - TZ_OFFSET_BIAS);
+    const int offset = local_offset_uncached(utc_secs);
+    cache.store(key << 22 | static_cast<std::uint64_t>(offset + TZ_OFFSET_BIAS), std::memory_order_relaxed);
+    return offset;
+}
+
+// SWAR: 8 个字节中 sep_mask 以外的都是数字, sep_mask 处的字节等于 seps; 成功时把每两位数合并进偶数字节
+inline bool timestamp_swar_block(std::uint64_t v, std::uint64_t sep_mask, std::uint64_t seps, std::uint64_t& pairs) {
+    if ((v & sep_mask) != seps) return false;
+    const std::uint64_t digits = (v & ~sep_mask) | (0x3030303030303030ull & sep_mask);
+    if (! swar_is_eight_digits(digits)) return false;
+    const std::uint64_t t = digits - 0x3030303030303030ull;
+    // 每个字节不超过 9, 乘 10 后加上高一字节也不会向相邻字节进位
+    pairs = t * 10 + (t >> 8);
+    return true;
+}
+
+inline unsigned timestamp_lane(std::uint64_t pairs, unsigned lane) {
+    return static_cast<unsigned>((pairs >> (8 * lane)) & 0xFF);
+}
+
+// 快速路径失败后逐字节找出第一个不符合 "dddd-dd-ddTdd:dd:dd" 的位置
+inline std::size_t timestamp_first_bad(const Byte* p, std::size_t n) {
+    static const char layout[] = "dddd-dd-ddTdd:dd:dd";
+    for (std::size_t k = 0; k < 19; ++k) {
+        if (k == n) return k;
+        const Byte c = p[k];
+        const char want = layout[k];
+        const bool ok = want == 'd'   ? (c >= '0' && c <= '9')
+                        : want == 'T' ? (c == 'T' || c == 't' || c == ' ')
+                                      : c == static_cast<Byte>(want);
+        if (! ok) return k;
+    }
+    return 19;
+}
+
+inline std::int64_t timestamp_pow10(std::size_t k) {
+    std::int64_t r = 1;
+    while (k-- > 0) r *= 10;
+    return r;
+}
+
+inline ParseResult<std::chrono::system_clock::time_point> timestamp_fail(ParseError err, std::size_t consumed) {
+    ParseResult<std::chrono::system_clock::time_point> r = {std::chrono::system_clock::time_point(), err, consumed};
+    return r;
+}
+
+inline char* timestamp_put2(char* out, unsigned v) {
+    std::memcpy(out, digits2(v), 2);
+    return out + 2;
+}
+} // namespace detail
+
+/**
+ * @brief 把 tp 写成 RFC 3339 时间戳 "YYYY-MM-DDTHH:MM:SS[.f...](Z|+HH:MM)", 返回写入的字节数
+ *
+ * buf 至少 TIMESTAMP_MAX_CHARS 字节; frac_digits 为秒的小数位数(0..9, 截断而不是四舍五入)
+ * 日期换算是纯整数运算, 不调用 localtime / strftime, 可以在多个线程中同时调用
+ */
+inline std::size_t format_timestamp(char* buf, const std::chrono::system_clock::time_point& tp,
+                                    TimestampZone zone = TimestampZone::Utc, int frac_digits = 0) {
+    using namespace std::chrono;
+    const system_clock::duration since = tp.time_since_epoch();
+    seconds secs = duration_cast<seconds>(since);
+    if (secs > since) secs -= seconds(1); // duration_cast 向 0 取整, 这里要向下取整
+    const std::int64_t sub_ns = static_cast<std::int64_t>(duration_cast<nanoseconds>(since - secs).count());
+    const int offset = zone == TimestampZone::Local ? detail::local_utc_offset(secs.count()) : 0;
+    const std::int64_t t = static_cast<std::int64_t>(secs.count()) + offset;
+
+    const std::int64_t days = detail::floor_div(t, 86400);
+    const unsigned sod = static_cast<unsigned>(t - days * 86400);
+    std::int64_t year;
+    unsigned month, day;
+    detail::civil_from_days(days, year, month, day);
+    if (year < 0 || year > 9999) throw std::out_of_range("format_timestamp: year out of range [0, 9999]");
+
+    char* out = buf;
+    out = detail::timestamp_put2(out, static_cast<unsigned>(year / 100));
+    out = detail::timestamp_put2(out, static_cast<unsigned>(year % 100));
+    *out++ = '-';
+    out = detail::timestamp_put2(out, month);
+    *out++ = '-';
+    out = detail::timestamp_put2(out, day);
+    *out++ = 'T';
+    out = detail::timestamp_put2(out, sod / 3600);
+    *out++ = ':';
+    out = detail::timestamp_put2(out, sod / 60 % 60);
+    *out++ = ':';
+    out = detail::timestamp_put2(out, sod % 60);
+
+    if (frac_digits > 0) {
+        const std::size_t k = frac_digits > 9 ? 9 : static_cast<std::size_t>(frac_digits);
+        // 先写满 9 位纳秒再截取前 k 位
+        char frac[9];
+        std::uint64_t ns = static_cast<std::uint64_t>(sub_ns);
+        for (std::size_t i = 9; i > 1; i -= 2, ns /= 100) {
+            std::memcpy(frac + i - 2, detail::digits2(static_cast<std::size_t>(ns % 100)), 2);
+        }
+        frac[0] = static_cast<char>('0' + ns);
+        *out++ = '.';
+        std::memcpy(out, frac, k);
+        out += k;
+    }
+
+    if (zone == TimestampZone::Utc) {
+        *out++ = 'Z';
+    } else {
+        const unsigned abs_min = static_cast<unsigned>((offset < 0 ? -offset : offset) / 60);
+        *out++ = offset < 0 ? '-' : '+';
+        out = detail::timestamp_put2(out, abs_min / 60);
+        *out++ = ':';
+        out = detail::timestamp_put2(out, abs_min % 60);
+    }
+    return static_cast<std::size_t>(out - buf);
+}
+
+// 追加到 out
+inline void format_timestamp_to(KAString& out, const std::chrono::system_clock::time_point& tp,
+                                TimestampZone zone = TimestampZone::Utc, int frac_digits = 0) {
+    char buf[TIMESTAMP_MAX_CHARS];
+    out.append(buf, format_timestamp(buf, tp, zone, frac_digits));
+}
+
+/**
+ * @brief 解析定长布局的 ISO 8601 / RFC 3339 时间戳 "YYYY-MM-DDTHH:MM:SS[.f...][Z|+HH:MM|-HH:MM]"
+ *
+ * 'T' 也可以是 't' 或空格, 小数点也可以是 ','; 小数部分超过 9 位时截断到纳秒
+ * 没有时区后缀时按 zone 解释; 秒允许为 60(闰秒), 按下一分钟的第 0 秒处理
+ * 日期与时分秒用 SWAR 一次校验 8 个字节; 出错时 consumed 指向第一个不合法的字符
+ * 超出 system_clock 的表示范围时返回 Overflow, value 饱和为 min / max
+ */
+inline ParseResult<std::chrono::system_clock::time_point> parse_timestamp(const KAStr& s,
+                                                                          TimestampZone zone = TimestampZone::Utc,
+                                                                          ParseMode mode = ParseMode::Strict) {
+    typedef std::chrono::system_clock::time_point TimePoint;
+    const Byte* p = s.data();
+    const std::size_t n = s.byte_size();
+    std::size_t i = 0;
+    if (mode == ParseMode::Lenient) {
+        while (i < n && detail::parse_is_space(p[i])) ++i;
+    }
+    if (i == n) return detail::timestamp_fail(ParseError::Empty, i);
+
+    // "YYYY-MM-" 与 "HH:MM:SS" 各是一个 8 字节块, 中间的 "DDT" 单独检查
+    std::uint64_t date = 0, time = 0;
+    const Byte* q = p + i;
+    const bool layout_ok = n - i >= 19
+                           && detail::timestamp_swar_block(detail::load_u64_le(q), 0xFF0000FF00000000ull,
+                                                           0x2D00002D00000000ull, date)
+                           && detail::timestamp_swar_block(detail::load_u64_le(q + 11), 0x0000FF0000FF0000ull,
+                                                           0x00003A00003A0000ull, time)
+                           && q[8] >= '0' && q[8] <= '9' && q[9] >= '0' && q[9] <= '9'
+                           && (q[10] == 'T' || q[10] == 't' || q[10] == ' ');
+    if (! layout_ok) {
+        return detail::timestamp_fail(ParseError::InvalidChar, i + detail::timestamp_first_bad(q, n - i));
+    }
+
+    const std::int64_t year = detail::timestamp_lane(date, 0) * 100 + detail::timestamp_lane(date, 2);
+    const unsigned month = detail::timestamp_lane(date, 5);
+    const unsigned day = static_cast<unsigned>((q[8] - '0') * 10 + (q[9] - '0'));
+    const unsigned hour = detail::timestamp_lane(time, 0);
+    const unsigned minute = detail::timestamp_lane(time, 3);
+    const unsigned second = detail::timestamp_lane(time, 6);
+    if (month < 1 || month > 12) return detail::timestamp_fail(ParseError::InvalidChar, i + 5);
+    if (day < 1 || day > detail::days_in_month(year, month)) {
+        return detail::timestamp_fail(ParseError::InvalidChar, i + 8);
+    }
+    if (hour > 23) return detail::timestamp_fail(ParseError::InvalidChar, i + 11);
+    if (minute > 59) return detail::timestamp_fail(ParseError::InvalidChar, i + 14);
+    if (second > 60) return detail::timestamp_fail(ParseError::InvalidChar, i + 17);
+    i += 19;
+
+    std::int64_t frac_ns = 0;
+    if (i < n && (p[i] == '.' || p[i] == ',')) {
+        ++i;
+        std::uint64_t frac;
+        const std::size_t k = detail::parse_decimal_prefix(p + i, n - i, frac);
+        if (k == 0) return detail::timestamp_fail(ParseError::InvalidChar, i);
+        frac_ns = k > 9 ? static_cast<std::int64_t>(frac / static_cast<std::uint64_t>(detail::timestamp_pow10(k - 9)))
+                        : static_cast<std::int64_t>(frac) * detail::timestamp_pow10(9 - k);
+        i += k;
+        while (i < n && p[i] >= '0' && p[i] <= '9') ++i;
+    }
+
+    const std::int64_t local = detail::days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    std::int64_t offset = 0;
+    if (i < n && (p[i] == 'Z' || p[i] == 'z')) {
+        ++i;
+    } else if (i < n && (p[i] == '+' || p[i] == '-')) {
+        const Byte* z = p + i + 1;
+        if (n - i < 6 || z[2] != ':' || z[0] < '0' || z[0] > '9' || z[1] < '0' || z[1] > '9' || z[3] < '0'
+            || z[3] > '9' || z[4] < '0' || z[4] > '9') {
+            return detail::timestamp_fail(ParseError::InvalidChar, i);
+        }
+        const int hh = (z[0] - '0') * 10 + (z[1] - '0');
+        const int mm = (z[3] - '0') * 10 + (z[4] - '0');
+        if (hh > 23 || mm > 59) return detail::timestamp_fail(ParseError::InvalidChar, i + 1);
+        offset = (hh * 3600 + mm * 60) * (p[i] == '-' ? -1 : 1);
+        i += 6;
+    } else if (zone == TimestampZone::Local) {
+        // 先按本地时间的数值猜一次偏移, 再用得到的 UTC 时刻修正, 夏令时切换附近也能得到正确结果
+        offset = detail::local_utc_offset(local);
+        offset = detail::local_utc_offset(local - offset);
+    }
+    if (mode == ParseMode::Strict && i != n) return detail::timestamp_fail(ParseError::InvalidChar, i);
+
+    const std::int64_t secs = local - offset;
+    typedef TimePoint::duration Duration;
+    const std::int64_t max_secs =
+        static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::seconds>(Duration::max()).count()) - 1;
+    if (secs > max_secs || secs < -max_secs) {
+        ParseResult<TimePoint> r = {secs > 0 ? TimePoint::max() : TimePoint::min(), ParseError::Overflow, i};
+        return r;
+    }
+    const Duration since = std::chrono::duration_cast<Duration>(std::chrono::seconds(secs))
+                           + std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(frac_ns));
+    ParseResult<TimePoint> r = {TimePoint(since), ParseError::Ok, i};
+    return r;
+}
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "base.hpp"
+
+namespace kastring {
+inline namespace KASTRING_ABI_NAMESPACE {
+namespace detail {
+// 整数转文本: 十进制两位一查表, 位数由 clz 直接算出, 十六进制按半字节查表
+// 调用方保证缓冲区至少 INT_CHARS_MAX 字节
+enum : std::size_t {
+    INT_CHARS_MAX = 65 // 64 位二进制 + 符号
+};
+
+inline const char* digits2(std::size_t v) {
+    return &"0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899"[v * 2];
+}
+
+// n 的十进制位数, 0 记为 1 位
+inline std::size_t count_digits(std::uint64_t n) {
+    static const std::uint64_t pow10[] = {0,
+                                          10ull,
+                                          100ull,
+                                          1000ull,
+                                          10000ull,
+                                          100000ull,
+                                          1000000ull,
+                                          10000000ull,
+                                          100000000ull,
+                                          1000000000ull,
+                                          10000000000ull,
+                                          100000000000ull,
+                                          1000000000000ull,
+                                          10000000000000ull,
+                                          100000000000000ull,
+                                          1000000000000000ull,
+                                          10000000000000000ull,
+                                          100000000000000000ull,
+                                          1000000000000000000ull,
+                                          10000000000000000000ull};
+    // log10(2) ~= 1233 / 4096
+    const std::size_t t = (64 - clz64(n | 1)) * 1233 >> 12;
+    return t - (n < pow10[t] ? 1 : 0) + 1;
+}
+
+// 有效位数, 0 记为 1 位
+inline std::size_t count_bits(std::uint64_t n) {
+    return 64 - clz64(n | 1);
+}
+
+// 32 位以内的值用 32 位除法, 比 64 位除法快得多
+template <typename U>
+void write_dec_backward(char* end, U n) {
+    while (n >= 100) {
+        end -= 2;
+        std::memcpy(end, digits2(static_cast<std::size_t>(n % 100)), 2);
+        n = static_cast<U>(n / 100);
+    }
+    if (n >= 10) {
+        std::memcpy(end - 2, digits2(static_cast<std::size_t>(n)), 2);
+    } else {
+        end[-1] = static_cast<char>('0' + n);
+    }
+}
+
+inline std::size_t u64_to_dec(char* buf, std::uint64_t n) {
+    const std::size_t len = count_digits(n);
+    if (n <= 0xffffffffull) {
+        write_dec_backward(buf + len, static_cast<std::uint32_t>(n));
+    } else {
+        write_dec_backward(buf + len, n);
+    }
+    return len;
+}
+
+inline std::size_t u64_to_hex(char* buf, std::uint64_t n, bool upper = false) {
+    const char* nibbles = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    const std::size_t len = (count_bits(n) + 3) / 4;
+    for (char* p = buf + len; p != buf; n >>= 4) *--p = nibbles[n & 0xf];
+    return len;
+}
+
+inline std::size_t u64_to_bin(char* buf, std::uint64_t n) {
+    const std::size_t len = count_bits(n);
+    for (char* p = buf + len; p != buf; n >>= 1) *--p = static_cast<char>('0' + (n & 1));
+    return len;
+}
+
+inline std::size_t u64_to_oct(char* buf, std::uint64_t n) {
+    const std::size_t len = (count_bits(n) + 2) / 3;
+    for (char* p = buf + len; p != buf; n >>= 3) *--p = static_cast<char>('0' + (n & 7));
+    return len;
+}
+
+// 任意进制 2..36, 常用进制走快速路径
+inline std::size_t u64_to_chars(char* buf, std::uint64_t n, int base, bool upper = false) {
+    switch (base) {
+    case 10: return u64_to_dec(buf, n);
+    case 16: return u64_to_hex(buf, n, upper);
+    case 2: return u64_to_bin(buf, n);
+    case 8: return u64_to_oct(buf, n);
+    default: break;
+    }
+    const char* digits = upper ? "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" : "0123456789abcdefghijklmnopqrstuvwxyz";
+    const std::uint64_t b = static_cast<std::uint64_t>(base);
+    char tmp[INT_CHARS_MAX];
+    char* p = tmp + sizeof(tmp);
+    do {
+        *--p = digits[n % b];
+        n /= b;
+    } while (n != 0);
+    const std::size_t len = static_cast<std::size_t>(tmp + sizeof(tmp) - p);
+    std::memcpy(buf, p, len);
+    return len;
+}
+
+template <typename T>
+bool int_is_negative(T val, std::true_type /*signed*/) {
+    return val < T(0);
+}
+
+template <typename T>
+bool int_is_negative(T /*val*/, std::false_type /*signed*/) {
+    return false;
+}
+
+// 整数的绝对值, 对最小负数同样成立
+template <typename T>
+std::uint64_t int_magnitude(T val) {
+    typedef typename std::make_unsigned<T>::type U;
+    const U u = static_cast<U>(val);
+    return int_is_negative(val, std::is_signed<T>()) ? static_cast<std::uint64_t>(static_cast<U>(U(0) - u))
+                                                     : static_cast<std::uint64_t>(u);
+}
+
+// 符号 + 绝对值, 适用于 int8_t .. uint64_t 的全部整数类型; 不检查 base
+template <typename T>
+std::size_t int_to_chars(char* buf, T val, int base = 10, bool upper = false) {
+    static_assert(std::is_integral<T>::value, "int_to_chars requires an integral type");
+    std::size_t sign = 0;
+    if (int_is_negative(val, std::is_signed<T>())) buf[sign++] = '-';
+    return sign + u64_to_chars(buf + sign, int_magnitude(val), base, upper);
+}
+} // namespace detail
+} // namespace KASTRING_ABI_NAMESPACE
+} // namespace kastring
@@ -1,6 +1,18 @@
 #pragma once
 
-#include "./detail/kastr.hpp"    // IWYU pragma: export
-#include "./detail/kastring.hpp" // IWYU pragma: export
-#include "./detail/style.hpp"    // IWYU pragma: export
-#include "./detail/tail.hpp"     // IWYU pragma: export
+#include "./detail/async_logger.hpp"    // IWYU pragma: export
+#include "./detail/codec.hpp"           // IWYU pragma: export
+#include "./detail/csv.hpp"             // IWYU pragma: export
+#include "./detail/fixed_width.hpp"     // IWYU pragma: export
+#include "./detail/format.hpp"          // IWYU pragma: export
+#include "./detail/format_template.hpp" // IWYU pragma: export
+#include "./detail/interner.hpp"        // IWYU pragma: export
+#include "./detail/json.hpp"            // IWYU pragma: export
+#include "./detail/kastr.hpp"           // IWYU pragma: export
+#include "./detail/kastring.hpp"        // IWYU pragma: export
+#include "./detail/parse.hpp"           // IWYU pragma: export
+#include "./detail/query.hpp"           // IWYU pragma: export
+#include "./detail/slice.hpp"           // IWYU pragma: export
+#include "./detail/style.hpp"           // IWYU pragma: export
+#include "./detail/tail.hpp"            // IWYU pragma: export
+#include "./detail/timestamp.hpp"       // IWYU pragma: export
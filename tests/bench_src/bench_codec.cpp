@@ -0,0 +1,109 @@
+// 编解码基准: hex / base64 的 SSE2 实现与逐字节查表循环对比
+// 运行: make bench BENCH=codec
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+template <typename F>
+void run(const char* label, std::size_t bytes, F f) {
+    std::size_t sum = 0;
+    double best = 1e30;
+    for (int r = 0; r < 3; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        sum += f();
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-32s %8.1f MB/s  (checksum %zu)\n", label, static_cast<double>(bytes) * 1e3 / best, sum);
+}
+
+// 常见的手写实现: 每个字节查一次表
+std::string naive_hex(const std::string& s) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(s.size() * 2);
+    for (unsigned char c : s) {
+        out.push_back(digits[c >> 4]);
+        out.push_back(digits[c & 15]);
+    }
+    return out;
+}
+
+std::string naive_base64(const std::string& s) {
+    static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((s.size() + 2) / 3 * 4);
+    unsigned acc = 0;
+    int bits = 0;
+    for (unsigned char c : s) {
+        acc = (acc << 8) | c;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(chars[(acc >> bits) & 63]);
+        }
+    }
+    if (bits > 0) out.push_back(chars[(acc << (6 - bits)) & 63]);
+    while (out.size() % 4 != 0) out.push_back('=');
+    return out;
+}
+
+std::string naive_unbase64(const std::string& s) {
+    std::string out;
+    unsigned acc = 0;
+    int bits = 0;
+    for (char ch : s) {
+        if (ch == '=') break;
+        const unsigned v = detail::base64_value(static_cast<Byte>(ch), Base64Alphabet::Standard);
+        if (v >= 64) return std::string();
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+        }
+    }
+    return out;
+}
+} // namespace
+
+int main() {
+    std::mt19937 rng(49);
+    std::string data;
+    for (std::size_t i = 0; i < (std::size_t(8) << 20); ++i) data.push_back(static_cast<char>(rng()));
+    const KAStr view(data.data(), data.size());
+
+    std::printf("hex 8 MB\n");
+    run("byte loop encode", data.size(), [&]() { return naive_hex(data).size(); });
+    run("hex_encode", data.size(), [&]() {
+        KAString out;
+        hex_encode(out, view);
+        return out.byte_size();
+    });
+    KAString hex_text;
+    hex_encode(hex_text, view);
+    run("hex_decode", data.size(), [&]() {
+        KAString out;
+        return hex_decode(out, hex_text.as_kastr()).value;
+    });
+
+    std::printf("base64 8 MB\n");
+    run("byte loop encode", data.size(), [&]() { return naive_base64(data).size(); });
+    run("base64_encode", data.size(), [&]() {
+        KAString out;
+        base64_encode(out, view);
+        return out.byte_size();
+    });
+    const std::string b64_text = naive_base64(data);
+    run("byte loop decode", data.size(), [&]() { return naive_unbase64(b64_text).size(); });
+    run("base64_decode", data.size(), [&]() {
+        KAString out;
+        return base64_decode(out, KAStr(b64_text.data(), b64_text.size())).value;
+    });
+    return 0;
+}
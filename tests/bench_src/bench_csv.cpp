@@ -0,0 +1,93 @@
+// CSV 读取基准: KACsvReader / KACsvStreamReader 与旧的 lines() + split(",") 路径对比
+// 运行: make bench BENCH=csv
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+struct Dataset {
+    const char* name;
+    std::string text;
+};
+
+// quoted_ratio: 被引号包围的字段比例, 其中一部分含有分隔符、换行和转义引号
+Dataset make_dataset(const char* name, int cols, int quoted_percent, std::mt19937_64& rng) {
+    Dataset ds = {name, std::string()};
+    const char* quoted[] = {"\"Smith, John\"", "\"say \"\"hi\"\"\"", "\"multi\nline\"", "\"plain quoted\""};
+    while (ds.text.size() < (64u << 20)) {
+        for (int c = 0; c < cols; ++c) {
+            if (c) ds.text.push_back(',');
+            if (static_cast<int>(rng() % 100) < quoted_percent) {
+                ds.text += quoted[rng() % 4];
+                continue;
+            }
+            const int len = 1 + static_cast<int>(rng() % 12);
+            for (int k = 0; k < len; ++k) ds.text.push_back(static_cast<char>('a' + rng() % 26));
+        }
+        ds.text.push_back('\n');
+    }
+    return ds;
+}
+
+template <typename F>
+void run(const char* label, const Dataset& ds, F f) {
+    std::size_t sum = 0;
+    double best = 1e30;
+    for (int r = 0; r < 5; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        sum += f(KAStr(ds.text.c_str(), ds.text.size()));
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-28s %8.1f MB/s  (checksum %zu)\n", label, static_cast<double>(ds.text.size()) * 1e3 / best,
+                sum);
+}
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(45);
+    std::vector<Dataset> sets;
+    sets.push_back(make_dataset("unquoted (8 columns)", 8, 0, rng));
+    sets.push_back(make_dataset("10% quoted (8 columns)", 8, 10, rng));
+
+    for (std::size_t i = 0; i < sets.size(); ++i) {
+        const Dataset& ds = sets[i];
+        std::printf("%s (%zu MB)\n", ds.name, ds.text.size() >> 20);
+        run("lines() + split(\",\")", ds, [](const KAStr& text) {
+            std::size_t n = 0;
+            const std::vector<KAStr> lines = text.lines();
+            for (std::size_t k = 0; k < lines.size(); ++k) {
+                const std::vector<KAStr> fields = lines[k].split(",");
+                n += fields.size() + fields.back().byte_size();
+            }
+            return n;
+        });
+        run("KACsvReader", ds, [](const KAStr& text) {
+            std::size_t n = 0;
+            KACsvReader reader(text);
+            KACsvRow row;
+            while (reader.next(row)) n += row.size() + row[row.size() - 1].byte_size();
+            return n;
+        });
+        run("KACsvStreamReader (256 KB)", ds, [](const KAStr& text) {
+            std::size_t n = 0, pos = 0;
+            KACsvStreamReader reader([&](char* buf, std::size_t cap) {
+                const std::size_t len = std::min(cap, text.byte_size() - pos);
+                std::memcpy(buf, text.data() + pos, len);
+                pos += len;
+                return len;
+            });
+            KACsvRow row;
+            while (reader.next(row)) n += row.size() + row[row.size() - 1].byte_size();
+            return n;
+        });
+    }
+    return 0;
+}
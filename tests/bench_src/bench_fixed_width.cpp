@@ -0,0 +1,77 @@
+// 定长记录基准: lines() + substr + trim + to_long 与 KAFixedWidthSchema::parse 单线程 / 多线程对比
+// 运行: make bench BENCH=fixed_width
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+template <typename F>
+void run(const char* label, std::size_t bytes, F f) {
+    std::size_t sum = 0;
+    double best = 1e30;
+    for (int r = 0; r < 3; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        sum += f();
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-32s %8.1f MB/s  (checksum %zu)\n", label, static_cast<double>(bytes) * 1e3 / best, sum);
+}
+} // namespace
+
+int main() {
+    // id(10) name(20) qty(8) price(12) date(8), 每行 58 字节加换行
+    std::string text;
+    for (int i = 0; i < 1000000; ++i) {
+        char buf[80];
+        const int n = std::snprintf(buf, sizeof(buf), "%010d%-20s%8d%12.2f%04d%02d%02d\n", i, "some product",
+                                    i % 977, i * 0.37, 1990 + i % 30, 1 + i % 12, 1 + i % 28);
+        text.append(buf, static_cast<std::size_t>(n));
+    }
+    const KAStr view(text.data(), text.size());
+    std::printf("%zu records, %.1f MB\n", static_cast<std::size_t>(1000000), static_cast<double>(text.size()) / 1e6);
+
+    run("lines + substr + trim + to_*", text.size(), [&]() {
+        std::vector<long> ids, qtys;
+        std::vector<KAStr> names;
+        std::vector<double> prices;
+        for (const KAStr& line : view.lines()) {
+            ids.push_back(line.substr(0, 10).trim().to_long());
+            names.push_back(line.substr(10, 20).trim());
+            qtys.push_back(line.substr(30, 8).trim().to_long());
+            prices.push_back(line.substr(38, 12).trim().to_double());
+        }
+        return ids.size() + names.size() + qtys.size() + prices.size();
+    });
+
+    KAFixedWidthSchema schema;
+    schema.add_field(0, 10, FixedWidthType::Int);
+    schema.add_field(10, 20, FixedWidthType::String);
+    schema.add_field(30, 8, FixedWidthType::Int);
+    schema.add_field(38, 12, FixedWidthType::Decimal);
+    run("schema.parse", text.size(), [&]() {
+        KAFixedWidthColumns cols;
+        return schema.parse(view, cols).rows;
+    });
+    run("schema.parse, 4 threads", text.size(), [&]() {
+        KAFixedWidthColumns cols;
+        return schema.parse(view, cols, 4).rows;
+    });
+
+    KAFixedWidthSchema fixed(59);
+    fixed.add_field(0, 10, FixedWidthType::Int);
+    fixed.add_field(10, 20, FixedWidthType::String);
+    fixed.add_field(30, 8, FixedWidthType::Int);
+    fixed.add_field(38, 12, FixedWidthType::Decimal);
+    fixed.add_field(50, 8, FixedWidthType::Date);
+    run("fixed record_size + date, 4 thr", text.size(), [&]() {
+        KAFixedWidthColumns cols;
+        return fixed.parse(view, cols, 4).rows;
+    });
+    return 0;
+}
@@ -0,0 +1,83 @@
+// JSON 基准: json_escape_to 与 replace_char_if 链对比, 以及 KAJsonTokenizer 的逐记号读取与 find_key 跳过
+// 运行: make bench BENCH=json
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+template <typename F>
+void run(const char* label, std::size_t bytes, F f) {
+    std::size_t sum = 0;
+    double best = 1e30;
+    for (int r = 0; r < 3; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        sum += f();
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-32s %8.1f MB/s  (checksum %zu)\n", label, static_cast<double>(bytes) * 1e3 / best, sum);
+}
+
+// 类似日志消息的文本: 大部分是普通字符, 偶尔有引号、反斜杠和换行
+std::string make_text(std::size_t bytes, std::mt19937& rng) {
+    static const char specials[] = {'"', '\\', '\n', '\t'};
+    std::string s;
+    while (s.size() < bytes) {
+        const unsigned r = rng() % 64;
+        s.push_back(r == 0 ? specials[rng() % 4] : static_cast<char>('a' + r % 26));
+    }
+    return s;
+}
+
+std::string make_document(std::size_t bytes) {
+    std::string doc = "{\"items\": [";
+    while (doc.size() < bytes) {
+        doc += "{\"name\": \"some product name here\", \"price\": 12.5, \"tags\": [\"a\", \"b\\\"c\"], "
+               "\"dims\": {\"w\": 1, \"h\": 2}, \"note\": null},";
+    }
+    doc += "{}], \"id\": 7}";
+    return doc;
+}
+} // namespace
+
+int main() {
+    std::mt19937 rng(47);
+    const std::string text = make_text(1 << 20, rng);
+    std::printf("escape 1 MB text (1/64 special)\n");
+    run("replace_char_if chain", text.size(), [&]() {
+        KAString s(text.c_str(), text.size());
+        s.replace_char_if([](char c) { return c == '\\'; }, "\\\\");
+        s.replace_char_if([](char c) { return c == '"'; }, "\\\"");
+        s.replace_char_if([](char c) { return c == '\n'; }, "\\n");
+        s.replace_char_if([](char c) { return c == '\t'; }, "\\t");
+        return s.byte_size();
+    });
+    run("json_escape_to", text.size(), [&]() {
+        KAString s;
+        json_escape_to(s, KAStr(text.c_str(), text.size()));
+        return s.byte_size();
+    });
+
+    const std::string doc = make_document(64 << 20);
+    std::printf("tokenize 64 MB document\n");
+    run("next() over every token", doc.size(), [&]() {
+        KAJsonTokenizer json(KAStr(doc.c_str(), doc.size()));
+        KAJsonToken tok;
+        std::size_t n = 0;
+        while (json.next(tok)) ++n;
+        return n;
+    });
+    run("find_key(\"id\") at the end", doc.size(), [&]() {
+        KAJsonTokenizer json(KAStr(doc.c_str(), doc.size()));
+        KAJsonToken tok;
+        json.next(tok);
+        json.find_key("id");
+        json.next(tok);
+        return static_cast<std::size_t>(parse<int>(tok.text).value);
+    });
+    return 0;
+}
@@ -0,0 +1,120 @@
+// 数值解析基准: parse<T> / KAStr::to_* 与旧的 std::stoll / std::stod 路径对比
+// 运行: make bench BENCH=parse
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+struct Dataset {
+    const char* name;
+    std::string text;         // 逗号分隔, 模拟 CSV 的一列
+    std::vector<KAStr> cells; // 指向 text 的切片, 不以 '\0' 结尾
+};
+
+Dataset make_dataset(const char* name, const std::vector<int>& lengths, std::mt19937_64& rng) {
+    Dataset ds = {name, std::string(), std::vector<KAStr>()};
+    const std::size_t rows = 1 << 20;
+    std::vector<std::size_t> offsets;
+    for (std::size_t i = 0; i < rows; ++i) {
+        const int len = lengths[rng() % lengths.size()];
+        offsets.push_back(ds.text.size());
+        if (rng() % 8 == 0) ds.text.push_back('-');
+        // 19 位数的首位不超过 8, 保证不会溢出 long long
+        ds.text.push_back(static_cast<char>('1' + rng() % (len == 19 ? 8 : 9)));
+        for (int k = 1; k < len; ++k) ds.text.push_back(static_cast<char>('0' + rng() % 10));
+        ds.text.push_back(',');
+    }
+    offsets.push_back(ds.text.size());
+    for (std::size_t i = 0; i < rows; ++i) {
+        ds.cells.push_back(KAStr(ds.text.c_str() + offsets[i], offsets[i + 1] - offsets[i] - 1));
+    }
+    return ds;
+}
+
+// printf 风格的 fmt 生成随机浮点数, scale 控制数量级的分布范围
+Dataset make_float_dataset(const char* name, const char* fmt, double scale, std::mt19937_64& rng) {
+    Dataset ds = {name, std::string(), std::vector<KAStr>()};
+    const std::size_t rows = 1 << 20;
+    std::uniform_real_distribution<double> mantissa(0.0, 1.0);
+    std::uniform_real_distribution<double> exponent(-scale, scale);
+    std::vector<std::size_t> offsets;
+    char buf[64];
+    for (std::size_t i = 0; i < rows; ++i) {
+        const double v = mantissa(rng) * std::pow(10.0, exponent(rng));
+        offsets.push_back(ds.text.size());
+        ds.text.append(buf, static_cast<std::size_t>(std::snprintf(buf, sizeof(buf), fmt, v)));
+        ds.text.push_back(',');
+    }
+    offsets.push_back(ds.text.size());
+    for (std::size_t i = 0; i < rows; ++i) {
+        ds.cells.push_back(KAStr(ds.text.c_str() + offsets[i], offsets[i + 1] - offsets[i] - 1));
+    }
+    return ds;
+}
+
+template <typename F>
+void run(const char* label, const Dataset& ds, F f) {
+    double sum = 0;
+    const int rounds = 5;
+    double best = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < ds.cells.size(); ++i) sum += static_cast<double>(f(ds.cells[i]));
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-24s %7.2f ns/value  %7.1f MB/s  (checksum %.17g)\n", label,
+                best / static_cast<double>(ds.cells.size()),
+                static_cast<double>(ds.text.size()) * 1e3 / best, sum);
+}
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(42);
+    std::vector<Dataset> sets;
+    sets.push_back(make_dataset("small ids (1-6 digits)", {1, 2, 3, 4, 5, 6}, rng));
+    sets.push_back(make_dataset("metrics (1-19 uniform)",
+                                {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19}, rng));
+    sets.push_back(make_dataset("timestamps (10/13 digits)", {10, 13}, rng));
+    sets.push_back(make_dataset("snowflake ids (18-19)", {18, 19}, rng));
+
+    for (std::size_t i = 0; i < sets.size(); ++i) {
+        const Dataset& ds = sets[i];
+        std::printf("%s\n", ds.name);
+        run("std::stoll(std::string)", ds, [](const KAStr& s) {
+            return std::stoll(std::string(reinterpret_cast<const char*>(s.data()), s.byte_size()));
+        });
+        run("strtoll (in place)", ds, [](const KAStr& s) {
+            // 每个单元格后面是 ',', strtoll 会在那里停下
+            return std::strtoll(reinterpret_cast<const char*>(s.data()), nullptr, 10);
+        });
+        run("KAStr::to_longlong", ds, [](const KAStr& s) { return s.to_longlong(); });
+        run("parse<long long>", ds, [](const KAStr& s) { return parse<long long>(s).value; });
+    }
+
+    std::vector<Dataset> float_sets;
+    float_sets.push_back(make_float_dataset("prices (%.2f)", "%.2f", 4, rng));
+    float_sets.push_back(make_float_dataset("sensor readings (%.6g)", "%.6g", 8, rng));
+    float_sets.push_back(make_float_dataset("round-trip doubles (%.17g)", "%.17g", 300, rng));
+
+    for (std::size_t i = 0; i < float_sets.size(); ++i) {
+        const Dataset& ds = float_sets[i];
+        std::printf("%s\n", ds.name);
+        run("std::stod(std::string)", ds, [](const KAStr& s) {
+            return std::stod(std::string(reinterpret_cast<const char*>(s.data()), s.byte_size()));
+        });
+        run("strtod (in place)", ds, [](const KAStr& s) {
+            return std::strtod(reinterpret_cast<const char*>(s.data()), nullptr);
+        });
+        run("KAStr::to_double", ds, [](const KAStr& s) { return s.to_double(); });
+        run("parse<double>", ds, [](const KAStr& s) { return parse<double>(s).value; });
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// 时间戳基准: format_timestamp / parse_timestamp 与 localtime_r + strftime / strptime + timegm 对比
+// 运行: make bench BENCH=timestamp
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+template <typename F>
+void run(const char* label, std::size_t count, F f) {
+    std::size_t sum = 0;
+    double best = 1e30;
+    for (int r = 0; r < 3; ++r) {
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        sum += f();
+        const std::chrono::duration<double, std::nano> dt = std::chrono::steady_clock::now() - t0;
+        if (dt.count() < best) best = dt.count();
+    }
+    std::printf("  %-32s %8.1f ns/op  (checksum %zu)\n", label, best / static_cast<double>(count), sum);
+}
+} // namespace
+
+int main() {
+    const std::size_t count = 1 << 20;
+    const std::time_t base = 1700000000;
+    std::printf("format %zu timestamps\n", count);
+    run("localtime_r + strftime", count, [&]() {
+        std::size_t sum = 0;
+        char buf[64];
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::time_t t = base + static_cast<std::time_t>(i);
+            std::tm tm_buf;
+            localtime_r(&t, &tm_buf);
+            sum += std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S%z", &tm_buf);
+        }
+        return sum;
+    });
+    run("format_timestamp (Local)", count, [&]() {
+        std::size_t sum = 0;
+        char buf[TIMESTAMP_MAX_CHARS];
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::time_t t = base + static_cast<std::time_t>(i);
+            sum += format_timestamp(buf, std::chrono::system_clock::from_time_t(t), TimestampZone::Local);
+        }
+        return sum;
+    });
+    run("format_timestamp (Utc, .ms)", count, [&]() {
+        std::size_t sum = 0;
+        char buf[TIMESTAMP_MAX_CHARS];
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::time_t t = base + static_cast<std::time_t>(i);
+            sum += format_timestamp(buf, std::chrono::system_clock::from_time_t(t), TimestampZone::Utc, 3);
+        }
+        return sum;
+    });
+
+    std::vector<std::string> texts;
+    for (std::size_t i = 0; i < 4096; ++i) {
+        char buf[TIMESTAMP_MAX_CHARS];
+        const std::time_t t = base + static_cast<std::time_t>(i * 7919);
+        texts.push_back(std::string(buf, format_timestamp(buf, std::chrono::system_clock::from_time_t(t))));
+    }
+    std::printf("parse %zu timestamps\n", count);
+    run("strptime + timegm", count, [&]() {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::tm tm_buf = std::tm();
+            strptime(texts[i % texts.size()].c_str(), "%Y-%m-%dT%H:%M:%SZ", &tm_buf);
+            sum += static_cast<std::size_t>(timegm(&tm_buf));
+        }
+        return sum;
+    });
+    run("parse_timestamp", count, [&]() {
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::string& s = texts[i % texts.size()];
+            const ParseResult<std::chrono::system_clock::time_point> r = parse_timestamp(KAStr(s.data(), s.size()));
+            sum += static_cast<std::size_t>(std::chrono::system_clock::to_time_t(r.value));
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,193 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+// writer 只在后台线程调用, flush() 返回后读取是安全的
+struct Collector {
+    Collector() : text(), batches(0) {}
+
+    std::string text;
+    std::size_t batches;
+
+    KAAsyncLogger::Writer writer() {
+        return [this](const KAStr& batch) {
+            text.append(reinterpret_cast<const char*>(batch.data()), batch.byte_size());
+            ++batches;
+        };
+    }
+};
+
+std::vector<std::string> split_lines(const std::string& s) {
+    std::vector<std::string> lines;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '\n') {
+            lines.push_back(s.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    return lines;
+}
+} // namespace
+
+TEST_CASE("KAAsyncLogger formats records on the background thread") {
+    SUBCASE("values and strings are captured at log time") {
+        Collector out;
+        KAAsyncLogger logger(out.writer());
+        std::string name = "disk";
+        char buf[16] = "tmp";
+        CHECK(logger.log(KA_FMT("{} usage {:.1f}% flag={} id={:#x}"), name, 93.25, true, 255u));
+        name = "changed";
+        CHECK(logger.log(KA_FMT("{}|{}|{}|{}"), buf, KAStr("view"), KAString("own"), 'c'));
+        buf[0] = 'X';
+        CHECK(logger.log(KA_FMT("took {}"), std::chrono::milliseconds(12)));
+        CHECK(logger.log(KA_FMT("no args")));
+        logger.flush();
+        CHECK(out.text == "disk usage 93.2% flag=true id=0xff\ntmp|view|own|c\ntook 12ms\nno args\n");
+        CHECK(logger.dropped() == 0);
+    }
+
+    SUBCASE("runtime templates") {
+        Collector out;
+        KAFormatTemplate tpl("[{level}] {1}");
+        KAFormatTemplate plain("{} + {} = {}");
+        {
+            KAAsyncLogger logger(out.writer());
+            logger.log(plain, 1, 2, 3);
+            logger.log(tpl, arg("level", 3), "hello");
+        } // 析构时输出剩余记录
+        CHECK(out.text == "1 + 2 = 3\n[3] hello\n");
+    }
+
+    SUBCASE("format errors do not stop the logger") {
+        Collector out;
+        KAAsyncLogger logger(out.writer());
+        KAFormatTemplate tpl("{} {}");
+        logger.log(tpl, 1);
+        logger.log(KA_FMT("ok {}"), 2);
+        logger.flush();
+        CHECK(out.text == "[log format error: not enough arguments]\nok 2\n");
+    }
+
+    SUBCASE("drop when full, block when full") {
+        Collector dropped_out;
+        {
+            KAAsyncLogger logger(dropped_out.writer(), 4096, KAAsyncLogger::DropWhenFull);
+            std::string big(5000, 'x');
+            CHECK_FALSE(logger.log(KA_FMT("{}"), big)); // 超过缓冲区一半
+            CHECK(logger.dropped() == 1);
+            CHECK(logger.ring_bytes() == 4096);
+        }
+
+        Collector out;
+        KAAsyncLogger logger(out.writer(), 4096, KAAsyncLogger::BlockWhenFull);
+        std::string line(100, 'y');
+        for (int i = 0; i < 2000; ++i) CHECK(logger.log(KA_FMT("{} {}"), i, line));
+        logger.flush();
+        std::vector<std::string> lines = split_lines(out.text);
+        REQUIRE(lines.size() == 2000);
+        CHECK(lines[1999] == "1999 " + line);
+        CHECK(logger.dropped() == 0);
+    }
+
+    SUBCASE("many producer threads keep per-thread order") {
+        Collector out;
+        KAAsyncLogger logger(out.writer(), 1 << 16, KAAsyncLogger::BlockWhenFull);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < 5000; ++i) logger.log(KA_FMT("{} {}"), t, i);
+            });
+        }
+        for (auto& th : threads) th.join();
+        logger.flush();
+        // 线程都已退出, 缓冲区输出完后被回收
+        CHECK(logger.thread_count() == 0);
+
+        std::vector<std::string> lines = split_lines(out.text);
+        REQUIRE(lines.size() == 20000);
+        std::vector<int> next(4, 0);
+        bool ordered = true;
+        for (const std::string& l : lines) {
+            const int t = l[0] - '0';
+            if (std::stoi(l.substr(2)) != next[static_cast<std::size_t>(t)]++) ordered = false;
+        }
+        CHECK(ordered);
+        CHECK(out.batches >= 1);
+    }
+
+    SUBCASE("two loggers on one thread") {
+        Collector a;
+        Collector b;
+        KAAsyncLogger la(a.writer());
+        KAAsyncLogger lb(b.writer());
+        for (int i = 0; i < 3; ++i) {
+            la.log(KA_FMT("a{}"), i);
+            lb.log(KA_FMT("b{}"), i);
+        }
+        la.flush();
+        lb.flush();
+        CHECK(a.text == "a0\na1\na2\n");
+        CHECK(b.text == "b0\nb1\nb2\n");
+        CHECK(la.thread_count() == 1);
+        CHECK(lb.thread_count() == 1);
+
+        // 本线程写过的 logger 析构后, 新 logger 仍各自拿到新的缓冲区
+        for (int round = 0; round < 3; ++round) {
+            Collector c;
+            KAAsyncLogger lc(c.writer());
+            lc.log(KA_FMT("c{}"), round);
+            la.log(KA_FMT("a{}"), round + 3);
+            lc.flush();
+            CHECK(c.text == "c" + std::to_string(round) + "\n");
+            CHECK(lc.thread_count() == 1);
+        }
+        la.flush();
+        CHECK(a.text == "a0\na1\na2\na3\na4\na5\n");
+    }
+
+    SUBCASE("rings of exited threads are reclaimed after draining") {
+        Collector out;
+        KAAsyncLogger logger(out.writer(), 1 << 16, KAAsyncLogger::BlockWhenFull);
+        std::atomic<bool> release(false);
+        std::atomic<int> logged(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&logger, &release, &logged, t]() {
+                for (int i = 0; i < 100; ++i) logger.log(KA_FMT("{} {}"), t, i);
+                ++logged;
+                while (! release.load()) std::this_thread::yield();
+                logger.log(KA_FMT("{} done"), t);
+            });
+        }
+        while (logged.load() < 3) std::this_thread::yield();
+        logger.flush();
+        CHECK(logger.thread_count() == 3);
+        CHECK(split_lines(out.text).size() == 300);
+
+        release = true;
+        for (auto& th : threads) th.join();
+        logger.flush();
+        CHECK(logger.thread_count() == 0);
+        // 退出前最后写的记录没有丢
+        std::vector<std::string> lines = split_lines(out.text);
+        REQUIRE(lines.size() == 303);
+        CHECK(std::count(lines.begin(), lines.end(), "1 done") == 1);
+
+        // 之后新线程重新分配缓冲区
+        std::thread([&logger]() { logger.log(KA_FMT("late")); }).join();
+        logger.flush();
+        CHECK(split_lines(out.text).back() == "late");
+        CHECK(logger.thread_count() == 0);
+    }
+}
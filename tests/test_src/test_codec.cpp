@@ -0,0 +1,129 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstddef>
+#include <random>
+#include <string>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+std::string hex(const std::string& s, bool upper = false) {
+    KAString out;
+    hex_encode(out, KAStr(s.data(), s.size()), upper);
+    return out;
+}
+
+std::string b64(const std::string& s, Base64Alphabet alphabet = Base64Alphabet::Standard, bool pad = true) {
+    KAString out;
+    base64_encode(out, KAStr(s.data(), s.size()), alphabet, pad);
+    CHECK(out.byte_size() == base64_encoded_size(s.size(), pad));
+    return out;
+}
+
+// 解码成功返回结果, 失败返回 "!<位置>"
+std::string unhex(const std::string& s) {
+    KAString out;
+    const ParseResult<std::size_t> r = hex_decode(out, KAStr(s.data(), s.size()));
+    if (! r) return "!" + std::to_string(r.consumed);
+    CHECK(r.value == out.byte_size());
+    return out;
+}
+
+std::string unb64(const std::string& s, Base64Alphabet alphabet = Base64Alphabet::Standard) {
+    KAString out;
+    const ParseResult<std::size_t> r = base64_decode(out, KAStr(s.data(), s.size()), alphabet);
+    if (! r) return "!" + std::to_string(r.consumed);
+    CHECK(r.value == out.byte_size());
+    CHECK(r.consumed == s.size());
+    return out;
+}
+} // namespace
+
+TEST_CASE("hex encode and decode") {
+    CHECK(hex("") == "");
+    CHECK(hex(std::string("\x00\x7f\x80\xff", 4)) == "007f80ff");
+    CHECK(hex("\xde\xad\xbe\xef", true) == "DEADBEEF");
+    // 跨越 16 字节块
+    const std::string bytes = "0123456789abcdef\x01\xfe!";
+    CHECK(hex(bytes) == "3031323334353637383961626364656601fe21");
+
+    CHECK(unhex("") == "");
+    CHECK(unhex("DeadBeef") == "\xde\xad\xbe\xef");
+    CHECK(unhex("3031323334353637383961626364656601fe21") == bytes);
+    CHECK(unhex("abc") == "!2");
+    CHECK(unhex("zz") == "!0");
+    CHECK(unhex("0g") == "!1");
+    // SIMD 块内的错误也报告准确位置
+    CHECK(unhex(std::string(40, 'a') + "G" + std::string(23, 'b')) == "!40");
+    CHECK(unhex(std::string(5, 'a') + "\x80" + std::string(40, 'b')) == "!5");
+    CHECK(unhex(std::string(30, '0') + "/:@`" + std::string(30, '0')) == "!30");
+
+    // 追加而不是覆盖, 失败时不留下半截结果
+    KAString out("x");
+    hex_encode(out, "\x01");
+    CHECK(out == "x01");
+    CHECK_FALSE(hex_decode(out, "0q"));
+    CHECK(out == "x01");
+}
+
+TEST_CASE("base64 encode") {
+    // RFC 4648 第 10 节的测试向量
+    CHECK(b64("") == "");
+    CHECK(b64("f") == "Zg==");
+    CHECK(b64("fo") == "Zm8=");
+    CHECK(b64("foo") == "Zm9v");
+    CHECK(b64("foob") == "Zm9vYg==");
+    CHECK(b64("fooba") == "Zm9vYmE=");
+    CHECK(b64("foobar") == "Zm9vYmFy");
+    CHECK(b64("fooba", Base64Alphabet::Standard, false) == "Zm9vYmE");
+    CHECK(b64("foob", Base64Alphabet::Url, false) == "Zm9vYg");
+
+    const std::string bin("\xfb\xff\xbf\xfb\xff\xbf\xfb\xff\xbf\xfb\xff\xbf\xfb\xff\xbf\x00\x10\x83", 18);
+    CHECK(b64(bin) == "+/+/+/+/+/+/+/+/+/+/ABCD");
+    CHECK(b64(bin, Base64Alphabet::Url) == "-_-_-_-_-_-_-_-_-_-_ABCD");
+}
+
+TEST_CASE("base64 decode") {
+    CHECK(unb64("") == "");
+    CHECK(unb64("Zg==") == "f");
+    CHECK(unb64("Zg") == "f");
+    CHECK(unb64("Zm8=") == "fo");
+    CHECK(unb64("Zm9vYmFy") == "foobar");
+    CHECK(unb64("+/+/+/+/+/+/+/+/+/+/ABCD") == std::string("\xfb\xff\xbf\xfb\xff\xbf\xfb\xff\xbf\xfb\xff\xbf\xfb"
+                                                            "\xff\xbf\x00\x10\x83",
+                                                            18));
+    CHECK(unb64("-_-_", Base64Alphabet::Url) == "\xfb\xff\xbf");
+
+    SUBCASE("invalid") {
+        CHECK(unb64("-_-_") == "!0");
+        CHECK(unb64("+/+/", Base64Alphabet::Url) == "!0");
+        CHECK(unb64("Zm9vY") == "!4");   // 剩 1 个字符
+        CHECK(unb64("Zh==") == "!1");    // 未用到的低位不为 0
+        CHECK(unb64("Zm9=") == "!2");
+        CHECK(unb64("Zg=") == "!2");     // 填充不完整
+        CHECK(unb64("Z===") == "!1");
+        CHECK(unb64("Zg==Zg==") == "!2");
+        CHECK(unb64("Zm 9v") == "!2");
+        CHECK(unb64(std::string(20, 'A') + "*" + std::string(11, 'A')) == "!20");
+        CHECK(unb64(std::string(7, 'A') + "\xc3" + std::string(24, 'A')) == "!7");
+
+        KAString out("keep");
+        CHECK_FALSE(base64_decode(out, "Zm9v!"));
+        CHECK(out == "keep");
+    }
+}
+
+TEST_CASE("codec round trip") {
+    std::mt19937 rng(49);
+    for (int iter = 0; iter < 500; ++iter) {
+        std::string s;
+        const int len = static_cast<int>(rng() % 100);
+        for (int k = 0; k < len; ++k) s.push_back(static_cast<char>(rng() % 256));
+        const bool upper = iter % 2 == 0;
+        CHECK(unhex(hex(s, upper)) == s);
+        const Base64Alphabet alphabet = upper ? Base64Alphabet::Url : Base64Alphabet::Standard;
+        CHECK(unb64(b64(s, alphabet, true), alphabet) == s);
+        CHECK(unb64(b64(s, alphabet, false), alphabet) == s);
+    }
+}
@@ -0,0 +1,179 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+typedef std::vector<std::vector<std::string> > Table;
+
+Table read_all(const KAStr& text, char delimiter = ',', char quote = '"') {
+    Table t;
+    KACsvReader reader(text, delimiter, quote);
+    KACsvRow row;
+    while (reader.next(row)) {
+        std::vector<std::string> r;
+        for (std::size_t i = 0; i < row.size(); ++i) r.push_back(std::string(row.unescaped(i)));
+        t.push_back(r);
+    }
+    return t;
+}
+
+// 每次最多读 chunk 字节的流
+Table read_stream(const std::string& text, std::size_t chunk) {
+    std::size_t pos = 0;
+    KACsvStreamReader reader(
+        [&](char* buf, std::size_t cap) {
+            const std::size_t n = std::min(std::min(cap, chunk), text.size() - pos);
+            std::memcpy(buf, text.data() + pos, n);
+            pos += n;
+            return n;
+        },
+        ',', '"', chunk);
+    Table t;
+    KACsvRow row;
+    while (reader.next(row)) {
+        std::vector<std::string> r;
+        for (std::size_t i = 0; i < row.size(); ++i) r.push_back(std::string(row.unescaped(i)));
+        t.push_back(r);
+    }
+    return t;
+}
+} // namespace
+
+TEST_CASE("csv reader basics") {
+    KACsvReader reader("a,b,c\n1,,3\n");
+    KACsvRow row;
+    REQUIRE(reader.next(row));
+    REQUIRE(row.size() == 3);
+    CHECK(row[0] == "a");
+    CHECK(row[2] == "c");
+    REQUIRE(reader.next(row));
+    CHECK(row.size() == 3);
+    CHECK(row[1].empty());
+    CHECK(row[2] == "3");
+    CHECK_FALSE(reader.next(row));
+    CHECK_FALSE(reader.next(row));
+
+    SUBCASE("no trailing newline") {
+        const Table t = read_all("x,y\n1,2");
+        REQUIRE(t.size() == 2);
+        CHECK(t[1] == std::vector<std::string>{"1", "2"});
+        CHECK(read_all("a,")[0] == std::vector<std::string>{"a", ""});
+    }
+
+    SUBCASE("crlf and blank lines") {
+        const Table t = read_all("a,b\r\n\r\n\n1,2\r\n");
+        REQUIRE(t.size() == 2);
+        CHECK(t[0] == std::vector<std::string>{"a", "b"});
+        CHECK(t[1] == std::vector<std::string>{"1", "2"});
+        CHECK(read_all("").empty());
+        CHECK(read_all("\n\n").empty());
+    }
+
+    SUBCASE("trailing \\r without newline") {
+        const Table ab = {{"a", "b"}};
+        const Table xq = {{"x"}, {"1", "q"}};
+        CHECK(read_all("a,b\r") == ab);
+        CHECK(read_all("\r").empty());
+        CHECK(read_all("x\n\r") == Table{{"x"}});
+        CHECK(read_all("x\n1,\"q\"\r") == xq);
+        for (std::size_t chunk : {1u, 2u, 64u}) {
+            CHECK(read_stream("a,b\r", chunk) == ab);
+            CHECK(read_stream("\r", chunk).empty());
+            CHECK(read_stream("x\n\r", chunk) == Table{{"x"}});
+            CHECK(read_stream("x\n1,\"q\"\r", chunk) == xq);
+        }
+    }
+
+    SUBCASE("tsv") {
+        const Table t = read_all("a\tb,c\n1\t2\n", '\t');
+        REQUIRE(t.size() == 2);
+        CHECK(t[0] == std::vector<std::string>{"a", "b,c"});
+    }
+
+    SUBCASE("invalid delimiter") {
+        CHECK_THROWS_AS(KACsvReader("", '\n'), std::invalid_argument);
+        CHECK_THROWS_AS(KACsvReader("", '"'), std::invalid_argument);
+    }
+}
+
+TEST_CASE("csv reader quoted fields") {
+    const char* text = "\"a,b\",\"say \"\"hi\"\"\",\"line\nbreak\"\nplain,\"\",\"x\"\n";
+    KACsvReader reader(text);
+    KACsvRow row;
+    REQUIRE(reader.next(row));
+    REQUIRE(row.size() == 3);
+    CHECK(row[0] == "a,b");
+    CHECK(row.raw(0) == "\"a,b\"");
+    CHECK_FALSE(row.needs_unescape(0));
+    // operator[] 不复制, 转义保持原样
+    CHECK(row[1] == "say \"\"hi\"\"");
+    CHECK(row.needs_unescape(1));
+    CHECK(row.unescaped(1) == "say \"hi\"");
+    CHECK(row[2] == "line\nbreak");
+    // 字段指向原缓冲区
+    CHECK(row[0].data() == reinterpret_cast<const Byte*>(text) + 1);
+
+    REQUIRE(reader.next(row));
+    CHECK(row.size() == 3);
+    CHECK(row[1].empty());
+    CHECK(row.raw(1) == "\"\"");
+    CHECK(row[2] == "x");
+    CHECK_FALSE(reader.next(row));
+
+    SUBCASE("quote disabled") {
+        const Table t = read_all("\"a,b\"\n", ',', '\0');
+        REQUIRE(t.size() == 1);
+        CHECK(t[0] == std::vector<std::string>{"\"a", "b\""});
+    }
+
+    SUBCASE("quoted newline across blocks") {
+        std::string big(100, 'x');
+        std::string s = "\"" + big + "\n" + big + "\",1\n2,3\n";
+        const Table t = read_all(KAStr(s.c_str()));
+        REQUIRE(t.size() == 2);
+        CHECK(t[0][0] == big + "\n" + big);
+        CHECK(t[1] == std::vector<std::string>{"2", "3"});
+    }
+
+    SUBCASE("row wider than the index window") {
+        std::string s = "h\n";
+        for (int i = 0; i < 5000; ++i) s += std::to_string(i % 10) + ",";
+        s += "end\nlast\n";
+        const Table t = read_all(KAStr(s.c_str()));
+        REQUIRE(t.size() == 3);
+        REQUIRE(t[1].size() == 5001);
+        CHECK(t[1][4999] == "9");
+        CHECK(t[1][5000] == "end");
+        CHECK(t[2][0] == "last");
+    }
+}
+
+TEST_CASE("csv stream reader matches buffer reader") {
+    std::mt19937 rng(45);
+    const char* atoms[] = {"a", "bc", "\"q,\"", "\"x\"\"y\"", "\"n\nl\"", "", "12345678901234567890", "\"\""};
+    std::string text;
+    for (int r = 0; r < 300; ++r) {
+        const int cols = 1 + static_cast<int>(rng() % 5);
+        for (int c = 0; c < cols; ++c) {
+            if (c) text += ',';
+            text += atoms[rng() % 8];
+        }
+        text += rng() % 4 == 0 ? "\r\n" : "\n";
+    }
+    text += "tail,\"end\"";
+
+    const Table expected = read_all(KAStr(text.c_str()));
+    CHECK(expected.size() > 250);
+    CHECK(expected.back() == std::vector<std::string>{"tail", "end"});
+    for (std::size_t chunk : {1u, 3u, 7u, 64u, 1000u, 100000u}) {
+        CHECK(read_stream(text, chunk) == expected);
+    }
+}
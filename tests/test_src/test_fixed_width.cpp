@@ -0,0 +1,171 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+// id(6) name(10) amount(9) date(8)
+KAFixedWidthSchema make_schema(std::size_t record_size = 0) {
+    KAFixedWidthSchema schema(record_size);
+    schema.add_field(0, 6, FixedWidthType::Int);
+    schema.add_field(6, 10, FixedWidthType::String);
+    schema.add_field(16, 9, FixedWidthType::Decimal);
+    schema.add_field(25, 8, FixedWidthType::Date);
+    return schema;
+}
+
+std::string record(const char* id, const char* name, const char* amount, const char* date) {
+    char buf[64];
+    const int n = std::snprintf(buf, sizeof(buf), "%6s%-10s%9s%8s", id, name, amount, date);
+    return std::string(buf, static_cast<std::size_t>(n));
+}
+} // namespace
+
+TEST_CASE("fixed width lines") {
+    const std::string lines = record("000042", "Alice", "12.50 ", "19700102") + "\n"
+                              + record("-7", "Bob", "-1.25e2", "20000229") + "\r\n" + "000003Carol  \n";
+    const KAStr text(lines.data(), lines.size());
+    const KAFixedWidthSchema schema = make_schema();
+    CHECK(schema.field_count() == 4);
+    KAFixedWidthColumns cols;
+    const ColumnParseResult r = schema.parse(text, cols);
+    CHECK(r.rows == 3);
+    CHECK(cols.rows() == 3);
+    CHECK(cols.field_count() == 4);
+    CHECK(cols.ints(0) == std::vector<std::int64_t>{42, -7, 3});
+    REQUIRE(cols.strings(1).size() == 3);
+    CHECK(cols.strings(1)[0] == "Alice");
+    CHECK(cols.strings(1)[1] == "Bob");
+    CHECK(cols.strings(1)[2] == "Carol");
+    // 字符串列指向原缓冲区
+    CHECK(cols.strings(1)[0].data() == text.data() + 6);
+    CHECK(cols.decimals(2)[0] == 12.5);
+    CHECK(cols.decimals(2)[1] == -125.0);
+    CHECK(cols.dates(3)[0] == 1);
+    CHECK(cols.dates(3)[1] == 11016);
+
+    // 第三行在 amount 之前就结束了
+    REQUIRE(r.errors.size() == 2);
+    CHECK(r.errors[0].row == 2);
+    CHECK(r.errors[0].column == 2);
+    CHECK(r.errors[0].error == ParseError::Empty);
+    CHECK(r.errors[1].column == 3);
+    CHECK(cols.decimals(2)[2] == 0);
+
+    CHECK_THROWS_AS(cols.ints(1), std::invalid_argument);
+    CHECK_THROWS_AS(cols.dates(9), std::invalid_argument);
+    CHECK(cols.type(3) == FixedWidthType::Date);
+}
+
+TEST_CASE("fixed width records without newlines") {
+    // 每条记录 33 字节数据加 2 字节填充
+    const std::string text = record("000001", "A", "1.0", "19700101") + "--" + record("00000x", "B", "2.0", "19701301")
+                             + "--" + record("000003", "C", "x", "1969-12-") + "--";
+    KAFixedWidthSchema schema = make_schema(35);
+    CHECK(schema.record_size() == 35);
+    KAFixedWidthColumns cols;
+    const ColumnParseResult r = schema.parse(KAStr(text.data(), text.size()), cols);
+    CHECK(r.rows == 3);
+    CHECK(cols.ints(0) == std::vector<std::int64_t>{1, 0, 3});
+    CHECK(cols.dates(3) == std::vector<std::int32_t>{0, 0, 0});
+    REQUIRE(r.errors.size() == 4);
+    CHECK(r.errors[0].row == 1);
+    CHECK(r.errors[0].column == 0);
+    CHECK(r.errors[0].offset == 35);
+    CHECK(r.errors[0].error == ParseError::InvalidChar);
+    CHECK(r.errors[1].column == 3);
+    CHECK(r.errors[2].row == 2);
+    CHECK(r.errors[2].column == 2);
+    CHECK(r.errors[2].offset == 70 + 24); // 去掉空白之后的位置
+    CHECK(r.errors[3].row == 2);
+    CHECK(r.errors[3].column == 3);
+
+    KAFixedWidthSchema iso;
+    iso.add_field(0, 10, FixedWidthType::Date);
+    const ColumnParseResult d = iso.parse("1970-01-02\n2000-02-29\n2001-02-29\n1970/01/01\n", cols);
+    CHECK(cols.dates(0) == std::vector<std::int32_t>{1, 11016, 0, 0});
+    REQUIRE(d.errors.size() == 2);
+    CHECK(d.errors[0].row == 2);
+    CHECK(d.errors[1].offset == 33);
+}
+
+TEST_CASE("fixed width trim policy") {
+    KAFixedWidthSchema schema;
+    schema.add_field(0, 5, FixedWidthType::String, FixedWidthTrim::None);
+    schema.add_field(0, 5, FixedWidthType::String, FixedWidthTrim::Left);
+    schema.add_field(0, 5, FixedWidthType::String, FixedWidthTrim::Right);
+    schema.add_field(0, 5, FixedWidthType::Int, FixedWidthTrim::None);
+    KAFixedWidthColumns cols;
+    const ColumnParseResult r = schema.parse(" ab  \n", cols);
+    CHECK(cols.strings(0)[0] == " ab  ");
+    CHECK(cols.strings(1)[0] == "ab  ");
+    CHECK(cols.strings(2)[0] == " ab");
+    REQUIRE(r.errors.size() == 1);
+    CHECK(r.errors[0].error == ParseError::InvalidChar);
+
+    CHECK_THROWS_AS(schema.add_field(0, 0, FixedWidthType::Int), std::invalid_argument);
+    KAFixedWidthSchema fixed(10);
+    CHECK_THROWS_AS(fixed.add_field(8, 3, FixedWidthType::Int), std::invalid_argument);
+    CHECK_THROWS_AS(fixed.add_field(10, 1, FixedWidthType::Int), std::invalid_argument);
+}
+
+TEST_CASE("fixed width empty input") {
+    KAFixedWidthColumns cols;
+    CHECK(make_schema().parse("", cols).rows == 0);
+    CHECK(cols.ints(0).empty());
+    CHECK(make_schema(35).parse("", cols).rows == 0);
+    // 末尾的换行不产生空记录, 中间的空行算一条记录
+    const ColumnParseResult r = make_schema().parse("000001\n\n000002\n", cols);
+    CHECK(r.rows == 3);
+    CHECK(cols.ints(0) == std::vector<std::int64_t>{1, 0, 2});
+}
+
+TEST_CASE("fixed width parallel") {
+    std::string lines, fixed;
+    for (int i = 0; i < 50000; ++i) {
+        char buf[64];
+        const int n = std::snprintf(buf, sizeof(buf), "%06dname%-6d%9.2f%04d%02d%02d", i, i % 1000, i * 0.25,
+                                    1970 + i % 50, 1 + i % 12, 1 + i % 28);
+        REQUIRE(n == 33);
+        lines.append(buf, 33);
+        lines += i % 3 == 0 ? "\r\n" : "\n";
+        fixed.append(buf, 33);
+        fixed += i % 7 == 0 ? "bad" : "   ";
+    }
+    // 每隔若干行放一个坏字段, 检查错误的行号在并行时也正确
+    for (std::size_t pos = 0; pos < fixed.size(); pos += 36 * 997) fixed[pos] = 'x';
+
+    KAFixedWidthSchema line_schema = make_schema();
+    KAFixedWidthColumns one, many;
+    const ColumnParseResult r1 = line_schema.parse(KAStr(lines.data(), lines.size()), one);
+    const ColumnParseResult r8 = line_schema.parse(KAStr(lines.data(), lines.size()), many, 8);
+    CHECK(r1.ok());
+    CHECK(r8.ok());
+    CHECK(r1.rows == 50000);
+    CHECK(r8.rows == 50000);
+    CHECK(one.ints(0) == many.ints(0));
+    CHECK(one.decimals(2) == many.decimals(2));
+    CHECK(one.dates(3) == many.dates(3));
+    CHECK(many.ints(0)[49999] == 49999);
+    CHECK(many.strings(1)[123] == "name123");
+
+    KAFixedWidthSchema fixed_schema = make_schema(36);
+    const ColumnParseResult f1 = fixed_schema.parse(KAStr(fixed.data(), fixed.size()), one);
+    const ColumnParseResult f8 = fixed_schema.parse(KAStr(fixed.data(), fixed.size()), many, 8);
+    CHECK(f1.rows == 50000);
+    REQUIRE(f1.errors.size() == f8.errors.size());
+    REQUIRE(f1.errors.size() == 51);
+    for (std::size_t k = 0; k < f1.errors.size(); ++k) {
+        CHECK(f8.errors[k].row == k * 997);
+        CHECK(f8.errors[k].offset == k * 997 * 36);
+    }
+    CHECK(one.ints(0) == many.ints(0));
+    CHECK(many.ints(0)[998] == 998);
+}
@@ -0,0 +1,524 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("KA_FMT compile-time format string") {
+    SUBCASE("plain fields") {
+        CHECK(KA_FMT("{} -> {:x}").fmt(42, 255) == "42 -> ff");
+        CHECK(KA_FMT("{}{}{}").fmt(1, "two", 3.5) == "1two3.5");
+        CHECK(KA_FMT("{:X}|{:b}|{:d}").fmt(255, 5, -7) == "FF|101|-7");
+    }
+
+    SUBCASE("no fields") {
+        CHECK(KA_FMT("").fmt() == "");
+        CHECK(KA_FMT("just text").fmt() == "just text");
+    }
+
+    SUBCASE("escaped braces") {
+        CHECK(KA_FMT("{{}}").fmt() == "{}");
+        CHECK(KA_FMT("{{{}}}").fmt(7) == "{7}");
+        CHECK(KA_FMT("a {{b}} {}").fmt("c") == "a {b} c");
+    }
+
+    SUBCASE("long literal") {
+        KAString s = KA_FMT("0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz {} end").fmt(1);
+        CHECK(s == "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz 1 end");
+    }
+
+    SUBCASE("same output as runtime fmt") {
+        std::vector<int> vec = {1, 2, 3};
+        CHECK(KA_FMT("vec: {}, ok: {}").fmt(vec, true) == KAStr("vec: {}, ok: {}").fmt(vec, true));
+        CHECK(KA_FMT("{}").fmt(std::chrono::milliseconds(15)) == "15ms");
+    }
+
+    SUBCASE("introspection") {
+        auto f = KA_FMT("x={} y={:x}");
+        CHECK(f.str() == "x={} y={:x}");
+        CHECK(decltype(f)::ARGS == 2);
+        CHECK(decltype(f)::SEGMENTS == 4);
+        CHECK(decltype(f)::LITERAL_BYTES == 5);
+    }
+
+    SUBCASE("call site is reusable") {
+        for (int i = 0; i < 3; ++i) {
+            CHECK(KA_FMT("#{}").fmt(i) == KAStr("#{}").fmt(i));
+        }
+    }
+}
+
+TEST_CASE("fmt_to and formatted_size") {
+    SUBCASE("append into existing KAString") {
+        KAString out("log: ");
+        KAStr("{} + {} = {}").fmt_to(out, 1, 2, 3);
+        CHECK(out == "log: 1 + 2 = 3");
+        KA_FMT(" [{:x}]").fmt_to(out, 255);
+        CHECK(out == "log: 1 + 2 = 3 [ff]");
+    }
+
+    SUBCASE("reuse buffer without reallocation") {
+        KAString out;
+        out.reserve(256);
+        const Byte* before = out.data();
+        for (int i = 0; i < 100; ++i) {
+            out.clear();
+            KAStr("request #{} from {} took {}").fmt_to(out, i, "10.0.0.1", std::string("3ms"));
+        }
+        CHECK(out == "request #99 from 10.0.0.1 took 3ms");
+        CHECK(out.data() == before);
+    }
+
+    SUBCASE("fixed buffer fits") {
+        char buf[32];
+        FormatResult r = KAStr("id={} name={}").fmt_to(buf, sizeof(buf), 7, "bob");
+        CHECK(! r.truncated());
+        CHECK(r.size == 13);
+        CHECK(r.written == 13);
+        CHECK(KAStr(buf, r.written) == "id=7 name=bob");
+    }
+
+    SUBCASE("fixed buffer truncates") {
+        char buf[8];
+        std::memset(buf, '#', sizeof(buf));
+        FormatResult r = KAStr("{}-{}").fmt_to(buf, 5, 12345, 678);
+        CHECK(r.truncated());
+        CHECK(r.size == 9);
+        CHECK(r.written == 5);
+        CHECK(KAStr(buf, 5) == "12345");
+        CHECK(buf[5] == '#');
+
+        r = KA_FMT("{}-{}").fmt_to(buf, 0, 1, 2);
+        CHECK(r.size == 3);
+        CHECK(r.written == 0);
+    }
+
+    SUBCASE("formatted_size") {
+        CHECK(KAStr("{} {}").formatted_size(-123, "ab") == 7);
+        CHECK(KAStr("{{}}").formatted_size() == 2);
+        CHECK(KA_FMT("{:b}").formatted_size(5) == 3);
+        KAStr f("x={:X}, s={}");
+        CHECK(f.formatted_size(48879, "str") == f.fmt(48879, "str").byte_size());
+    }
+
+    SUBCASE("argument types") {
+        CHECK(KAStr("{}|{}|{}").fmt('c', KAStr("view"), KAString("own")) == "c|view|own");
+        CHECK(KAStr("{:d}").fmt('A') == "65");
+        CHECK(KAStr("{}|{:x}|{:b}").fmt(-1LL, static_cast<unsigned char>(255), static_cast<short>(-1))
+              == "-1|ff|1111111111111111");
+        CHECK(KAStr("{:x}").fmt(-1) == "ffffffff");
+        CHECK(KAStr("{}").fmt(1.5f) == "1.5");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<long long>::min()) == "-9223372036854775808");
+    }
+
+    SUBCASE("errors are still reported") {
+        KAString out;
+        CHECK_THROWS_AS(KAStr("{} {}").fmt_to(out, 1), std::invalid_argument);
+        char buf[4];
+        CHECK_THROWS_AS(KAStr("{:z}").fmt_to(buf, sizeof(buf), 1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("}").formatted_size(), std::invalid_argument);
+    }
+}
+
+TEST_CASE("integer formatting matches printf") {
+    std::uint64_t x = 0x9E3779B97F4A7C15ull;
+    char buf[80];
+    for (int i = 0; i < 5000; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const std::uint64_t v = x >> (i % 64);
+        const long long sv = static_cast<long long>(v) * (i % 2 ? -1 : 1);
+
+        std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+        CHECK(KAStr("{}").fmt(v) == buf);
+        std::snprintf(buf, sizeof(buf), "%lld", sv);
+        CHECK(KAStr("{}").fmt(sv) == buf);
+        std::snprintf(buf, sizeof(buf), "%llx", static_cast<unsigned long long>(v));
+        CHECK(KAStr("{:x}").fmt(v) == buf);
+        std::snprintf(buf, sizeof(buf), "%llX", static_cast<unsigned long long>(v));
+        CHECK(KAStr("{:X}").fmt(v) == buf);
+        std::snprintf(buf, sizeof(buf), "%d", static_cast<std::int16_t>(v));
+        CHECK(KAStr("{}").fmt(static_cast<std::int16_t>(v)) == buf);
+    }
+    CHECK(KAStr("{:b}").fmt(std::uint64_t(1) << 63) == "1000000000000000000000000000000000000000000000000000000000000000");
+    CHECK(KAStr("{:x}").fmt(static_cast<std::int8_t>(-1)) == "ff");
+    CHECK(KAStr("{:b}").fmt(0) == "0");
+}
+
+static std::uint64_t next_rand(std::uint64_t& x) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+// 取出有效数字: 去掉符号、小数点、指数以及首尾的 0
+static std::string significant_digits(const std::string& s) {
+    std::string d;
+    for (char c : s) {
+        if (c == 'e' || c == 'E') break;
+        if (c >= '0' && c <= '9') d += c;
+    }
+    d.erase(0, d.find_first_not_of('0'));
+    while (! d.empty() && d.back() == '0') d.pop_back();
+    return d;
+}
+
+// 用 printf 逐个精度尝试, 得到最短且最接近的有效数字串
+template <typename T>
+static std::string reference_shortest(T v) {
+    char buf[64];
+    for (int p = 1; p <= 17; ++p) {
+        std::snprintf(buf, sizeof(buf), "%.*e", p - 1, static_cast<double>(v));
+        if (static_cast<T>(std::strtod(buf, nullptr)) == v) break;
+    }
+    if (sizeof(T) == sizeof(float)) {
+        for (int p = 1; p <= 9; ++p) {
+            std::snprintf(buf, sizeof(buf), "%.*e", p - 1, static_cast<double>(v));
+            if (std::strtof(buf, nullptr) == static_cast<float>(v)) break;
+        }
+    }
+    return significant_digits(buf);
+}
+
+TEST_CASE("shortest floating-point formatting") {
+    SUBCASE("layout") {
+        CHECK(KAStr("{}").fmt(0.0) == "0");
+        CHECK(KAStr("{}").fmt(-0.0) == "-0");
+        CHECK(KAStr("{}").fmt(1.0) == "1");
+        CHECK(KAStr("{}").fmt(0.1) == "0.1");
+        CHECK(KAStr("{}").fmt(0.3) == "0.3");
+        CHECK(KAStr("{}").fmt(0.1 + 0.2) == "0.30000000000000004");
+        CHECK(KAStr("{}").fmt(123.456) == "123.456");
+        CHECK(KAStr("{}").fmt(1e15) == "1000000000000000");
+        CHECK(KAStr("{}").fmt(1e16) == "1e+16");
+        CHECK(KAStr("{}").fmt(1.5e300) == "1.5e+300");
+        CHECK(KAStr("{}").fmt(0.0001) == "0.0001");
+        CHECK(KAStr("{}").fmt(0.00001) == "1e-05");
+        CHECK(KAStr("{}").fmt(-2.5e-10) == "-2.5e-10");
+        CHECK(KAStr("{}").fmt(5e-324) == "5e-324");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<double>::max()) == "1.7976931348623157e+308");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<double>::infinity()) == "inf");
+        CHECK(KAStr("{}").fmt(-std::numeric_limits<double>::infinity()) == "-inf");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<double>::quiet_NaN()) == "nan");
+    }
+
+    SUBCASE("float uses float precision") {
+        CHECK(KAStr("{}").fmt(0.1f) == "0.1");
+        CHECK(KAStr("{}").fmt(1.0f / 3.0f) == "0.33333334");
+        CHECK(KAStr("{}").fmt(16777216.0f) == "16777216");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<float>::max()) == "3.4028235e+38");
+        CHECK(KAStr("{}").fmt(std::numeric_limits<float>::denorm_min()) == "1e-45");
+    }
+
+    SUBCASE("random doubles round-trip with the fewest digits") {
+        std::uint64_t x = 0x2545F4914F6CDD1Dull;
+        int bad = 0;
+        for (int i = 0; i < 20000; ++i) {
+            std::uint64_t bits = next_rand(x);
+            double v;
+            std::memcpy(&v, &bits, sizeof(v));
+            if (v != v || v - v != 0) continue;
+            const KAString out = KAStr("{}").fmt(v);
+            const std::string s(out);
+            if (std::strtod(s.c_str(), nullptr) != v || significant_digits(s) != reference_shortest(v)) ++bad;
+        }
+        CHECK(bad == 0);
+    }
+
+    SUBCASE("random floats round-trip with the fewest digits") {
+        std::uint64_t x = 0x9E3779B97F4A7C15ull;
+        int bad = 0;
+        for (int i = 0; i < 20000; ++i) {
+            const std::uint32_t bits = static_cast<std::uint32_t>(next_rand(x));
+            float v;
+            std::memcpy(&v, &bits, sizeof(v));
+            if (v != v || v - v != 0) continue;
+            const std::string s(KAStr("{}").fmt(v));
+            if (std::strtof(s.c_str(), nullptr) != v || significant_digits(s) != reference_shortest(v)) ++bad;
+        }
+        CHECK(bad == 0);
+    }
+}
+
+TEST_CASE("precision floating-point formatting matches printf") {
+    const double values[] = {0.0, -0.0, 0.5, 1.5, 2.5, 0.125, 0.375, 1e-5, 123.456, 9.9995, 0.05, 1e22, 1e23,
+                             5e-324, 1.7976931348623157e308, -3.25, 999999.5, 0.00001234, 1234567.0};
+    const char types[] = {'f', 'e', 'g'};
+    const int precisions[] = {0, 1, 2, 3, 6, 10, 17, 25};
+    char buf[1024];
+    int bad = 0;
+    for (double v : values) {
+        for (char t : types) {
+            for (int p : precisions) {
+                char f[16];
+                std::snprintf(f, sizeof(f), "%%.%d%c", p, t);
+                std::snprintf(buf, sizeof(buf), f, v);
+                if (KAString::from_num(v, t, p) != buf) ++bad;
+            }
+        }
+    }
+    CHECK(bad == 0);
+
+    std::uint64_t x = 0xD1B54A32D192ED03ull;
+    bad = 0;
+    for (int i = 0; i < 3000; ++i) {
+        std::uint64_t bits = next_rand(x);
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        if (v != v || v - v != 0) continue;
+        const char t = types[i % 3];
+        const int p = static_cast<int>(next_rand(x) % 20);
+        if (t == 'f' && std::fabs(v) > 1e60) continue;
+        char f[16];
+        std::snprintf(f, sizeof(f), "%%.%d%c", p, t);
+        std::snprintf(buf, sizeof(buf), f, v);
+        if (KAString::from_num(v, t, p) != buf) ++bad;
+    }
+    CHECK(bad == 0);
+
+    CHECK(KAString::from_num(std::numeric_limits<double>::infinity(), 'f', 2) == "inf");
+    CHECK(KAString::from_num(-std::numeric_limits<double>::infinity(), 'e', 2) == "-inf");
+    CHECK(KAString::from_num(1e300, 'f', 0).byte_size() == 301);
+}
+
+TEST_CASE("format spec: fill, align, width, sign, alternate form") {
+    SUBCASE("width and alignment") {
+        CHECK(KAStr("[{:5}]").fmt(42) == "[   42]");
+        CHECK(KAStr("[{:5}]").fmt("ab") == "[ab   ]");
+        CHECK(KAStr("[{:<5}]").fmt(42) == "[42   ]");
+        CHECK(KAStr("[{:>5}]").fmt("ab") == "[   ab]");
+        CHECK(KAStr("[{:^6}]").fmt("ab") == "[  ab  ]");
+        CHECK(KAStr("[{:^5}]").fmt("ab") == "[ ab  ]");
+        CHECK(KAStr("[{:*^7}]").fmt(1) == "[***1***]");
+        CHECK(KAStr("[{:2}]").fmt("abcd") == "[abcd]");
+        CHECK(KAStr("[{:>4}]").fmt(true) == "[true]");
+        CHECK(KAStr("[{:-<6}]").fmt(std::chrono::seconds(3)) == "[3s----]");
+    }
+
+    SUBCASE("sign and zero padding") {
+        CHECK(KAStr("{:+}|{:+}|{: }|{:-}").fmt(5, -5, 5, 5) == "+5|-5| 5|5");
+        CHECK(KAStr("{:05}").fmt(-42) == "-0042");
+        CHECK(KAStr("{:+06}").fmt(42) == "+00042");
+        CHECK(KAStr("{:#010x}").fmt(255) == "0x000000ff");
+        CHECK(KAStr("{:<05}").fmt(7) == "7    ");
+        CHECK(KAStr("{:08.3f}").fmt(-3.14159) == "-003.142");
+        CHECK(KAStr("{:06}").fmt(std::numeric_limits<double>::infinity()) == "   inf");
+    }
+
+    SUBCASE("alternate form and integer types") {
+        CHECK(KAStr("{:#x}|{:#X}|{:#b}|{:#B}|{:#o}|{:o}").fmt(255, 255, 5, 5, 8, 8) == "0xff|0XFF|0b101|0B101|010|10");
+        CHECK(KAStr("{:#o}").fmt(0) == "0");
+        CHECK(KAStr("{:c}").fmt(65) == "A");
+        CHECK(KAStr("{:d}|{:x}").fmt('A', 'A') == "65|41");
+        CHECK(KAStr("{:.2f}").fmt(3) == "3.00");
+    }
+
+    SUBCASE("precision") {
+        CHECK(KAStr("{:.3}").fmt("abcdef") == "abc");
+        CHECK(KAStr("[{:>6.2}]").fmt(std::string("abc")) == "[    ab]");
+        CHECK(KAStr("{:.3}").fmt(3.14159) == "3.14");
+        CHECK(KAStr("{:.2e}|{:.1F}").fmt(12345.0, 0.25) == "1.23e+04|0.2");
+        CHECK(KAStr("{:#.0f}").fmt(2.0) == "2.");
+        CHECK(KAStr("[{:10.3f}]").fmt(2.5) == "[     2.500]");
+    }
+
+    SUBCASE("dynamic width and precision") {
+        CHECK(KAStr("[{:>{}}]").fmt("ab", 5) == "[   ab]");
+        CHECK(KAStr("[{:.{}f}]").fmt(3.14159, 2) == "[3.14]");
+        CHECK(KAStr("[{:{}.{}f}] {}").fmt(3.14159, 8, 3, "end") == "[   3.142] end");
+        CHECK_THROWS_AS(KAStr("{:>{}}").fmt("ab", -1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{:>{}}").fmt("ab", "x"), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{:>{}}").fmt("ab"), std::invalid_argument);
+    }
+
+    SUBCASE("KA_FMT accepts the same grammar") {
+        CHECK(KA_FMT("[{:*^7}|{:+05}|{:#x}]").fmt(1, 42, 255) == "[***1***|+0042|0xff]");
+        CHECK(KA_FMT("[{:>{}}|{:{}.{}f}]").fmt("ab", 5, 3.14159, 8, 3) == "[   ab|   3.142]");
+        auto f = KA_FMT("{:>{}} {:.{}}");
+        CHECK(decltype(f)::ARGS == 4);
+        CHECK(KA_FMT("[{:<8.3e}]").fmt(1234.5) == KAStr("[{:<8.3e}]").fmt(1234.5));
+    }
+
+    SUBCASE("long padded values") {
+        KAString wide = KAStr("{:>300}").fmt("x");
+        CHECK(wide.byte_size() == 300);
+        CHECK(wide[299] == 'x');
+        std::string body(300, 'y');
+        CHECK(KAStr("{:#>302}").fmt(body) == "##" + body);
+    }
+
+    SUBCASE("invalid specs") {
+        CHECK_THROWS_AS(KAStr("{:z}").fmt(1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{:5.}").fmt(1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{:x5}").fmt(1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{:5x3}").fmt(1), std::invalid_argument);
+        CHECK(KAStr("{:<>5}").fmt(1) == "<<<<1");
+    }
+}
+
+TEST_CASE("positional and named arguments") {
+    SUBCASE("positional reuse") {
+        CHECK(KAStr("{0}{1}{0}").fmt("ab", "cd") == "abcdab");
+        CHECK(KAStr("{1} {0}").fmt(1, 2) == "2 1");
+        CHECK(KAStr("{0:x} {0:#b} {0:>4}").fmt(5) == "5 0b101    5");
+        CHECK(KAStr("{1}").fmt(1, 2, 3) == "2");
+    }
+
+    SUBCASE("named arguments") {
+        CHECK(KAStr("{name} is {age}").fmt(arg("name", "bob"), arg("age", 42)) == "bob is 42");
+        CHECK(KAStr("{age:>5}|{name:.1}").fmt(arg("name", "bob"), arg("age", 42)) == "   42|b");
+        CHECK(KAStr("{} {}").fmt(arg("a", 1), arg("b", 2)) == "1 2");
+        CHECK(KAStr("{1} {a}").fmt(arg("a", 1), arg("b", 2)) == "2 1");
+        CHECK(KA_FMT("{}-{}").fmt(arg("a", 1), 2) == "1-2");
+    }
+
+    SUBCASE("dynamic width by index") {
+        CHECK(KAStr("[{0:>{1}}]").fmt("ab", 4) == "[  ab]");
+        CHECK(KAStr("[{0:{1}.{2}f}]").fmt(3.14159, 7, 2) == "[   3.14]");
+        CHECK(KAStr("[{v:^{1}}]").fmt(arg("v", 'x'), 3) == "[ x ]");
+    }
+
+    SUBCASE("every argument kind") {
+        const signed char sc = -1;
+        const unsigned char uc = 200;
+        const short sh = -2;
+        const unsigned long long ull = 18446744073709551615ull;
+        char text[] = "mutable";
+        std::vector<int> vec = {1, 2};
+        CHECK(KAStr("{}|{:x}|{}|{:d}").fmt(sc, sc, 'q', uc) == KAStr("{}|ff|q|200").fmt(sc));
+        CHECK(KAStr("{:x}|{}|{:X}").fmt(sh, ull, ull) == "fffe|18446744073709551615|FFFFFFFFFFFFFFFF");
+        CHECK(KAStr("{}|{}|{}").fmt(0.1f, 0.1, 2.5L) == "0.1|0.1|2.5");
+        CHECK(KAStr("{}|{}|{}").fmt(text, KAString("own"), vec) == "mutable|own|[1, 2]");
+        const char* null_str = nullptr;
+        CHECK(KAStr("[{}]").fmt(null_str) == "[]");
+    }
+
+    SUBCASE("errors") {
+        CHECK_THROWS_AS(KAStr("{0} {}").fmt(1, 2), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{} {0}").fmt(1, 2), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{2}").fmt(1, 2), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{missing}").fmt(arg("name", 1)), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{1x}").fmt(1, 2), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{-}").fmt(1), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{0:>{}}").fmt("ab", 3), std::invalid_argument);
+        CHECK_THROWS_AS(KAStr("{}").fmt(), std::invalid_argument);
+    }
+}
+
+namespace {
+struct Point {
+    int x;
+    int y;
+};
+
+struct Streamed {
+    int v;
+};
+
+std::ostream& operator<<(std::ostream& os, const Streamed& s) {
+    return os << "S" << s.v;
+}
+} // namespace
+
+namespace kastring {
+template <>
+struct formatter<Point> : FormatterBase {
+    void format(const Point& p, FormatSink& sink) const {
+        sink.push_back('(');
+        formatter<int> f;
+        f.parse(spec);
+        f.format(p.x, sink);
+        sink.append(", ", 2);
+        f.format(p.y, sink);
+        sink.push_back(')');
+    }
+};
+} // namespace kastring
+
+TEST_CASE("formatter<T> customization") {
+    SUBCASE("user specialization") {
+        Point p = {3, -4};
+        CHECK(KAStr("{}").fmt(p) == "(3, -4)");
+        CHECK(KAStr("{:+}").fmt(p) == "(+3, -4)");
+        CHECK(KA_FMT("at {:x}").fmt(Point{255, 16}) == "at (ff, 10)");
+        std::vector<Point> pts = {{1, 2}, {3, 4}};
+        CHECK(KAStr("{}").fmt(pts) == "[(1, 2), (3, 4)]");
+    }
+
+    SUBCASE("operator<< fallback") {
+        CHECK(KAStr("[{:>4}]").fmt(Streamed{7}) == "[  S7]");
+    }
+
+    SUBCASE("containers") {
+        std::vector<std::string> words = {"a", "bc"};
+        std::map<std::string, int> m = {{"x", 1}, {"y", 2}};
+        std::set<int> st = {3, 1, 2};
+        std::list<double> ls = {0.5, 2.0};
+        std::vector<std::vector<int> > nested = {{1}, {2, 3}};
+        CHECK(KAStr("{}").fmt(words) == "[a, bc]");
+        CHECK(KAStr("{}").fmt(m) == "{x: 1, y: 2}");
+        CHECK(KAStr("{}").fmt(st) == "{1, 2, 3}");
+        CHECK(KAStr("{}").fmt(ls) == "[0.5, 2]");
+        CHECK(KAStr("{}").fmt(nested) == "[[1], [2, 3]]");
+        CHECK(KAStr("{}").fmt(std::vector<int>()) == "[]");
+        CHECK(KAStr("{}").fmt(std::make_pair(1, "one")) == "(1, one)");
+        CHECK(KAStr("{:#x}").fmt(std::vector<int>{10, 255}) == "[0xa, 0xff]");
+        CHECK(KAStr("[{:*^8}]").fmt(std::vector<int>{1, 2}) == "[*[1, 2]*]");
+        CHECK(KAStr("{:.1f}").fmt(std::vector<double>{1.25, 2}) == "[1.2, 2.0]");
+    }
+
+    SUBCASE("large container is not truncated by padding") {
+        std::vector<int> big(200, 7);
+        KAString out = KAStr("{:>10}").fmt(big);
+        CHECK(out.byte_size() == 2 + 200 + 2 * 199);
+        CHECK(out == KAStr("{}").fmt(big));
+    }
+
+    SUBCASE("chrono") {
+        CHECK(KAStr("{} {} {} {} {} {}")
+                  .fmt(std::chrono::nanoseconds(1), std::chrono::microseconds(2), std::chrono::milliseconds(3),
+                       std::chrono::seconds(4), std::chrono::minutes(5), std::chrono::hours(6))
+              == "1ns 2us 3ms 4s 5min 6h");
+        CHECK(KAStr("{:.1f}").fmt(std::chrono::duration<double>(1.25)) == "1.2s");
+        CHECK(KAStr("{}").fmt(std::chrono::duration<int, std::ratio<86400> >(2)) == "2[86400]s");
+        CHECK(KAStr("{}").fmt(std::chrono::duration<int, std::ratio<1, 30> >(3)) == "3[1/30]s");
+        CHECK(KAStr("[{:>5}]").fmt(std::chrono::seconds(3)) == "[   3s]");
+
+        const std::time_t t = 0;
+        std::tm tm_buf;
+        localtime_r(&t, &tm_buf);
+        char expect[32];
+        std::strftime(expect, sizeof(expect), "%Y-%m-%dT%H:%M:%S", &tm_buf);
+        const std::string local = KAStr("{}").fmt(std::chrono::system_clock::from_time_t(t));
+        CHECK(local.substr(0, 19) == expect);
+        CHECK(local.size() == 25);
+        const std::chrono::system_clock::time_point tp =
+            std::chrono::system_clock::from_time_t(t) + std::chrono::milliseconds(1500);
+        const std::string ms = KAStr("{:.3}").fmt(tp);
+        CHECK(ms.size() == 29);
+        CHECK(ms.substr(17, 6) == "01.500");
+        CHECK(ms.substr(23) == local.substr(19));
+        const std::string padded = KAStr("[{:>27}]").fmt(tp);
+        CHECK(padded.substr(0, 3) == "[  ");
+    }
+
+    SUBCASE("formatter for builtin types") {
+        formatter<std::string> f;
+        f.parse(parse_spec(":>5"));
+        KAString out;
+        FormatSink sink(out);
+        f.format(std::string("ab"), sink);
+        CHECK(out == "   ab");
+    }
+}
@@ -0,0 +1,213 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("KAFormatTemplate parses once and formats many times") {
+    SUBCASE("same output as KAStr::fmt") {
+        KAFormatTemplate t("alert {} on {:>6}: {:.2f}%");
+        for (int i = 0; i < 5; ++i) {
+            CHECK(t.fmt(i, "db01", 97.125 + i) == KAStr("alert {} on {:>6}: {:.2f}%").fmt(i, "db01", 97.125 + i));
+        }
+        CHECK(t.str() == "alert {} on {:>6}: {:.2f}%");
+        CHECK(t.arg_count() == 3);
+        CHECK(t.instruction_count() == 7);
+        CHECK(t.literal_bytes() == 13);
+    }
+
+    SUBCASE("escaped braces merge into the preceding literal") {
+        KAFormatTemplate t("a{{b}}c {}");
+        CHECK(t.fmt(1) == "a{b}c 1");
+        CHECK(t.instruction_count() == 4);
+    }
+
+    SUBCASE("positional, named and dynamic fields") {
+        KAFormatTemplate t("{1}-{0}-{1}");
+        CHECK(t.arg_count() == 2);
+        CHECK(t.fmt("a", "b") == "b-a-b");
+
+        KAFormatTemplate named("{host}:{port}");
+        CHECK(named.arg_count() == 0);
+        CHECK(named.fmt(arg("port", 80), arg("host", "example")) == "example:80");
+
+        KAFormatTemplate dyn("[{:>{}}]");
+        CHECK(dyn.arg_count() == 2);
+        CHECK(dyn.fmt("x", 3) == "[  x]");
+    }
+
+    SUBCASE("fmt_to and formatted_size") {
+        KAFormatTemplate t("{}+{}");
+        KAString out("= ");
+        t.fmt_to(out, 1, 2);
+        CHECK(out == "= 1+2");
+        char buf[2];
+        FormatResult r = t.fmt_to(buf, sizeof(buf), 10, 20);
+        CHECK(r.size == 5);
+        CHECK(r.truncated());
+        CHECK(t.formatted_size(100, 200) == 7);
+    }
+
+    SUBCASE("copies and moves keep working") {
+        KAFormatTemplate t("x={}");
+        KAFormatTemplate copy = t;
+        KAFormatTemplate moved = std::move(t);
+        CHECK(copy.fmt(1) == "x=1");
+        CHECK(moved.fmt(2) == "x=2");
+    }
+
+    SUBCASE("errors") {
+        CHECK_THROWS_AS(KAFormatTemplate("{"), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("}"), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("{:z}"), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("{} {0}"), std::invalid_argument);
+        KAFormatTemplate t("{} {}");
+        CHECK_THROWS_AS(t.fmt(1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("KAFormatCache") {
+    SUBCASE("hit and miss") {
+        KAFormatCache cache(4);
+        std::string f = "id={}";
+        CHECK(cache.fmt(KAStr(f.c_str()), 1) == "id=1");
+        CHECK(cache.fmt("id={}", 2) == "id=2");
+        CHECK(cache.size() == 1);
+        CHECK(cache.misses() == 1);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.get("id={}") == cache.get("id={}"));
+    }
+
+    SUBCASE("LRU eviction") {
+        KAFormatCache cache(2);
+        std::shared_ptr<const KAFormatTemplate> a = cache.get("a{}");
+        cache.get("b{}");
+        cache.get("a{}"); // a 变为最近使用
+        cache.get("c{}"); // 淘汰 b
+        CHECK(cache.size() == 2);
+        CHECK(cache.get("a{}") == a);
+        const std::size_t misses = cache.misses();
+        cache.get("b{}");
+        CHECK(cache.misses() == misses + 1);
+        CHECK(a->fmt(1) == "a1");
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(a->fmt(2) == "a2");
+    }
+
+    SUBCASE("errors are not cached") {
+        KAFormatCache cache;
+        CHECK_THROWS_AS(cache.get("{"), std::invalid_argument);
+        CHECK(cache.size() == 0);
+        CHECK_THROWS_AS(KAFormatCache(0), std::invalid_argument);
+    }
+
+    SUBCASE("concurrent use") {
+        KAFormatCache cache(8);
+        std::vector<std::thread> threads;
+        std::vector<int> ok(4, 0);
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&cache, &ok, t]() {
+                for (int i = 0; i < 500; ++i) {
+                    const int k = (i + t) % 12;
+                    std::string f = "k" + std::to_string(k) + "={}";
+                    if (cache.fmt(KAStr(f.c_str()), i) == KAStr(f.c_str()).fmt(i)) ++ok[static_cast<std::size_t>(t)];
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        for (int n : ok) CHECK(n == 500);
+        CHECK(cache.size() <= 8);
+        CHECK(cache.hits() + cache.misses() == 2000);
+    }
+
+    SUBCASE("misses count inserted entries only") {
+        // 多个线程同时请求同一批新格式串, 输掉插入竞争的线程不算未命中
+        KAFormatCache cache(64);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&cache, &go]() {
+                while (! go.load()) std::this_thread::yield();
+                for (int round = 0; round < 3; ++round) {
+                    for (int k = 0; k < 16; ++k) {
+                        const std::string f = "m" + std::to_string(k) + "={}";
+                        cache.get(KAStr(f.c_str()));
+                    }
+                }
+            });
+        }
+        go = true;
+        for (auto& th : threads) th.join();
+        CHECK(cache.size() == 16);
+        CHECK(cache.misses() == 16);
+        CHECK(cache.hits() == 4 * 3 * 16 - 16);
+    }
+}
+
+TEST_CASE("KAFormatTemplate::fmt_rows columnar batch formatting") {
+    SUBCASE("matches row-by-row fmt") {
+        std::vector<int> ids = {1, 22, 333};
+        std::vector<std::string> names = {"a", "bb", "ccc"};
+        std::vector<unsigned> flags = {255, 16, 0};
+        KAFormatTemplate t("{},{},{:x}\n");
+        CHECK(t.fmt_rows(ids, names, flags) == "1,a,ff\n22,bb,10\n333,ccc,0\n");
+
+        KAString expect;
+        for (std::size_t i = 0; i < ids.size(); ++i) expect.append(t.fmt(ids[i], names[i], flags[i]));
+        CHECK(t.fmt_rows(ids, names, flags) == expect);
+    }
+
+    SUBCASE("any indexable column type") {
+        const double arr[] = {0.5, 1.25};
+        span<const double> sp(arr);
+        std::array<const char*, 2> labels = {{"x", "y"}};
+        KAFormatTemplate t("{1}={0:.1f};");
+        CHECK(t.fmt_rows(sp, labels) == "x=0.5;y=1.2;");
+    }
+
+    SUBCASE("dynamic width from a column and appending") {
+        std::vector<std::string> v = {"a", "b"};
+        std::vector<int> w = {3, 1};
+        KAString out("> ");
+        KAFormatTemplate("[{:>{}}]").fmt_rows_to(out, 1, v, w);
+        CHECK(out == "> [  a][b]");
+    }
+
+    SUBCASE("empty columns and literal-only template") {
+        std::vector<int> none;
+        CHECK(KAFormatTemplate("{}\n").fmt_rows(none) == "");
+        CHECK(KAFormatTemplate("x").fmt_rows() == "");
+    }
+
+    SUBCASE("parallel output equals sequential output") {
+        const std::size_t n = 50000;
+        std::vector<std::uint64_t> a(n);
+        std::vector<double> b(n);
+        std::vector<std::string> c(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            a[i] = i * 2654435761u;
+            b[i] = static_cast<double>(i) / 7.0;
+            c[i] = std::string(i % 5, 'z');
+        }
+        KAFormatTemplate t("{0},{1:.3f},{2},{0:x}\n");
+        const KAString seq = t.fmt_rows(a, b, c);
+        CHECK(t.fmt_rows_parallel(4, a, b, c) == seq);
+        CHECK(t.fmt_rows_parallel(64, a, b, c) == seq);
+        CHECK(seq.as_kastr().starts_with("0,0.000,,0\n"));
+    }
+
+    SUBCASE("errors") {
+        std::vector<int> a = {1, 2};
+        std::vector<int> b = {1};
+        std::vector<std::string> s = {"x", "y"};
+        CHECK_THROWS_AS(KAFormatTemplate("{}{}").fmt_rows(a, b), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("{}{}").fmt_rows(a), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("{name}").fmt_rows(a), std::invalid_argument);
+        CHECK_THROWS_AS(KAFormatTemplate("{:{}}").fmt_rows(a, s), std::invalid_argument);
+    }
+}
@@ -0,0 +1,123 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("hash_bytes") {
+    const char* a = "the quick brown fox jumps over the lazy dog";
+    KAStr s(a);
+    CHECK(hash_bytes(s.data(), s.byte_size()) == hash_bytes(s.data(), s.byte_size()));
+    CHECK(hash_bytes(s.data(), s.byte_size()) != hash_bytes(s.data(), s.byte_size() - 1));
+    CHECK(hash_bytes(s.data(), s.byte_size(), 1) != hash_bytes(s.data(), s.byte_size(), 2));
+    CHECK(hash_bytes(nullptr, 0) == hash_bytes(s.data(), 0));
+
+    // 各种长度都不应碰撞
+    std::set<std::uint64_t> seen;
+    for (std::size_t n = 0; n <= s.byte_size(); ++n) seen.insert(hash_bytes(s.data(), n));
+    CHECK(seen.size() == s.byte_size() + 1);
+}
+
+TEST_CASE("KAInterner dedup and resolve") {
+    KAInterner in;
+    CHECK(in.empty());
+
+    SUBCASE("same content same id") {
+        std::string a = "cpu.usage";
+        std::string b = "cpu.usage";
+        auto id1 = in.intern(KAStr(a));
+        auto id2 = in.intern(KAStr(b));
+        auto id3 = in.intern("mem.usage");
+        CHECK(id1 == id2);
+        CHECK(id1 != id3);
+        CHECK(in.size() == 2);
+        CHECK(in.resolve(id1) == "cpu.usage");
+        CHECK(in.resolve(id3) == "mem.usage");
+        // 返回的视图指向 arena, 而不是调用方的缓冲区
+        CHECK(in.resolve(id1).data() != reinterpret_cast<const Byte*>(a.data()));
+    }
+
+    SUBCASE("empty string") {
+        auto id = in.intern("");
+        CHECK(in.intern(KAStr()) == id);
+        CHECK(in.resolve(id).empty());
+    }
+
+    SUBCASE("find does not insert") {
+        KAInterner::id_type id = 0;
+        CHECK_FALSE(in.find("host", id));
+        CHECK_FALSE(in.contains("host"));
+        auto real = in.intern("host");
+        CHECK(in.find("host", id));
+        CHECK(id == real);
+        CHECK(in.size() == 1);
+    }
+
+    SUBCASE("unknown id throws") {
+        in.intern("a");
+        CHECK_THROWS_AS(in.resolve(0xfffffff0u), std::out_of_range);
+    }
+
+    SUBCASE("zero chunk size is rejected") {
+        CHECK_THROWS_AS(KAInterner(0), std::invalid_argument);
+    }
+}
+
+TEST_CASE("KAInterner views stay valid while growing") {
+    KAInterner in(256);
+    std::vector<KAInterner::id_type> ids;
+    std::vector<KAStr> views;
+    for (int i = 0; i < 20000; ++i) {
+        std::string name = "metric_" + std::to_string(i);
+        if (i % 997 == 0) name += std::string(300, 'x'); // 大于块大小的字符串单独分配
+        ids.push_back(in.intern(KAStr(name)));
+        views.push_back(in.resolve(ids.back()));
+    }
+    CHECK(in.size() == 20000);
+    CHECK(in.arena_bytes() > 0);
+
+    for (int i = 0; i < 20000; ++i) {
+        std::string name = "metric_" + std::to_string(i);
+        if (i % 997 == 0) name += std::string(300, 'x');
+        CHECK(views[i] == KAStr(name));
+        CHECK(in.resolve(ids[i]).data() == views[i].data());
+        CHECK(in.intern(KAStr(name)) == ids[i]);
+    }
+    CHECK(in.size() == 20000);
+}
+
+TEST_CASE("KAInterner concurrent interning") {
+    KAInterner in;
+    const int kThreads = 8;
+    const int kNames = 5000;
+    std::vector<std::vector<KAInterner::id_type>> results(kThreads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&in, &results, t]() {
+            for (int i = 0; i < kNames; ++i) {
+                // 每个线程以不同顺序驻留同一批名字
+                int n = (i * 7 + t * 131) % kNames;
+                std::string name = "label_" + std::to_string(n);
+                auto id = in.intern(KAStr(name));
+                if (in.resolve(id) != KAStr(name)) throw std::runtime_error("resolve mismatch");
+                results[t].push_back(id);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    CHECK(in.size() == static_cast<std::size_t>(kNames));
+    for (int t = 1; t < kThreads; ++t) {
+        for (int i = 0; i < kNames; ++i) {
+            std::string name = "label_" + std::to_string((i * 7 + t * 131) % kNames);
+            KAInterner::id_type id = 0;
+            REQUIRE(in.find(KAStr(name), id));
+            CHECK(results[t][i] == id);
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+std::string escape(const std::string& s) {
+    KAString out;
+    json_escape_to(out, KAStr(s.data(), s.size()));
+    return out;
+}
+
+std::string unescape(const std::string& s, bool expect_ok = true) {
+    KAString out;
+    CHECK(json_unescape_to(out, KAStr(s.data(), s.size())) == expect_ok);
+    return out;
+}
+
+// 把整个文档转成 "kind:text" 序列, 便于比较
+std::vector<std::string> tokens(const char* doc) {
+    static const char* names[] = {"{", "}", "[", "]", "key", "str", "num", "true", "false", "null", "end", "error"};
+    std::vector<std::string> out;
+    KAJsonTokenizer json(doc);
+    KAJsonToken tok;
+    for (;;) {
+        const bool more = json.next(tok);
+        out.push_back(std::string(names[static_cast<int>(tok.kind)]) + ":" + std::string(tok.text));
+        if (! more) break;
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("json escape") {
+    CHECK(escape("plain text") == "plain text");
+    CHECK(escape("") == "");
+    CHECK(escape("say \"hi\"\\") == "say \\\"hi\\\"\\\\");
+    CHECK(escape("a\nb\tc\r\b\f") == "a\\nb\\tc\\r\\b\\f");
+    CHECK(escape(std::string("\x01\x1f", 2)) == "\\u0001\\u001f");
+    CHECK(escape(std::string("nul\0", 4)) == "nul\\u0000");
+    // UTF-8 原样保留, '/' 不转义
+    CHECK(escape("\xe4\xb8\xad/x") == "\xe4\xb8\xad/x");
+    // 跨越 16 字节块边界
+    const std::string longer = std::string(15, 'x') + "\"" + std::string(40, 'y') + "\n";
+    CHECK(escape(longer) == std::string(15, 'x') + "\\\"" + std::string(40, 'y') + "\\n");
+
+    // 追加而不是覆盖
+    KAString out("[\"");
+    json_escape_to(out, "a\"b");
+    out.append("\"]");
+    CHECK(out == "[\"a\\\"b\"]");
+}
+
+TEST_CASE("json unescape") {
+    CHECK(unescape("plain") == "plain");
+    CHECK(unescape("a\\\"b\\\\c\\/d") == "a\"b\\c/d");
+    CHECK(unescape("\\b\\f\\n\\r\\t") == "\b\f\n\r\t");
+    CHECK(unescape("\\u0041\\u00e9\\u4E2D") == "A\xc3\xa9\xe4\xb8\xad");
+    CHECK(unescape("\\ud83d\\ude00") == "\xf0\x9f\x98\x80");
+    CHECK(unescape("\\u0000") == std::string("\0", 1));
+    // 落单的代理项替换为 U+FFFD
+    CHECK(unescape("\\ud83dx") == "\xef\xbf\xbdx");
+    CHECK(unescape("\\ude00") == "\xef\xbf\xbd");
+
+    CHECK(unescape("ab\\x", false) == "ab");
+    CHECK(unescape("ab\\", false) == "ab");
+    CHECK(unescape("\\u12", false).empty());
+    CHECK(unescape("\\u12g4", false).empty());
+
+    SUBCASE("round trip") {
+        std::mt19937 rng(47);
+        for (int iter = 0; iter < 500; ++iter) {
+            std::string s;
+            const int len = static_cast<int>(rng() % 80);
+            for (int k = 0; k < len; ++k) s.push_back(static_cast<char>(rng() % 256));
+            CHECK(unescape(escape(s)) == s);
+        }
+    }
+}
+
+TEST_CASE("json tokenizer") {
+    const char* doc = " {\"id\": 42, \"name\": \"a\\\"b\", \"tags\": [true, false, null, -1.5e3], \"o\": {}} ";
+    const std::vector<std::string> expected = {"{:{", "key:id", "num:42", "key:name", "str:a\\\"b", "key:tags", "[:[",
+                                               "true:true", "false:false", "null:null", "num:-1.5e3", "]:]", "key:o",
+                                               "{:{", "}:}", "}:}", "end:"};
+    CHECK(tokens(doc) == expected);
+
+    KAJsonTokenizer json(doc);
+    KAJsonToken tok;
+    CHECK(json.next(tok));
+    CHECK(json.depth() == 1);
+    CHECK(json.next(tok));
+    CHECK(tok.kind == JsonTokenKind::Key);
+    CHECK_FALSE(tok.escaped);
+    CHECK(json.next(tok));
+    CHECK(parse<int>(tok.text).value == 42);
+    CHECK(json.next(tok));
+    CHECK(json.next(tok));
+    CHECK(tok.kind == JsonTokenKind::String);
+    CHECK(tok.escaped);
+    KAString name;
+    CHECK(json_unescape_to(name, tok.text));
+    CHECK(name == "a\"b");
+
+    SUBCASE("scalars at top level") {
+        CHECK(tokens("\"x\"") == std::vector<std::string>{"str:x", "end:"});
+        CHECK(tokens(" 0 ") == std::vector<std::string>{"num:0", "end:"});
+        CHECK(tokens("[]") == std::vector<std::string>{"[:[", "]:]", "end:"});
+    }
+
+    SUBCASE("syntax errors") {
+        const char* bad[] = {"", "{", "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":}", "{1:2}", "[}", "01", "1.", "1e", "-",
+                             "tru", "[nul]", "\"abc", "\"a\nb\"", "{} {}", "]", "{\"a\":1,}", "[\"\\\"]"};
+        for (const char* s : bad) {
+            const std::vector<std::string> t = tokens(s);
+            CHECK(t.back() == "error:");
+        }
+        KAJsonTokenizer json2("[1, x]");
+        KAJsonToken t2;
+        while (json2.next(t2)) {
+        }
+        CHECK(json2.failed());
+        CHECK(json2.offset() == 4);
+        // 出错后保持出错状态
+        CHECK_FALSE(json2.next(t2));
+        CHECK(t2.kind == JsonTokenKind::Error);
+    }
+}
+
+TEST_CASE("json tokenizer skip and find_key") {
+    const char* doc = "{\"meta\": {\"a\": [1, {\"b\": \"}]\"}], \"c\": \"{\\\"\"}, \"list\": [[], [[]]], "
+                      "\"flag\": true, \"id\": 7}";
+    KAJsonTokenizer json(doc);
+    KAJsonToken tok;
+    REQUIRE(json.next(tok));
+    REQUIRE(json.find_key("id"));
+    REQUIRE(json.next(tok));
+    CHECK(tok.kind == JsonTokenKind::Number);
+    CHECK(tok.text == "7");
+    CHECK(json.next(tok));
+    CHECK(tok.kind == JsonTokenKind::ObjectEnd);
+    CHECK_FALSE(json.next(tok));
+    CHECK(tok.kind == JsonTokenKind::End);
+
+    SUBCASE("missing key") {
+        KAJsonTokenizer j2(doc);
+        REQUIRE(j2.next(tok));
+        CHECK_FALSE(j2.find_key("nope"));
+        CHECK_FALSE(j2.failed());
+        CHECK_FALSE(j2.next(tok));
+        CHECK(tok.kind == JsonTokenKind::End);
+    }
+
+    SUBCASE("nested lookup") {
+        KAJsonTokenizer j3(doc);
+        REQUIRE(j3.next(tok));
+        REQUIRE(j3.find_key("meta"));
+        REQUIRE(j3.next(tok));
+        REQUIRE(j3.find_key("c"));
+        REQUIRE(j3.next(tok));
+        CHECK(tok.text == "{\\\"");
+        CHECK(j3.depth() == 2);
+        CHECK(j3.find_key("zzz") == false);
+        CHECK(j3.depth() == 1);
+        REQUIRE(j3.find_key("flag"));
+        REQUIRE(j3.next(tok));
+        CHECK(tok.kind == JsonTokenKind::True);
+    }
+
+    SUBCASE("skip unterminated") {
+        KAJsonTokenizer j4("{\"a\": [1, 2");
+        REQUIRE(j4.next(tok));
+        REQUIRE(j4.next(tok));
+        CHECK_FALSE(j4.skip());
+        CHECK(j4.failed());
+    }
+}
@@ -1269,6 +1269,18 @@ TEST_CASE("KAString::fromNum(int) torture") {
         CHECK(KAString::from_num(1295, 36) == "zz");
     }
 
+    SUBCASE("fromNum enum") {
+        enum Plain { PlainSeven = 7 };
+        enum class Scoped : std::uint8_t { Big = 200 };
+        enum class Signed : long long { Neg = -42 };
+        CHECK(KAString::from_num(PlainSeven) == "7");
+        CHECK(KAString::from_num(Scoped::Big, 16) == "c8");
+        CHECK(KAString::from_num(Signed::Neg) == "-42");
+        KAString s("x=");
+        s.append_num(Scoped::Big);
+        CHECK(s == "x=200");
+    }
+
     SUBCASE("fromNum invalid base (<2)") {
         CHECK_THROWS_AS(KAString::from_num(10, 1), std::invalid_argument);
     }
@@ -1292,6 +1304,49 @@ TEST_CASE("KAString::fromNum(int) torture") {
     }
 }
 
+TEST_CASE("KAString::from_num / append_num all integer widths") {
+    SUBCASE("limits") {
+        CHECK(KAString::from_num(std::numeric_limits<std::int8_t>::min()) == "-128");
+        CHECK(KAString::from_num(std::numeric_limits<std::uint8_t>::max()) == "255");
+        CHECK(KAString::from_num(std::numeric_limits<std::int16_t>::min()) == "-32768");
+        CHECK(KAString::from_num(std::numeric_limits<std::int32_t>::min()) == "-2147483648");
+        CHECK(KAString::from_num(std::numeric_limits<std::int64_t>::min()) == "-9223372036854775808");
+        CHECK(KAString::from_num(std::numeric_limits<std::uint64_t>::max()) == "18446744073709551615");
+        CHECK(KAString::from_num(std::numeric_limits<std::uint64_t>::max(), 16) == "ffffffffffffffff");
+        CHECK(KAString::from_num(std::numeric_limits<std::int64_t>::min(), 2)
+              == "-1000000000000000000000000000000000000000000000000000000000000000");
+    }
+
+    SUBCASE("every digit count") {
+        std::uint64_t v = 1;
+        for (int digits = 1; digits <= 20; ++digits) {
+            CHECK(KAString::from_num(v) == KAString(std::to_string(v)));
+            CHECK(KAString::from_num(v - 1) == KAString(std::to_string(v - 1)));
+            if (digits < 20) v *= 10;
+        }
+    }
+
+    SUBCASE("other bases") {
+        CHECK(KAString::from_num(-255, 16) == "-ff");
+        CHECK(KAString::from_num(8, 8) == "10");
+        CHECK(KAString::from_num(0, 2) == "0");
+        CHECK(KAString::from_num(35u, 36) == "z");
+        CHECK(KAString::from_num(-1295L, 36) == "-zz");
+    }
+
+    SUBCASE("append_num in place") {
+        KAString s("x=");
+        s.append_num(42);
+        s.append(", y=");
+        s.append_num(-7LL);
+        s.append(", mask=0x");
+        s.append_num(0xBEEFu, 16);
+        CHECK(s == "x=42, y=-7, mask=0xbeef");
+        CHECK_THROWS_AS(s.append_num(1, 37), std::invalid_argument);
+        CHECK(s == "x=42, y=-7, mask=0xbeef");
+    }
+}
+
 TEST_CASE("KAString::fromNum(double) torture") {
     SUBCASE("basic float formatting") {
         CHECK(KAString::from_num(3.14159, 'f', 2) == "3.14");
@@ -1439,6 +1494,26 @@ TEST_CASE("fmt case") {
     CHECK(KAString("vec = {}").fmt(std::vector<int>{1, 2, 3}) == "vec = [1, 2, 3]");
 }
 
+TEST_CASE("KAString capacity controls") {
+    KAString s("a long string that certainly does not fit into the inline buffer");
+    CHECK(s.heap_bytes() > 0);
+    CHECK(s.footprint() == sizeof(KAString) + s.heap_bytes());
+
+    s.chop(s.byte_size() - 6);
+    CHECK(s == "a long");
+    CHECK(s.heap_bytes() > 0);
+    s.shrink_to_fit();
+    CHECK(s == "a long");
+    CHECK(s.heap_bytes() == 0);
+    CHECK(s.footprint() == sizeof(KAString));
+
+    KAString big(std::string(200, 'x'));
+    big.release();
+    CHECK(big.empty());
+    CHECK(big.heap_bytes() == 0);
+    CHECK(KAString::growth_factor() == SSOBytes::growth_factor());
+}
+
 TEST_CASE("addtional test case") {
     SUBCASE("reverse") {
         KAString s = "abc";
@@ -0,0 +1,473 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("parse integer basics") {
+    ParseResult<int> r = parse<int>("12345");
+    CHECK(r.ok());
+    CHECK(r.value == 12345);
+    CHECK(r.consumed == 5);
+
+    CHECK(parse<int>("-42").value == -42);
+    CHECK(parse<int>("+42").value == 42);
+    CHECK(parse<int>("0").value == 0);
+    CHECK(parse<long long>("-0").value == 0);
+    CHECK(parse<unsigned>("007").value == 7);
+
+    // KAString 可以直接传入, 不会复制
+    KAString owned("65535");
+    CHECK(parse<std::uint16_t>(owned).value == 65535);
+
+    SUBCASE("errors") {
+        CHECK(parse<int>("").error == ParseError::Empty);
+        CHECK(parse<int>("-").error == ParseError::InvalidChar);
+        CHECK(parse<int>("+").consumed == 1);
+        CHECK(parse<int>("abc").error == ParseError::InvalidChar);
+        CHECK(parse<int>("abc").consumed == 0);
+        CHECK(parse<int>("12a").error == ParseError::InvalidChar);
+        CHECK(parse<int>("12a").consumed == 2);
+        CHECK(parse<int>("12a").value == 0);
+        CHECK(parse<int>(" 12").error == ParseError::InvalidChar);
+        CHECK(parse<unsigned>("-1").error == ParseError::Overflow);
+        CHECK(parse<unsigned>("-1").value == 0);
+        CHECK(parse<unsigned>("-0").ok());
+        CHECK(parse<int>("1", 1).error == ParseError::InvalidBase);
+        CHECK(parse<int>("1", 37).error == ParseError::InvalidBase);
+        CHECK_FALSE(parse<int>("x"));
+    }
+}
+
+TEST_CASE("parse integer bases") {
+    CHECK(parse<int>("ff", 16).value == 255);
+    CHECK(parse<int>("FF", 16).value == 255);
+    CHECK(parse<int>("-7f", 16).value == -127);
+    CHECK(parse<int>("1010", 2).value == 10);
+    CHECK(parse<int>("777", 8).value == 511);
+    CHECK(parse<int>("zz", 36).value == 35 * 36 + 35);
+    CHECK(parse<int>("2", 2).error == ParseError::InvalidChar);
+    CHECK(parse<int>("g", 16).error == ParseError::InvalidChar);
+
+    // 所有进制往返
+    for (int base = 2; base <= 36; ++base) {
+        std::uint64_t v = 0xfedcba9876543210ull;
+        std::string s;
+        for (std::uint64_t t = v; t != 0; t /= static_cast<std::uint64_t>(base)) {
+            s.insert(s.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[t % static_cast<std::uint64_t>(base)]);
+        }
+        ParseResult<std::uint64_t> r = parse<std::uint64_t>(KAStr(s.c_str()), base);
+        CHECK(r.ok());
+        CHECK(r.value == v);
+        CHECK(r.consumed == s.size());
+    }
+}
+
+TEST_CASE("parse integer modes") {
+    SUBCASE("strict") {
+        CHECK(parse<int>("0x1f", 16).error == ParseError::InvalidChar);
+        CHECK(parse<int>("0x1f", 16).consumed == 1);
+        CHECK(parse<int>("42 ").error == ParseError::InvalidChar);
+    }
+
+    SUBCASE("lenient") {
+        ParseResult<int> r = parse<int>(" \t\n42 apples", ParseMode::Lenient);
+        CHECK(r.ok());
+        CHECK(r.value == 42);
+        CHECK(r.consumed == 5);
+
+        CHECK(parse<int>("0x1f", 16, ParseMode::Lenient).value == 31);
+        CHECK(parse<int>("-0X1F", 16, ParseMode::Lenient).value == -31);
+        CHECK(parse<int>("0b101", 2, ParseMode::Lenient).value == 5);
+        // 前缀后没有数字时只读取 0
+        r = parse<int>("0xg", 16, ParseMode::Lenient);
+        CHECK(r.value == 0);
+        CHECK(r.consumed == 1);
+        // 0x 在 10 进制下不是前缀
+        CHECK(parse<int>("0x1f", ParseMode::Lenient).consumed == 1);
+
+        CHECK(parse<int>("   ", ParseMode::Lenient).error == ParseError::Empty);
+        CHECK(parse<int>("  -x", ParseMode::Lenient).error == ParseError::InvalidChar);
+        CHECK(parse<int>("  -x", ParseMode::Lenient).consumed == 3);
+    }
+}
+
+TEST_CASE("parse integer overflow") {
+    CHECK(parse<std::int8_t>("127").value == 127);
+    CHECK(parse<std::int8_t>("-128").value == -128);
+    CHECK(parse<std::int8_t>("128").error == ParseError::Overflow);
+    CHECK(parse<std::int8_t>("-129").error == ParseError::Overflow);
+    CHECK(parse<std::uint8_t>("255").value == 255);
+    CHECK(parse<std::uint8_t>("256").error == ParseError::Overflow);
+    CHECK(parse<std::uint8_t>("256").value == 255);
+    CHECK(parse<std::int16_t>("-32768").value == -32768);
+    CHECK(parse<std::int16_t>("32768").error == ParseError::Overflow);
+    CHECK(parse<std::int32_t>("-2147483648").value == std::numeric_limits<std::int32_t>::min());
+    CHECK(parse<std::int32_t>("2147483648").error == ParseError::Overflow);
+    CHECK(parse<std::uint32_t>("4294967295").value == 4294967295u);
+    CHECK(parse<std::uint32_t>("4294967296").error == ParseError::Overflow);
+
+    ParseResult<std::int64_t> r = parse<std::int64_t>("-9223372036854775808");
+    CHECK(r.ok());
+    CHECK(r.value == std::numeric_limits<std::int64_t>::min());
+    CHECK(parse<std::int64_t>("9223372036854775807").value == std::numeric_limits<std::int64_t>::max());
+
+    r = parse<std::int64_t>("9223372036854775808");
+    CHECK(r.error == ParseError::Overflow);
+    CHECK(r.value == std::numeric_limits<std::int64_t>::max());
+    CHECK(r.consumed == 19);
+    r = parse<std::int64_t>("-99999999999999999999999");
+    CHECK(r.error == ParseError::Overflow);
+    CHECK(r.value == std::numeric_limits<std::int64_t>::min());
+
+    CHECK(parse<std::uint64_t>("18446744073709551615").value == std::numeric_limits<std::uint64_t>::max());
+    CHECK(parse<std::uint64_t>("18446744073709551616").error == ParseError::Overflow);
+    CHECK(parse<std::uint64_t>("ffffffffffffffff", 16).ok());
+    CHECK(parse<std::uint64_t>("10000000000000000", 16).error == ParseError::Overflow);
+
+    // 溢出后的多余字符在宽松模式下不影响 consumed, 严格模式下仍报 InvalidChar
+    ParseResult<std::uint8_t> u = parse<std::uint8_t>("1000kg", ParseMode::Lenient);
+    CHECK(u.error == ParseError::Overflow);
+    CHECK(u.consumed == 4);
+    CHECK(parse<std::uint8_t>("1000kg").error == ParseError::InvalidChar);
+}
+
+TEST_CASE("parse decimal fast path") {
+    // 覆盖 SSE2 16 位、SWAR 8 位与标量尾部的所有分界
+    for (std::size_t len = 1; len <= 40; ++len) {
+        std::string digits;
+        for (std::size_t i = 0; i < len; ++i) digits.push_back(static_cast<char>('1' + i % 9));
+        for (std::size_t stop = 1; stop <= len; ++stop) {
+            std::string s = digits;
+            if (stop < len) s[stop] = (stop % 2) ? ',' : static_cast<char>(0xb0);
+            ParseResult<std::uint64_t> r = parse<std::uint64_t>(KAStr(s.c_str()), ParseMode::Lenient);
+            const std::string head = s.substr(0, stop);
+            errno = 0;
+            const unsigned long long expect = std::strtoull(head.c_str(), nullptr, 10);
+            CHECK(r.consumed == stop);
+            CHECK((r.error == ParseError::Overflow) == (errno == ERANGE));
+            CHECK(r.value == expect);
+        }
+    }
+
+    // 前导 0 超过 19 位时仍然正确
+    CHECK(parse<std::uint64_t>("000000000000000000000000018446744073709551615").value
+          == std::numeric_limits<std::uint64_t>::max());
+    CHECK(parse<std::int8_t>("0000000000000000000000000127").value == 127);
+    CHECK(parse<std::int8_t>("0000000000000000000000000128").error == ParseError::Overflow);
+    // 19 位的值超过窄类型的上限
+    CHECK(parse<std::int32_t>("1234567890123456789").error == ParseError::Overflow);
+    CHECK(parse<std::uint64_t>("99999999999999999999").error == ParseError::Overflow);
+
+    // KAStr::to_* 使用同一个实现, 不再先复制成 std::string
+    CHECK(KAStr("  1234567890123456789xyz").to_longlong() == 1234567890123456789ll);
+    CHECK(KAStr("1234567890123456789").subrange(0, 5).to_int() == 12345);
+    // 与 std::stoul / std::stoull 一样: 负数对 unsigned long(long) 取模, 更窄的无符号类型报告越界
+    CHECK(KAStr("-1").to_ulong() == std::numeric_limits<unsigned long>::max());
+    CHECK(KAStr("-1").to_ulonglong() == std::numeric_limits<unsigned long long>::max());
+    CHECK(KAStr(" -0x10").to_ulonglong(16) == std::numeric_limits<unsigned long long>::max() - 15);
+    CHECK(KAStr("-18446744073709551615").to_ulonglong() == 1);
+    CHECK_THROWS_AS(KAStr("-18446744073709551616").to_ulonglong(), std::out_of_range);
+    CHECK_THROWS_AS(KAStr("-1").to_uint(), std::out_of_range);
+    CHECK(KAStr("-0").to_uint() == 0);
+    // to_* 不认 0b 前缀, 与 strtol 一样读到 'b' 停止; parse<T> 的宽松模式才接受
+    CHECK(KAStr("0b101").to_int(2) == 0);
+    CHECK(KAStr("101").to_int(2) == 5);
+}
+
+TEST_CASE("parse integer matches strtoll") {
+    std::mt19937_64 rng(20240601);
+    const char alphabet[] = "0123456789abcdefxyzABCDEFXYZ+- \t";
+    for (int iter = 0; iter < 20000; ++iter) {
+        // 旧版 glibc 的 strtoll 不认识 C23 的 0b 前缀, 2 进制只在上面单独测试
+        const int base = 3 + static_cast<int>(rng() % 34);
+        std::string s;
+        const std::size_t len = static_cast<std::size_t>(rng() % 24);
+        for (std::size_t i = 0; i < len; ++i) {
+            s.push_back(alphabet[rng() % (sizeof(alphabet) - 1)]);
+        }
+
+        ParseResult<long long> r = parse<long long>(KAStr(s.c_str()), base, ParseMode::Lenient);
+        char* end = nullptr;
+        errno = 0;
+        const long long expect = std::strtoll(s.c_str(), &end, base);
+        const std::size_t expect_consumed = static_cast<std::size_t>(end - s.c_str());
+        if (expect_consumed == 0) {
+            // strtoll 失败时不推进指针, parse 会报告出错位置
+            CHECK_FALSE(r.ok());
+            continue;
+        }
+        CHECK(r.value == expect);
+        CHECK(r.consumed == expect_consumed);
+        CHECK((r.error == ParseError::Overflow) == (errno == ERANGE));
+
+        // to_ulonglong 与 std::stoull 的结果和异常一致
+        unsigned long long got = 0;
+        int got_err = 0;
+        try {
+            got = KAStr(s.c_str()).to_ulonglong(base);
+        } catch (const std::out_of_range&) {
+            got_err = 1;
+        } catch (const std::invalid_argument&) {
+            got_err = 2;
+        }
+        unsigned long long want = 0;
+        int want_err = 0;
+        try {
+            want = std::stoull(s, nullptr, base);
+        } catch (const std::out_of_range&) {
+            want_err = 1;
+        } catch (const std::invalid_argument&) {
+            want_err = 2;
+        }
+        CHECK(got_err == want_err);
+        CHECK(got == want);
+    }
+}
+
+TEST_CASE("parse float syntax") {
+    ParseResult<double> r = parse<double>("3.25");
+    CHECK(r.ok());
+    CHECK(r.value == 3.25);
+    CHECK(r.consumed == 4);
+
+    CHECK(parse<double>("-0.5").value == -0.5);
+    CHECK(parse<double>("+.5").value == 0.5);
+    CHECK(parse<double>("5.").value == 5.0);
+    CHECK(parse<double>("1e3").value == 1000.0);
+    CHECK(parse<double>("1E+3").value == 1000.0);
+    CHECK(parse<double>("25e-2").value == 0.25);
+    CHECK(parse<float>("0.1").value == 0.1f);
+    CHECK(std::signbit(parse<double>("-0").value));
+    CHECK(parse<double>("0e999999").value == 0.0);
+    CHECK(parse<double>("0e999999").ok());
+
+    SUBCASE("inf and nan") {
+        CHECK(std::isinf(parse<double>("inf").value));
+        CHECK(std::isinf(parse<double>("-Infinity").value));
+        CHECK(parse<double>("-Infinity").value < 0);
+        CHECK(std::isnan(parse<double>("nan").value));
+        CHECK(std::isnan(parse<float>("NaN(0x1f)").value));
+        CHECK(parse<double>("NaN(0x1f)").consumed == 9);
+        CHECK(parse<double>("nan(", ParseMode::Lenient).consumed == 3);
+        CHECK(parse<double>("infinit", ParseMode::Lenient).consumed == 3);
+        CHECK(parse<double>("infinit").error == ParseError::InvalidChar);
+    }
+
+    SUBCASE("errors") {
+        CHECK(parse<double>("").error == ParseError::Empty);
+        CHECK(parse<double>(".").error == ParseError::InvalidChar);
+        CHECK(parse<double>("-").error == ParseError::InvalidChar);
+        CHECK(parse<double>("e5").error == ParseError::InvalidChar);
+        CHECK(parse<double>("1.2.3").error == ParseError::InvalidChar);
+        CHECK(parse<double>("1.2.3").consumed == 3);
+        CHECK(parse<double>(" 1").error == ParseError::InvalidChar);
+        // 指数部分没有数字时不属于这个数
+        CHECK(parse<double>("1e").error == ParseError::InvalidChar);
+        r = parse<double>("1e+x", ParseMode::Lenient);
+        CHECK(r.value == 1.0);
+        CHECK(r.consumed == 1);
+        r = parse<double>("\t -2.5e1kg", ParseMode::Lenient);
+        CHECK(r.value == -25.0);
+        CHECK(r.consumed == 8);
+    }
+
+    SUBCASE("out of range") {
+        r = parse<double>("1e400");
+        CHECK(r.error == ParseError::Overflow);
+        CHECK(std::isinf(r.value));
+        r = parse<double>("-1e-400");
+        CHECK(r.error == ParseError::Overflow);
+        CHECK(r.value == 0.0);
+        CHECK(std::signbit(r.value));
+        CHECK(parse<float>("3.5e38").error == ParseError::Overflow);
+        CHECK(parse<float>("3.4e38").ok());
+        CHECK(parse<double>("4.9406564584124654e-324").value == std::numeric_limits<double>::denorm_min());
+        CHECK(parse<double>("2.4703282292062328e-324").value == std::numeric_limits<double>::denorm_min());
+        CHECK(parse<double>("2.4703282292062327e-324").error == ParseError::Overflow);
+        CHECK(parse<double>("1.7976931348623157e308").value == std::numeric_limits<double>::max());
+        CHECK(parse<double>("1.7976931348623159e308").error == ParseError::Overflow);
+    }
+}
+
+TEST_CASE("parse float rounding") {
+    // 1 与下一个 double 的正中间: 恰好一半取偶, 多一点点就进位
+    CHECK(parse<double>("1.00000000000000011102230246251565404236316680908203125").value == 1.0);
+    CHECK(parse<double>("1.00000000000000011102230246251565404236316680908203126").value
+          == std::nextafter(1.0, 2.0));
+    CHECK(parse<double>("1.000000000000000111022302462515654042363166809082031250000000000000000000001").value
+          == std::nextafter(1.0, 2.0));
+    // 超过 19 位有效数字
+    CHECK(parse<double>("3.14159265358979323846264338327950288").value == 3.141592653589793);
+    CHECK(parse<double>("00000000000000000000000000000000000012.5").value == 12.5);
+    CHECK(parse<double>("0.000000000000000000000000000000000000000000001").value == 1e-45);
+    CHECK(parse<float>("7.038531e-26").value == 7.038531e-26f);
+    CHECK(parse<float>("1.4e-45").value == std::numeric_limits<float>::denorm_min());
+
+    // 与 strtod / strtof 比较: 随机位模式的最短表示、17 位表示和较短的近似值
+    std::mt19937_64 rng(20240602);
+    char buf[64];
+    for (int iter = 0; iter < 20000; ++iter) {
+        const std::uint64_t bits = rng();
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        if (std::isnan(d)) continue;
+        std::snprintf(buf, sizeof(buf), "%.*g", 1 + static_cast<int>(rng() % 17), d);
+        ParseResult<double> rd = parse<double>(buf);
+        const double expect_d = std::strtod(buf, nullptr);
+        CHECK(std::memcmp(&rd.value, &expect_d, sizeof(double)) == 0);
+
+        ParseResult<float> rf = parse<float>(buf);
+        const float expect_f = std::strtof(buf, nullptr);
+        CHECK(std::memcmp(&rf.value, &expect_f, sizeof(float)) == 0);
+    }
+}
+
+TEST_CASE("KAStr::to_double uses parse") {
+    CHECK(KAStr("  1.5e3 apples").to_double() == 1500.0);
+    CHECK(KAStr("2.5").to_float() == 2.5f);
+    // 非 '\0' 结尾的切片也只读取自己的字节
+    CHECK(KAStr("12.5e3").subrange(0, 4).to_double() == 12.5);
+    CHECK_THROWS_AS(KAStr("abc").to_double(), std::invalid_argument);
+    CHECK_THROWS_AS(KAStr("1e-999").to_double(), std::out_of_range);
+    CHECK_THROWS_AS(KAStr("1e39").to_float(), std::out_of_range);
+}
+
+TEST_CASE("ByteSet") {
+    ByteSet s(",;\t");
+    CHECK(s.contains(','));
+    CHECK(s.contains('\t'));
+    CHECK_FALSE(s.contains('a'));
+    CHECK_FALSE(ByteSet().contains(0));
+    CHECK(ByteSet().empty());
+    ByteSet high;
+    high.add(0xff).add(0x80);
+    CHECK(high.contains(0xff));
+    CHECK_FALSE(high.contains(0x7f));
+    CHECK((s | ByteSet('\n')).contains('\n'));
+}
+
+TEST_CASE("parse_column") {
+    std::vector<long> v;
+    ColumnParseResult r = parse_column(KAStr("1,-2\n30,4000000000"), ",\n", v);
+    CHECK(r.ok());
+    CHECK(r.rows == 4);
+    CHECK(v == std::vector<long>({1, -2, 30, 4000000000l}));
+
+    SUBCASE("appends and ignores trailing delimiter") {
+        r = parse_column(KAStr("5;6;"), ';', v);
+        CHECK(r.rows == 2);
+        CHECK(v.size() == 6);
+        CHECK(v[5] == 6);
+    }
+
+    SUBCASE("malformed fields") {
+        std::vector<int> out;
+        r = parse_column(KAStr("1,,x3,99999999999,4 ,5"), ",", out);
+        CHECK(r.rows == 6);
+        CHECK(out == std::vector<int>({1, 0, 0, 0, 0, 5}));
+        REQUIRE(r.errors.size() == 4);
+        CHECK(r.errors[0].row == 1);
+        CHECK(r.errors[0].offset == 2);
+        CHECK(r.errors[0].error == ParseError::Empty);
+        CHECK(r.errors[1].row == 2);
+        CHECK(r.errors[1].offset == 3);
+        CHECK(r.errors[1].error == ParseError::InvalidChar);
+        CHECK(r.errors[2].error == ParseError::Overflow);
+        CHECK(r.errors[3].row == 4);
+        CHECK(r.errors[3].error == ParseError::InvalidChar);
+
+        out.clear();
+        r = parse_column(KAStr(" 1 , 2\t,3"), ",", out, ParseMode::Lenient);
+        CHECK(r.ok());
+        CHECK(out == std::vector<int>({1, 2, 3}));
+    }
+
+    SUBCASE("whitespace delimiters are never skipped as padding") {
+        std::vector<int> out;
+        r = parse_column(KAStr("1\t\t2"), '\t', out, ParseMode::Lenient);
+        CHECK(out == std::vector<int>({1, 0, 2}));
+        REQUIRE(r.errors.size() == 1);
+        CHECK(r.errors[0].error == ParseError::Empty);
+    }
+
+    SUBCASE("floats") {
+        std::vector<double> d;
+        r = parse_column(KAStr("1.5|2e3|-0.25|nan"), '|', d);
+        CHECK(r.ok());
+        CHECK(d[1] == 2000.0);
+        CHECK(d[2] == -0.25);
+        CHECK(std::isnan(d[3]));
+    }
+}
+
+TEST_CASE("parse_columns") {
+    std::vector<std::uint32_t> ids;
+    std::vector<double> prices;
+    std::vector<std::int8_t> flags;
+    ColumnParseResult r = parse_columns(KAStr("1,9.5,0\r\n2,10.25,1\r\n\r\n3,0.5,-1\r\n"), ",", "\r\n", ids, prices,
+                                        flags);
+    CHECK(r.ok());
+    CHECK(r.rows == 3);
+    CHECK(ids == std::vector<std::uint32_t>({1, 2, 3}));
+    CHECK(prices == std::vector<double>({9.5, 10.25, 0.5}));
+    CHECK(flags == std::vector<std::int8_t>({0, 1, -1}));
+
+    SUBCASE("short, long and malformed rows keep columns aligned") {
+        std::vector<int> a;
+        std::vector<int> b;
+        const KAStr text("1,2\n3\n4,5,6\n7,x\n8,9");
+        r = parse_columns(text, ",", "\n", a, b);
+        CHECK(r.rows == 5);
+        CHECK(a == std::vector<int>({1, 3, 4, 7, 8}));
+        CHECK(b == std::vector<int>({2, 0, 5, 0, 9}));
+        REQUIRE(r.errors.size() == 3);
+        CHECK(r.errors[0].row == 1);
+        CHECK(r.errors[0].column == 1);
+        CHECK(r.errors[0].error == ParseError::Empty);
+        CHECK(r.errors[1].row == 2);
+        CHECK(r.errors[1].column == 2);
+        CHECK(r.errors[1].offset == 10);
+        CHECK(r.errors[1].error == ParseError::InvalidChar);
+        CHECK(r.errors[2].row == 3);
+        CHECK(r.errors[2].column == 1);
+        CHECK(r.errors[2].offset == 14);
+    }
+
+    SUBCASE("lenient mode") {
+        std::vector<int> a;
+        std::vector<float> b;
+        r = parse_columns(KAStr(" 1 ; 2.5 \n 3;4"), ";", "\n", ParseMode::Lenient, a, b);
+        CHECK(r.ok());
+        CHECK(a == std::vector<int>({1, 3}));
+        CHECK(b == std::vector<float>({2.5f, 4.0f}));
+    }
+
+    SUBCASE("matches split + to_long") {
+        std::mt19937_64 rng(44);
+        std::string text;
+        for (int i = 0; i < 2000; ++i) {
+            text += std::to_string(static_cast<long>(rng() % 2000000) - 1000000);
+            text += (i % 4 == 3) ? "\n" : ",";
+        }
+        std::vector<long> fused;
+        r = parse_column(KAStr(text.c_str()), ",\n", fused);
+        CHECK(r.ok());
+        std::vector<long> slow;
+        for (const KAStr& line : KAStr(text.c_str()).split("\n")) {
+            if (line.empty()) continue;
+            for (const KAStr& f : line.split(",")) slow.push_back(f.to_long());
+        }
+        CHECK(fused == slow);
+    }
+}
@@ -0,0 +1,111 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("query parser iteration") {
+    const char* text = "a=1&b=two&c=%20x&flag&empty=&&=v";
+    std::vector<KAQueryPair> pairs;
+    for (const KAQueryPair& kv : KAQueryParser(text)) pairs.push_back(kv);
+    REQUIRE(pairs.size() == 6);
+    CHECK(pairs[0].key == "a");
+    CHECK(pairs[0].value == "1");
+    CHECK(pairs[1].value == "two");
+    CHECK(pairs[2].value == "%20x");
+    CHECK(pairs[3].key == "flag");
+    CHECK_FALSE(pairs[3].has_value);
+    CHECK(pairs[4].key == "empty");
+    CHECK(pairs[4].has_value);
+    CHECK(pairs[4].value.empty());
+    CHECK(pairs[5].key.empty());
+    CHECK(pairs[5].value == "v");
+    // 视图指向原文本
+    CHECK(pairs[1].value.data() == reinterpret_cast<const Byte*>(text) + 6);
+
+    SUBCASE("empty input") {
+        KAQueryParser q("");
+        CHECK(q.begin() == q.end());
+        KAQueryParser seps("&&&");
+        CHECK(seps.begin() == seps.end());
+    }
+
+    SUBCASE("custom separators") {
+        KAQueryParser q("k1:v1; k2:v2,k3", "; ,", ':');
+        std::vector<std::string> keys, values;
+        for (KAQueryParser::const_iterator it = q.begin(); it != q.end(); ++it) {
+            keys.push_back(it->key);
+            values.push_back(it->value);
+        }
+        CHECK(keys == std::vector<std::string>{"k1", "k2", "k3"});
+        CHECK(values == std::vector<std::string>{"v1", "v2", ""});
+    }
+
+    SUBCASE("value containing key separator") {
+        KAQueryParser q("expr=a=b&x=1");
+        CHECK(q.begin()->key == "expr");
+        CHECK(q.begin()->value == "a=b");
+    }
+}
+
+TEST_CASE("query parser lookup") {
+    KAQueryParser q("ab=1&a=2&flag&a=3&x=");
+    KAStr v;
+    CHECK(q.lookup("a", v));
+    CHECK(v == "2");
+    CHECK(q.lookup("ab") == "1");
+    CHECK(q.lookup("flag", v));
+    CHECK(v.empty());
+    CHECK(q.lookup("x", v));
+    CHECK(v.empty());
+    CHECK_FALSE(q.lookup("b", v));
+    CHECK_FALSE(q.lookup("fla", v));
+    CHECK_FALSE(q.lookup("", v));
+    CHECK(q.lookup("missing").empty());
+
+    KAQueryParser empty_key("=v&k=1");
+    CHECK(empty_key.lookup("", v));
+    CHECK(v == "v");
+}
+
+TEST_CASE("query decode") {
+    KAString out;
+    CHECK(KAQueryParser::decode("a%20b+c%2Bd", out));
+    CHECK(out == "a b c+d");
+
+    out = KAString();
+    CHECK(KAQueryParser::decode("a+b", out, false));
+    CHECK(out == "a+b");
+
+    // 不合法的转义原样保留
+    out = KAString();
+    CHECK_FALSE(KAQueryParser::decode("100%", out));
+    CHECK(out == "100%");
+    out = KAString();
+    CHECK_FALSE(KAQueryParser::decode("%zz%4", out));
+    CHECK(out == "%zz%4");
+    out = KAString();
+    CHECK(KAQueryParser::decode("%e4%B8%ad", out));
+    CHECK(out == "\xe4\xb8\xad");
+
+    CHECK_FALSE(KAQueryParser::needs_decode("plain"));
+    CHECK(KAQueryParser::needs_decode("a+b"));
+    CHECK_FALSE(KAQueryParser::needs_decode("a+b", false));
+
+    // 调用方提供的缓冲区
+    char buf[16];
+    bool ok = false;
+    const std::size_t n = KAQueryParser::decode_to("x%3Dy", buf, ok);
+    CHECK(ok);
+    CHECK(std::string(buf, n) == "x=y");
+
+    // 长值走堆缓冲区
+    std::string big;
+    for (int i = 0; i < 200; ++i) big += "%41+";
+    out = KAString();
+    CHECK(KAQueryParser::decode(KAStr(big.c_str()), out));
+    CHECK(out.byte_size() == 400);
+}
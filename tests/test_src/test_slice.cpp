@@ -0,0 +1,153 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <unordered_set>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("KASlice basic construction") {
+    SUBCASE("default is empty") {
+        KASlice s;
+        CHECK(s.empty());
+        CHECK(s.byte_size() == 0);
+        CHECK(s.parent_size() == 0);
+        CHECK(s == "");
+        CHECK(s.is_compact());
+    }
+
+    SUBCASE("take over KAString") {
+        KAString str("hello world, this string lives on the heap");
+        KASlice s(std::move(str));
+        CHECK(s == "hello world, this string lives on the heap");
+        CHECK(s.byte_size() == s.parent_size());
+        CHECK(s.use_count() == 1);
+    }
+
+    SUBCASE("from KAStr and c-string") {
+        KASlice a(KAStr("abc"));
+        KASlice b("abc");
+        CHECK(a == b);
+        CHECK(a.as_kastr() == "abc");
+        CHECK(std::string(a) == "abc");
+    }
+}
+
+TEST_CASE("KASlice substr shares parent buffer") {
+    KASlice line("2024-01-01 INFO service=api latency=12ms status=200 path=/v1/users");
+
+    SUBCASE("substr is O(1) and shares") {
+        KASlice level = line.substr(11, 4);
+        CHECK(level == "INFO");
+        CHECK(level.data() == line.data() + 11);
+        CHECK(line.use_count() == 2);
+        CHECK(level.parent_size() == line.byte_size());
+        CHECK_FALSE(level.is_compact());
+    }
+
+    SUBCASE("substr clamps like KAStr") {
+        CHECK(line.substr(1000, 3).empty());
+        CHECK(line.substr(line.byte_size() - 3, 100) == "ers");
+        CHECK(line.substr(line.byte_size() - 6) == "/users");
+        CHECK(line.subrange(0, 10) == "2024-01-01");
+        CHECK(line.subrange(5, 5).empty());
+        CHECK(line.subrange(line.byte_size() - 3) == "ers");
+    }
+
+    SUBCASE("nested slices") {
+        KASlice tail = line.substr(16);
+        KASlice svc = tail.substr(0, 11);
+        CHECK(svc == "service=api");
+        CHECK(svc.substr(8) == "api");
+        CHECK(line.use_count() == 3);
+    }
+
+    SUBCASE("slices outlive the original owner") {
+        KASlice status;
+        {
+            KASlice tmp("status=200 path=/v1/users, padding to keep the parent on heap");
+            status = tmp.substr(7, 3);
+        }
+        CHECK(status == "200");
+        CHECK(status.use_count() == 1);
+    }
+
+    SUBCASE("empty slice drops the parent") {
+        KASlice e = line.substr(3, 0);
+        CHECK(e.empty());
+        CHECK(e.parent_size() == 0);
+        CHECK(line.use_count() == 1);
+    }
+}
+
+TEST_CASE("KASlice::slice_of promotes views") {
+    KASlice line("a=1,bb=22,ccc=333");
+
+    SUBCASE("split fields keep sharing") {
+        std::vector<KASlice> fields;
+        for (KAStr f : line.as_kastr().split(",")) fields.push_back(line.slice_of(f));
+        REQUIRE(fields.size() == 3);
+        CHECK(fields[0] == "a=1");
+        CHECK(fields[1] == "bb=22");
+        CHECK(fields[2] == "ccc=333");
+        CHECK(line.use_count() == 4);
+        CHECK(fields[2].slice_of(fields[2].as_kastr().substr_from("=")) == "333");
+    }
+
+    SUBCASE("foreign view throws") {
+        KAStr other("a=1");
+        CHECK_THROWS_AS(line.slice_of(other), std::out_of_range);
+        KASlice part = line.substr(0, 3);
+        CHECK_THROWS_AS(part.slice_of(line.as_kastr().substr(2, 3)), std::out_of_range);
+        CHECK(part.slice_of(KAStr()).empty());
+    }
+}
+
+TEST_CASE("KASlice::compact releases the parent") {
+    KAString big("x");
+    big = big.repeated(4096);
+    big.replace(100, 5, "hello");
+    KASlice parent(std::move(big));
+    KASlice small = parent.substr(100, 5);
+
+    CHECK(parent.use_count() == 2);
+    small.compact();
+    CHECK(small == "hello");
+    CHECK(small.is_compact());
+    CHECK(small.parent_size() == 5);
+    CHECK(parent.use_count() == 1);
+
+    // 已经紧凑时不再拷贝
+    const Byte* before = small.data();
+    small.compact();
+    CHECK(small.data() == before);
+
+    KAString owned = small.own();
+    CHECK(owned == "hello");
+}
+
+TEST_CASE("KASlice compare, hash and stream") {
+    KASlice a("apple,banana");
+    KASlice apple = a.substr(0, 5);
+    KASlice banana = a.substr(6);
+
+    CHECK(apple < banana);
+    CHECK(apple != banana);
+    CHECK(apple == KASlice("apple"));
+    CHECK(apple != KAStr("apples"));
+    CHECK(apple[4] == 'e');
+    CHECK_THROWS_AS(apple[5], std::out_of_range);
+
+    std::unordered_set<KASlice> set;
+    set.insert(apple);
+    set.insert(KASlice("apple"));
+    CHECK(set.size() == 1);
+
+    std::ostringstream oss;
+    oss << banana;
+    CHECK(oss.str() == "banana");
+
+    KASlice x = apple, y = banana;
+    swap(x, y);
+    CHECK(x == "banana");
+    CHECK(y == "apple");
+}
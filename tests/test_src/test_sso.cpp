@@ -239,6 +239,24 @@ TEST_CASE("append(Byte*, len) triggers heap promotion") {
     CHECK(std::memcmp(s.data(), str, s.size()) == 0);
 }
 
+TEST_CASE("append from itself in heap mode") {
+    // 扩容会释放源缓冲区, 必须在扩容后重新取源地址
+    SSOBytes s;
+    const char* str = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN"; // 40 字节
+    s.append(reinterpret_cast<const Byte*>(str), 40);
+    s.shrink_to_fit();
+    REQUIRE(! s.is_sso());
+    s.append(s.data(), s.size());
+    CHECK(s.size() == 80);
+    CHECK(std::memcmp(s.data(), str, 40) == 0);
+    CHECK(std::memcmp(s.data() + 40, str, 40) == 0);
+
+    // 只追加自身的一部分
+    s.append(s.data() + 10, 5);
+    CHECK(s.size() == 85);
+    CHECK(std::memcmp(s.data() + 80, "klmno", 5) == 0);
+}
+
 TEST_CASE("append(const char*)") {
     SSOBytes s;
     s.append("abc");
@@ -340,6 +358,25 @@ TEST_CASE("insert(pos, It, It) into heap") {
     CHECK(s.size() == SSOBytes::SSO_CAPACITY + 3);
 }
 
+TEST_CASE("insert(pos, It, It) from itself") {
+    SSOBytes s;
+    const char* str = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMN";
+    s.append(reinterpret_cast<const Byte*>(str), 40);
+    s.shrink_to_fit();
+    REQUIRE(! s.is_sso());
+    // 插入位置在源区间之前, 挪动和扩容都会影响源区间
+    s.insert(1, s.begin(), s.end());
+    CHECK(s.size() == 80);
+    CHECK(s[0] == 'a');
+    CHECK(std::memcmp(s.data() + 1, str, 40) == 0);
+    CHECK(std::memcmp(s.data() + 41, str + 1, 39) == 0);
+
+    SSOBytes small("abc");
+    REQUIRE(small.is_sso());
+    small.insert(0, small.begin() + 1, small.end());
+    CHECK(small == SSOBytes("bcabc"));
+}
+
 TEST_CASE("insert(pos, It, It) invalid") {
     SSOBytes s;
     const char* data = "hi";
@@ -524,3 +561,146 @@ TEST_CASE("iterator correctness") {
     }
     CHECK(iter == ref);
 }
+
+TEST_CASE("shrink_to_fit demotes back to SSO when contents fit") {
+    SSOBytes s;
+    for (int i = 0; i < 200; ++i) s.push_back(static_cast<Byte>('a' + i % 26));
+    CHECK(! s.is_sso());
+    s.resize(10);
+    CHECK(! s.is_sso());
+    s.shrink_to_fit();
+    CHECK(s.is_sso());
+    CHECK(s.size() == 10);
+    CHECK(std::string(s.begin(), s.end()) == "abcdefghij");
+    CHECK(s.heap_bytes() == 0);
+
+    // 正好等于 SSO_CAPACITY 也能放回
+    SSOBytes t(std::string(100, 'z'));
+    t.resize(SSOBytes::SSO_CAPACITY);
+    t.shrink_to_fit();
+    CHECK(t.is_sso());
+    CHECK(t.size() == SSOBytes::SSO_CAPACITY);
+    CHECK(t.back() == 'z');
+
+    // 清空后收缩
+    SSOBytes u(std::string(100, 'q'));
+    u.clear();
+    CHECK(! u.is_sso());
+    u.shrink_to_fit();
+    CHECK(u.is_sso());
+    CHECK(u.empty());
+}
+
+TEST_CASE("release() drops all capacity") {
+    SSOBytes s(std::string(100, 'x'));
+    CHECK(s.heap_bytes() >= 100);
+    s.release();
+    CHECK(s.is_sso());
+    CHECK(s.empty());
+    CHECK(s.heap_bytes() == 0);
+    s.append("again");
+    CHECK(std::string(s.begin(), s.end()) == "again");
+
+    SSOBytes small("abc");
+    small.release();
+    CHECK(small.empty());
+    CHECK(small.is_sso());
+}
+
+TEST_CASE("heap_bytes() and footprint()") {
+    SSOBytes s("short");
+    CHECK(s.heap_bytes() == 0);
+    CHECK(s.footprint() == sizeof(SSOBytes));
+
+    s.reserve(1000);
+    CHECK(s.heap_bytes() == s.capacity());
+    CHECK(s.heap_bytes() >= 1000);
+    CHECK(s.footprint() == sizeof(SSOBytes) + s.heap_bytes());
+}
+
+TEST_CASE("growth factor controls heap growth") {
+    const double old = SSOBytes::growth_factor();
+    CHECK(old == 2.0);
+    CHECK_THROWS_AS(SSOBytes::set_growth_factor(1.0), std::invalid_argument);
+    CHECK_THROWS_AS(SSOBytes::set_growth_factor(0.5), std::invalid_argument);
+
+    SSOBytes::set_growth_factor(1.5);
+    SSOBytes s;
+    s.reserve(100);
+    CHECK(s.capacity() == 100);
+    s.resize(100, 'a');
+    s.push_back('b');
+    CHECK(s.capacity() == 150);
+    s.append(std::string(60, 'c'));
+    CHECK(s.capacity() == 225);
+    // 单次追加超过倍数时按需分配
+    s.append(std::string(1000, 'd'));
+    CHECK(s.capacity() == s.size());
+
+    SSOBytes::set_growth_factor(old);
+    CHECK(SSOBytes::growth_factor() == old);
+}
+
+TEST_CASE("promotion allocates once with room to grow") {
+    SUBCASE("append") {
+        SSOBytes s("0123456789");
+        s.append(std::string(20, 'x'));
+        CHECK(! s.is_sso());
+        CHECK(s.size() == 30);
+        CHECK(s.capacity() >= 2 * SSOBytes::SSO_CAPACITY);
+        CHECK(std::string(s.begin(), s.end()) == "0123456789" + std::string(20, 'x'));
+
+        // 大块追加按最终长度分配
+        SSOBytes big("abc");
+        big.append(std::string(500, 'y'));
+        CHECK(big.capacity() == 503);
+    }
+
+    SUBCASE("append from own inline buffer") {
+        SSOBytes s("abcdefghijklmnop");
+        s.append(s.data(), s.size());
+        CHECK(std::string(s.begin(), s.end()) == "abcdefghijklmnopabcdefghijklmnop");
+    }
+
+    SUBCASE("push_back") {
+        SSOBytes s(std::string(SSOBytes::SSO_CAPACITY, 'a'));
+        s.push_back('b');
+        CHECK(s.capacity() >= 2 * SSOBytes::SSO_CAPACITY);
+        CHECK(s.back() == 'b');
+        CHECK(s.front() == 'a');
+    }
+
+    SUBCASE("insert in the middle") {
+        SSOBytes s("head-tail");
+        std::string mid(30, 'm');
+        s.insert(5, mid.begin(), mid.end());
+        CHECK(std::string(s.begin(), s.end()) == "head-" + mid + "tail");
+
+        SSOBytes t(std::string(SSOBytes::SSO_CAPACITY, 'a'));
+        t.insert(0, 'z');
+        CHECK(! t.is_sso());
+        CHECK(t.front() == 'z');
+        CHECK(t.size() == SSOBytes::SSO_CAPACITY + 1);
+    }
+
+    SUBCASE("resize and reserve are exact") {
+        SSOBytes s("ab");
+        s.resize(100, 'c');
+        CHECK(s.capacity() == 100);
+        CHECK(s[0] == 'a');
+        CHECK(s[99] == 'c');
+
+        SSOBytes r("keep");
+        r.reserve(77);
+        CHECK(r.capacity() == 77);
+        CHECK(std::string(r.begin(), r.end()) == "keep");
+    }
+
+    SUBCASE("assign large range") {
+        SSOBytes s("old");
+        std::string big(60, 'n');
+        s.assign(big.begin(), big.end());
+        CHECK(! s.is_sso());
+        CHECK(std::string(s.begin(), s.end()) == big);
+    }
+}
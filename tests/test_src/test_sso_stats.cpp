@@ -0,0 +1,124 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define KASTRING_SSO_STATS
+#include <string>
+#include <thread>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+TEST_CASE("stats are enabled by the macro") {
+    CHECK(SSOStats::enabled());
+}
+
+TEST_CASE("SSO-only traffic does not touch the heap") {
+    SSOStats::reset();
+    {
+        SSOBytes s("short");
+        s.append(" text");
+        s.insert(0, '>');
+        s.resize(12, '!');
+        SSOBytes copy(s);
+        CHECK(copy.is_sso());
+    }
+    SSOStats st = SSOStats::thread_snapshot();
+    CHECK(st.total().promotions == 0);
+    CHECK(st.total().allocations == 0);
+    CHECK(st.total().bytes_allocated == 0);
+}
+
+TEST_CASE("append overflowing SSO is counted as a promotion") {
+    SSOStats::reset();
+    {
+        SSOBytes s("0123456789");
+        s.append(std::string(40, 'x'));
+        CHECK(! s.is_sso());
+
+        SSOStats st = SSOStats::thread_snapshot();
+        const SSOOpStats& app = st[SSOOp::Append];
+        CHECK(app.promotions == 1);
+        CHECK(app.allocations == 1);
+        CHECK(app.reallocations == 0); // 升级时直接按最终长度分配, 不再先拷贝再扩容
+        CHECK(app.bytes_allocated >= 50);
+        CHECK(st.live_bytes() == static_cast<std::int64_t>(s.heap_bytes()));
+    }
+    SSOStats st = SSOStats::thread_snapshot();
+    CHECK(st.live_bytes() == 0);
+    CHECK(st.total().bytes_freed == st.total().bytes_allocated);
+    CHECK(st.peak_live_bytes >= 50);
+}
+
+TEST_CASE("growth on the heap is counted as reallocation") {
+    SSOBytes s(std::string(100, 'a'));
+    SSOStats::reset();
+    s.shrink_to_fit();
+    const std::size_t before = s.capacity();
+    for (std::size_t i = 0; i < before + 1; ++i) s.push_back('b');
+
+    SSOStats st = SSOStats::thread_snapshot();
+    CHECK(st[SSOOp::Append].promotions == 0);
+    CHECK(st[SSOOp::Append].allocations == 0);
+    CHECK(st[SSOOp::Append].reallocations >= 1);
+    CHECK(st[SSOOp::Append].bytes_freed > 0);
+}
+
+TEST_CASE("per-operation breakdown") {
+    SSOStats::reset();
+    SSOBytes a;
+    a.reserve(64);
+    SSOBytes b;
+    b.resize(64, 'r');
+    SSOBytes c("ab");
+    std::string big(64, 'i');
+    c.insert(1, big.begin(), big.end());
+    SSOBytes e(big.c_str(), big.size());
+    SSOBytes d(e);
+
+    SSOStats st = SSOStats::thread_snapshot();
+    CHECK(st[SSOOp::Reserve].promotions == 1);
+    CHECK(st[SSOOp::Reserve].allocations == 1);
+    CHECK(st[SSOOp::Resize].allocations == 1);
+    CHECK(st[SSOOp::Insert].allocations == 1);
+    CHECK(st.total().reallocations == 0);
+    CHECK(st[SSOOp::Resize].promotions == 1);
+    CHECK(st[SSOOp::Insert].promotions == 1);
+    CHECK(st[SSOOp::Copy].allocations == 1);
+    CHECK(st[SSOOp::Copy].promotions == 0);
+    CHECK(st[SSOOp::Construct].allocations == 1);
+    CHECK(st[SSOOp::Construct].bytes_allocated == 64);
+    CHECK(st.total().promotions == 3);
+}
+
+TEST_CASE("KAString traffic is visible") {
+    SSOStats::reset();
+    KAString s("hello");
+    for (int i = 0; i < 10; ++i) s += " world";
+    CHECK(SSOStats::thread_snapshot()[SSOOp::Append].promotions == 1);
+    // 5 + 10 * 6 = 65 字节: 一次升级到 48, 之后只需按倍数扩容一次
+    CHECK(SSOStats::thread_snapshot()[SSOOp::Append].allocations == 1);
+    CHECK(SSOStats::thread_snapshot()[SSOOp::Append].reallocations == 1);
+}
+
+TEST_CASE("global snapshot aggregates threads, including exited ones") {
+    SSOStats::reset();
+    std::thread t([]() {
+        SSOBytes s("x");
+        s.append(std::string(100, 'y'));
+        SSOStats mine = SSOStats::thread_snapshot();
+        if (mine[SSOOp::Append].promotions != 1) throw std::runtime_error("thread stats wrong");
+    });
+    t.join();
+
+    SSOStats local = SSOStats::thread_snapshot();
+    CHECK(local.total().promotions == 0);
+
+    SSOStats global = SSOStats::global_snapshot();
+    CHECK(global[SSOOp::Append].promotions == 1);
+    CHECK(global.total().bytes_allocated >= 101);
+    CHECK(global.peak_live_bytes >= 101);
+
+    SSOStats::reset();
+    global = SSOStats::global_snapshot();
+    CHECK(global.total().promotions == 0);
+    CHECK(global.total().bytes_allocated == 0);
+}
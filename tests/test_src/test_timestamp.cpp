@@ -0,0 +1,159 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <random>
+#include <string>
+#include <doctest/doctest.h>
+#include "../../include/kastring/kastring.hpp"
+
+using namespace kastring;
+
+namespace {
+typedef std::chrono::system_clock Clock;
+
+Clock::time_point at(std::int64_t secs, std::int64_t ns = 0) {
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(secs))
+                             + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+std::string format(const Clock::time_point& tp, TimestampZone zone = TimestampZone::Utc, int frac = 0) {
+    KAString out;
+    format_timestamp_to(out, tp, zone, frac);
+    return out;
+}
+
+std::int64_t secs_of(const Clock::time_point& tp) {
+    return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count());
+}
+} // namespace
+
+TEST_CASE("timestamp format") {
+    CHECK(format(at(0)) == "1970-01-01T00:00:00Z");
+    CHECK(format(at(951782400)) == "2000-02-29T00:00:00Z");
+    CHECK(format(at(1700000000, 123456789), TimestampZone::Utc, 3) == "2023-11-14T22:13:20.123Z");
+    CHECK(format(at(1700000000, 123456789), TimestampZone::Utc, 9) == "2023-11-14T22:13:20.123456789Z");
+    CHECK(format(at(1700000000, 5), TimestampZone::Utc, 12) == "2023-11-14T22:13:20.000000005Z");
+    // 负的时间点向下取整
+    CHECK(format(at(-1, 500000000), TimestampZone::Utc, 1) == "1969-12-31T23:59:59.5Z");
+    CHECK(format(at(-86400 * 365)) == "1969-01-01T00:00:00Z");
+
+    // 本地时间与 localtime 一致
+    const std::time_t t = 1700000000;
+    std::tm tm_buf;
+    localtime_r(&t, &tm_buf);
+    char expect[32];
+    std::strftime(expect, sizeof(expect), "%Y-%m-%dT%H:%M:%S", &tm_buf);
+    const std::string local = format(Clock::from_time_t(t), TimestampZone::Local);
+    CHECK(local.size() == 25);
+    CHECK(local.substr(0, 19) == expect);
+    CHECK((local[19] == '+' || local[19] == '-'));
+
+    char buf[TIMESTAMP_MAX_CHARS];
+    CHECK(format_timestamp(buf, at(0), TimestampZone::Local, 9) == TIMESTAMP_MAX_CHARS);
+}
+
+TEST_CASE("timestamp parse") {
+    ParseResult<Clock::time_point> r = parse_timestamp("2023-11-14T22:13:20Z");
+    REQUIRE(r.ok());
+    CHECK(secs_of(r.value) == 1700000000);
+    CHECK(r.consumed == 20);
+
+    CHECK(secs_of(parse_timestamp("2023-11-14 22:13:20").value) == 1700000000);
+    CHECK(secs_of(parse_timestamp("2023-11-14t22:13:20z").value) == 1700000000);
+    CHECK(secs_of(parse_timestamp("2023-11-15T06:13:20+08:00").value) == 1700000000);
+    CHECK(secs_of(parse_timestamp("2023-11-14T17:43:20-04:30").value) == 1700000000);
+    CHECK(secs_of(parse_timestamp("1969-12-31T23:59:59Z").value) == -1);
+    CHECK(secs_of(parse_timestamp("2000-02-29T00:00:00Z").value) == 951782400);
+
+    SUBCASE("fraction") {
+        r = parse_timestamp("2023-11-14T22:13:20.123456789Z");
+        REQUIRE(r.ok());
+        CHECK(std::chrono::duration_cast<std::chrono::nanoseconds>(r.value.time_since_epoch()).count()
+              == 1700000000123456789LL);
+        r = parse_timestamp("2023-11-14T22:13:20,5Z");
+        CHECK(std::chrono::duration_cast<std::chrono::milliseconds>(r.value.time_since_epoch()).count()
+              == 1700000000500LL);
+        // 超过 9 位的小数截断
+        r = parse_timestamp("2023-11-14T22:13:20.1234567891234567891234Z");
+        REQUIRE(r.ok());
+        CHECK(std::chrono::duration_cast<std::chrono::nanoseconds>(r.value.time_since_epoch()).count()
+              == 1700000000123456789LL);
+    }
+
+    SUBCASE("leap second rolls over") {
+        CHECK(secs_of(parse_timestamp("2016-12-31T23:59:60Z").value) == 1483228800);
+    }
+
+    SUBCASE("invalid") {
+        CHECK(parse_timestamp("").error == ParseError::Empty);
+        r = parse_timestamp("2023-11-14");
+        CHECK(r.error == ParseError::InvalidChar);
+        CHECK(r.consumed == 10);
+        r = parse_timestamp("2023/11-14T22:13:20Z");
+        CHECK(r.error == ParseError::InvalidChar);
+        CHECK(r.consumed == 4);
+        r = parse_timestamp("2023-11-14T22:1x:20Z");
+        CHECK(r.consumed == 15);
+        r = parse_timestamp("2023-13-14T22:13:20Z");
+        CHECK(r.error == ParseError::InvalidChar);
+        CHECK(r.consumed == 5);
+        CHECK(parse_timestamp("2023-02-29T00:00:00Z").consumed == 8);
+        CHECK(parse_timestamp("1900-02-29T00:00:00Z").consumed == 8);
+        CHECK(parse_timestamp("2023-11-14T24:00:00Z").consumed == 11);
+        CHECK(parse_timestamp("2023-11-14T23:60:00Z").consumed == 14);
+        CHECK(parse_timestamp("2023-11-14T23:00:61Z").consumed == 17);
+        r = parse_timestamp("2023-11-14T22:13:20.Z");
+        CHECK(r.error == ParseError::InvalidChar);
+        CHECK(r.consumed == 20);
+        CHECK(parse_timestamp("2023-11-14T22:13:20+0800").consumed == 19);
+        CHECK(parse_timestamp("2023-11-14T22:13:20+24:00").consumed == 20);
+        r = parse_timestamp("2023-11-14T22:13:20Z trailing");
+        CHECK(r.error == ParseError::InvalidChar);
+        CHECK(r.consumed == 20);
+    }
+
+    SUBCASE("lenient") {
+        r = parse_timestamp("  2023-11-14T22:13:20Z trailing", TimestampZone::Utc, ParseMode::Lenient);
+        REQUIRE(r.ok());
+        CHECK(secs_of(r.value) == 1700000000);
+        CHECK(r.consumed == 22);
+    }
+
+    SUBCASE("out of range") {
+        r = parse_timestamp("9999-12-31T23:59:59Z");
+        const std::int64_t max_secs = secs_of(Clock::time_point::max());
+        if (max_secs < 253402300799LL) {
+            CHECK(r.error == ParseError::Overflow);
+            CHECK(r.value == Clock::time_point::max());
+        } else {
+            CHECK(secs_of(r.value) == 253402300799LL);
+        }
+    }
+}
+
+TEST_CASE("timestamp local zone") {
+    const Clock::time_point tp = at(1700000000);
+    const std::string local = format(tp, TimestampZone::Local);
+    // 带偏移的本地时间解析回同一时刻
+    CHECK(secs_of(parse_timestamp(KAStr(local.c_str())).value) == 1700000000);
+    // 去掉偏移后按本地时区解释
+    CHECK(secs_of(parse_timestamp(KAStr(local.substr(0, 19).c_str()), TimestampZone::Local).value) == 1700000000);
+}
+
+TEST_CASE("timestamp round trip") {
+    std::mt19937_64 rng(48);
+    for (int iter = 0; iter < 2000; ++iter) {
+        // 0001 年到 9999 年之间且 system_clock 能表示的任意时刻
+        const std::int64_t lo = std::max<std::int64_t>(-62135596800LL, secs_of(Clock::time_point::min()) + 1);
+        const std::int64_t hi = std::min<std::int64_t>(253402300799LL, secs_of(Clock::time_point::max()) - 1);
+        const std::int64_t secs = lo + static_cast<std::int64_t>(rng() % static_cast<std::uint64_t>(hi - lo));
+        const std::int64_t ns = static_cast<std::int64_t>(rng() % 1000000000ULL);
+        const Clock::time_point tp = at(secs, ns);
+        const std::string text = format(tp, iter % 2 == 0 ? TimestampZone::Utc : TimestampZone::Local, 9);
+        const ParseResult<Clock::time_point> r = parse_timestamp(KAStr(text.c_str()));
+        REQUIRE(r.ok());
+        CHECK(r.value == tp);
+    }
+}